@@ -29,17 +29,14 @@ public:
                  double callBarrier, double protectionBarrier,
                  double airbagFloor);
 
-  /**
-   * @brief Calculates the discounted payoff for a given path.
-   *
-   * @param path Simulated price path of the underlying.
-   * @param riskFreeRate The risk free interest rate.
-   * @return double The total discounted payoff.
-   */
-  double discountedPayoff(const std::vector<double> &path,
-                          double riskFreeRate) const override;
+  // Protection barrier, and the spot below which the floor applies.
+  std::vector<double> redemptionBreakpoints() const override;
 
 private:
+  // Unsmoothed payoff of a path, recording its life in `events` when given.
+  double payoff(PathView path, const double *discountFactors,
+                LifeEvents *events) const override;
+
   /**
    * @brief Overrides the terminal redemption calculation to implement the
    * Airbag logic.
@@ -54,6 +51,8 @@ private:
    * @return The redemption amount.
    */
   double terminalRedemption(double spotT) const override;
+  // Same airbag floor once a monitored barrier has been breached.
+  double knockedInRedemption(double spotT) const override;
 
   double
       airbagFloor_{}; // Factor to determine the Airbag Strike (e.g., 0.6, 0.7)
@@ -1,5 +1,6 @@
 #pragma once
 #include "StructuredProduct.hpp"
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -20,8 +21,25 @@ public:
   double protectionBarrier() const { return protectionBarrier_; }
   double spot0() const { return spot0_; }
 
-protected:
-  const std::vector<double> &times() const { return observationTimes(); }
+  /**
+   * @brief Terms applied at one observation date.
+   *
+   * Describes the discretely monitored payoff independently of the path, so
+   * that grid engines can apply it as a jump condition.
+   */
+  struct ObservationRule {
+    double callBarrier;   // Autocall if spot >= callBarrier.
+    double callAmount;    // Cash paid on autocall (conditional coupon apart).
+    double couponBarrier; // Conditional coupon if spot >= couponBarrier.
+    double couponAmount;  // Conditional coupon per period (0 if none).
+    bool memory;          // Missed coupons are accrued and paid later.
+  };
+
+  /**
+   * @brief Observation terms at date index i (default: autocall paying
+   * Notional * (1 + Coupon), no conditional coupon).
+   */
+  virtual ObservationRule observationRule(std::size_t i) const;
 
   /**
    * @brief Calculates the terminal redemption amount at maturity.
@@ -30,10 +48,107 @@ protected:
    */
   virtual double terminalRedemption(double finalSpot) const;
 
+  /**
+   * @brief Redemption at maturity once the protection barrier has been
+   * breached during the life of the note (default: Notional * min(1, S_T /
+   * S_0)). Only used when the barrier is not monitored at maturity alone.
+   */
+  virtual double knockedInRedemption(double finalSpot) const;
+
+  /**
+   * @brief Spots at which terminalRedemption jumps or has a kink (default:
+   * the protection barrier); between them it is linear in the final spot.
+   * Quadrature engines split their integrals there.
+   */
+  virtual std::vector<double> redemptionBreakpoints() const;
+
+  /**
+   * @brief How the protection barrier is monitored (default: AtMaturity,
+   * i.e. on the final spot only).
+   */
+  void setProtectionMonitoring(BarrierMonitoring monitoring) {
+    protectionMonitoring_ = monitoring;
+  }
+  BarrierMonitoring protectionMonitoring() const {
+    return protectionMonitoring_;
+  }
+  bool needsBridge() const override {
+    return protectionMonitoring_ != BarrierMonitoring::AtMaturity;
+  }
+
+  /**
+   * @brief Expected redemption of a path that reaches maturity.
+   *
+   * AtMaturity: terminalRedemption of the final spot. Daily and Continuous:
+   * the barrier may have been breached between two simulated dates. Given the
+   * simulated spots, log(S) on each interval is a Brownian bridge, which
+   * crosses a barrier B below both ends with probability
+   *   p = exp(-2 log(S_a / B) log(S_b / B) / w),
+   * w being the variance of log(S) over the interval. With q the probability
+   * of a breach on any interval, the redemption is
+   *   (1 - q) * terminalRedemption(S_T) + q * knockedInRedemption(S_T),
+   * the exact conditional expectation under Black-Scholes: the knock-in is
+   * monitored at the cost of the observation grid. Daily monitoring uses the
+   * continuity correction of Broadie, Glasserman and Kou (barrier shifted by
+   * exp(-0.5826 sigma sqrt(1 / 252))).
+   *
+   * @throws std::runtime_error if the barrier is monitored during the life
+   * of the note and the path carries no bridge data.
+   */
+  double maturityRedemption(PathView path) const;
+
+  /**
+   * @brief Replaces the barrier digitals (autocall, coupon and, at maturity,
+   * protection) by call spreads of the given width, relative to each
+   * barrier (0: exact payoff).
+   *
+   * The spread is centred on the barrier, so the price moves by O(width^2)
+   * while bumped deltas no longer jump when a path crosses a barrier.
+   */
+  void setBarrierSmoothing(double width) { barrierSmoothing_ = width; }
+  double barrierSmoothing() const { return barrierSmoothing_; }
+
+  // smoothedPayoff() when barrierSmoothing() > 0, payoff() otherwise. Final:
+  // products customise payoff() instead.
+  double discountedPayoff(PathView path,
+                          const double *discountFactors) const final;
+  double discountedPayoff(PathView path, const double *discountFactors,
+                          LifeEvents &events) const final;
+
+protected:
+  const std::vector<double> &times() const { return observationTimes(); }
+
+  /**
+   * @brief Payoff of a path with exact barriers, recording in `events`, when
+   * given, the date the note ends and the coupons it pays.
+   */
+  virtual double payoff(PathView path, const double *discountFactors,
+                        LifeEvents *events) const = 0;
+
+  /**
+   * @brief Payoff with smoothed barriers, built from observationRule() and
+   * the redemption at maturity.
+   *
+   * Each date pays its flows weighted by the probability-like weight of the
+   * note still being alive; a call spread weight a_i in [0, 1] replaces the
+   * autocall test and the alive weight is multiplied by (1 - a_i). Unpaid
+   * memory coupons are carried fractionally. discountedPayoff() returns it
+   * instead of payoff() when barrierSmoothing() > 0. With `events`, records
+   * the call and coupon weights of each date and the alive weight left at
+   * maturity.
+   */
+  double smoothedPayoff(PathView path, const double *discountFactors,
+                        LifeEvents *events = nullptr) const;
+
 private:
   double notional_;
   double couponRate_;
   double callBarrier_;
   double protectionBarrier_;
   double spot0_;
+  BarrierMonitoring protectionMonitoring_{BarrierMonitoring::AtMaturity};
+  double barrierSmoothing_{0.0};
+
+  // Call-spread weight of {spot >= barrier}.
+  double smoothStep(double spot, double barrier) const;
 };
\ No newline at end of file
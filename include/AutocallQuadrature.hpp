@@ -0,0 +1,62 @@
+#pragma once
+
+#include "AutocallBase.hpp"
+#include "DiscountCurve.hpp"
+
+/**
+ * @brief Deterministic Black-Scholes pricer for autocalls whose spot is only
+ * tested against the autocall barrier before maturity (SimpleAutocall,
+ * StepDownAutocall, AirbagAutocall, and Phoenix or term-sheet notes whose
+ * coupon barrier is not below the autocall barrier).
+ *
+ * The price is the sum over the dates of the amounts paid on a first call
+ * at t_i, weighted by P(X_1 < b_1, ..., X_{i-1} < b_{i-1}, X_i >= b_i), plus
+ * the redemption of the paths never called: orthant probabilities of the
+ * Gaussian random walk X_i = log S(t_i). Since the walk is Markov they are
+ * computed by backward induction on log-spot rather than by multivariate
+ * normal integration: the value left below the barrier at date i,
+ *   C_i(x) = E[V_{i+1}(x + m_{i+1} + s_{i+1} Z)],
+ * is carried on a uniform grid whose top node sits exactly on the barrier
+ * (trapezoid rule, Toeplitz kernel); above the barrier the value is
+ * constant and its integral is a Gaussian tail. The last step integrates
+ * the redemption in closed form, piece by piece between
+ * redemptionBreakpoints() (digitals and asset-or-nothing pieces). Grids of
+ * step h and 2h are combined by Richardson extrapolation.
+ *
+ * Delta and gamma are exact derivatives of the first step in the spot. The
+ * vega is the exact derivative in sigma of the quadrature on its grid: the
+ * induction carries dC_i/dsigma alongside C_i, through the transition
+ * kernel and the Gaussian tails differentiated in sigma (the grid layout
+ * itself is held fixed). Missed memory coupons can only be paid on a call
+ * here, so their amount is known at each date.
+ */
+class AutocallQuadrature {
+public:
+  struct Result {
+    double price{};
+    double delta{};
+    double gamma{};
+    double vega{};
+  };
+
+  explicit AutocallQuadrature(double sigma);
+
+  /**
+   * @brief Whether price() handles the product: protection observed at
+   * maturity, exact barriers, no coupon barrier below the autocall
+   * barrier, and increasing positive observation times.
+   */
+  static bool supports(const AutocallBase &product);
+
+  /**
+   * @param elapsed Time already elapsed since the valuation date: every
+   * observation time is moved back by it (for theta).
+   * @throws std::runtime_error if !supports(product), for a non-positive
+   * spot or vol, or a date reached by the time shift.
+   */
+  Result price(const AutocallBase &product, double spot,
+               const DiscountCurve &curve, double elapsed = 0.0) const;
+
+private:
+  double sigma_;
+};
@@ -7,7 +7,7 @@
  *
  * This class implements a path generator based on the Black-Scholes-Merton model.
  * It assumes the underlying asset follows a Geometric Brownian Motion (GBM)
- * with constant volatility and a constant risk-free rate.
+ * with constant volatility; the risk-free drift follows the discount curve.
  */
 class BlackScholesMC : public PathModelBase {
 public:
@@ -19,25 +19,33 @@ public:
     explicit BlackScholesMC(double sigma);
 
     /**
-     * @brief Simulates a single price path using Geometric Brownian Motion.
+     * @brief One normal per observation interval (none for zero-length ones).
+     */
+    std::size_t normalCount(const TimeGrid& grid) const override;
+
+    /**
+     * @brief Builds a price path using Geometric Brownian Motion.
      *
      * The evolution of the spot price is given by:
-     * dS_t = S_t * r * dt + S_t * sigma * dW_t
+     * dS_t = S_t * r(t) * dt + S_t * sigma * dW_t
      *
      * In the discretized simulation:
-     * S_{t+dt} = S_t * exp((r - 0.5 * sigma^2) * dt + sigma * sqrt(dt) * Z)
-     * where Z is a standard normal random variable.
+     * S_{t+dt} = S_t * exp(int r - 0.5 * sigma^2 * dt + sigma * sqrt(dt) * Z)
+     * where Z is a standard normal random variable and int r is the
+     * integrated short rate of the interval (grid.logGrowth). The interval
+     * variances are sigma^2 * dt.
      *
      * @param spot0 The initial spot price of the underlying.
-     * @param times A vector of time points (in years) where the spot price is observed.
-     * @param data Market data providing the risk-free rate (r).
-     * @param rng The random number generator (Mersenne Twister) used to generate Z.
-     * @return std::vector<double> The simulated spot prices at each requested time in 'times'.
+     * @param grid Observation times (in years) with the sampled discount curve.
+     * @param normals The normals Z of the non-empty intervals.
+     * @param path Receives the simulated spot prices at each grid time.
+     * @param intervalVariance Optional output (see PathModelBase).
      */
-    std::vector<double> simulatePath(double spot0,
-                                     const std::vector<double>& times,
-                                     const MarketData& data,
-                                     std::mt19937& rng) const override;
+    void buildPath(double spot0,
+                   const TimeGrid& grid,
+                   const double* normals,
+                   std::vector<double>& path,
+                   double* intervalVariance) const override;
 
 private:
     double sigma_; // stored constant volatility
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "AutocallBase.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Discretisation settings of the finite-difference engines.
+ */
+struct PdeSettings {
+  std::size_t spotNodes{400};       // Nodes of the spot grid.
+  std::size_t stepsPerYear{250};    // Time steps per year of maturity.
+  std::size_t minStepsPerPeriod{8}; // Floor between two observation dates.
+  std::size_t rannacherSteps{2};    // CN steps replaced by implicit halves.
+};
+
+/**
+ * @brief Crank-Nicolson pricer for the AutocallBase family under
+ * Black-Scholes (constant volatility and rate).
+ *
+ * The price is obtained by backward induction on a spot grid concentrated
+ * around the spot and the barriers. At each observation date the product's
+ * ObservationRule is applied as a jump condition (autocall, conditional
+ * coupon, terminal redemption). Memory coupons add a state dimension: one
+ * grid per number of unpaid coupons. After every jump the first time steps
+ * are taken with implicit Euler half-steps (Rannacher smoothing) so that
+ * the barrier discontinuities do not pollute delta and gamma.
+ */
+class BlackScholesPde {
+public:
+  struct Result {
+    double price{};
+    double delta{};
+    double gamma{};
+  };
+
+  /**
+   * @param sigma Constant volatility.
+   * @param settings Grid and time-stepping settings.
+   */
+  explicit BlackScholesPde(double sigma, PdeSettings settings = PdeSettings());
+
+  /**
+   * @brief Prices the product at the given spot and flat rate.
+   * @throws std::runtime_error if the product has no observation dates.
+   */
+  Result price(const AutocallBase &product, double spot, double rate) const;
+
+private:
+  double sigma_;
+  PdeSettings settings_;
+};
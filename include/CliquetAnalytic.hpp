@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CliquetBase.hpp"
+#include "DiscountCurve.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Closed-form and quadrature pricer for the cliquets when the period
+ * returns are independent lognormals (Black-Scholes with deterministic
+ * rates, possibly with one vol per period).
+ *
+ * Period k (from t_{k-1} to t_k, t_0 = 0) has the return R_k = S_k / S_{k-1}
+ * with forward F_k = DF(t_{k-1}) / DF(t_k) and log-vol s_k = vol_k sqrt(dt_k);
+ * the first one is measured from the fixing, R_1 = (S / S_0) X_1.
+ *
+ * CliquetCappedCoupons: each coupon is a call spread on its period return,
+ *   min(max(p (R - 1), 0), c) = p [(R - 1)^+ - (R - 1 - c / p)^+],
+ * so the price is DF(T) N (1 + sum of Black call spreads), with exact
+ * delta, gamma (first period only) and vega.
+ *
+ * CliquetMaxReturn: pays N (max(1, max_k S_k / S_0) - 1). Writing
+ * log(S_k / S_0) = log(S / S_0) + Y_1 + ... + Y_k, the running maximum
+ * after the first date follows the Lindley recursion
+ *   V_{n+1} = 0,   V_k = max(0, Y_k + V_{k+1}),
+ * and the payoff is N (S / S_0 e^{Y_1 + V_2} - 1)^+, a Black call on
+ * e^{Y_1} given V_2. The law of V_2 (an atom at 0 plus a density) is
+ * carried backwards on a uniform grid, each step a convolution with the
+ * Gaussian of Y_k (trapezoid rule, Toeplitz kernel tabulated once per
+ * period), then integrated against the call; grids of step h and 2h are
+ * combined by Richardson extrapolation. Delta and gamma come with the
+ * call; vega is a central difference of the (deterministic) quadrature.
+ */
+class CliquetAnalytic {
+public:
+  struct Result {
+    double price{};
+    double delta{};
+    double gamma{};
+    double vega{}; // dV / dvol for a parallel shift of every period vol.
+  };
+
+  /**
+   * @param periodVols Vol of each period; a single value applies to all.
+   */
+  explicit CliquetAnalytic(std::vector<double> periodVols);
+
+  /**
+   * @param elapsed Time already elapsed since the valuation date: every
+   * observation time is moved back by it (clamped at 0), for theta.
+   * @throws std::runtime_error for other cliquets, a non-positive fixing,
+   * or (MaxReturn) a period after the first with zero variance.
+   */
+  Result price(const CliquetBase &product, double spot,
+               const DiscountCurve &curve, double elapsed = 0.0) const;
+
+  // Largest quadrature grid of the MaxReturn recursion.
+  static constexpr std::size_t kMaxGridPoints = 4096;
+
+private:
+  std::vector<double> periodVols_;
+};
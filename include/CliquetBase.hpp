@@ -9,16 +9,21 @@ public:
               double spot0, double notional);
 
   // Adaptation : Les cliquets renvoient un flux unique via discountedPayoff
-  double discountedPayoff(const std::vector<double> &path,
-                          double riskFreeRate) const override final;
+  using StructuredProduct::discountedPayoff;
+  double discountedPayoff(PathView path,
+                          const double *discountFactors) const override final;
+
+  // Payoff earned on the first dates of the path (paid on an issuer call).
+  double accruedPayoff(PathView prefix) const { return payoffImpl(prefix); }
 
-protected:
-  const std::vector<double> &times() const { return observationTimes(); }
   double spot0() const { return spot0_; }
   double notional() const { return notional_; }
 
+protected:
+  const std::vector<double> &times() const { return observationTimes(); }
+
   // Méthode interne pour calculer le montant final
-  virtual double payoffImpl(const std::vector<double> &path) const = 0;
+  virtual double payoffImpl(PathView path) const = 0;
 
 private:
   double spot0_{};
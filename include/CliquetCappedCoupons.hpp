@@ -11,8 +11,11 @@ public:
                          double participation,
                          double cap);
 
+    double participation() const { return participation_; }
+    double cap() const { return cap_; }
+
 protected:
-    double payoffImpl(const std::vector<double>& path) const override;
+    double payoffImpl(PathView path) const override;
 
 private:
     double participation_{};
@@ -11,5 +11,5 @@ public:
 
 protected:
     // On implémente la logique spécifique ici, appelée par CliquetBase::cashFlows
-    double payoffImpl(const std::vector<double>& path) const override;
+    double payoffImpl(PathView path) const override;
 };
\ No newline at end of file
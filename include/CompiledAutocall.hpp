@@ -0,0 +1,103 @@
+#pragma once
+#include "AutocallBase.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Values a term sheet may leave out, taken from the pricing inputs.
+ */
+struct TermSheetDefaults {
+  std::string underlying;
+  double initialFixing{};
+  double notional{};
+  std::vector<double> observationTimes;
+  BarrierMonitoring monitoring{BarrierMonitoring::AtMaturity};
+};
+
+/**
+ * @brief Autocall described by a declarative term sheet and evaluated from
+ * per-date tables.
+ *
+ * Term sheet (JSON; levels relative to the initial fixing, amounts as
+ * fractions of the notional; a schedule is a number or one value per date,
+ * null meaning "none at that date"):
+ *
+ *   {
+ *     "underlying": "SPX", "initialFixing": 4000, "notional": 1000,
+ *     "observationTimes": [0.25, 0.5, 0.75, 1.0],
+ *     "autocall": {"barrier": [1.0, 0.95, 0.9, 0.85],
+ *                  "redemption": 1.0, "coupon": 0.0},
+ *     "coupon": {"rate": 0.05, "barrier": 0.8, "memory": true},
+ *     "protection": {"barrier": 0.7, "floor": 0.6,
+ *                    "monitoring": "maturity" | "daily" | "continuous"}
+ *   }
+ *
+ * Every member is optional: the underlying, fixing, notional, dates and
+ * monitoring default to the TermSheetDefaults, a sheet without "autocall"
+ * is never called and one without "protection" protects the capital. At
+ * date i the note pays the conditional coupon when S >= coupon barrier
+ * (with the coupons missed since the last payment under memory), then
+ * redeems notional * (redemption + autocall coupon) when S >= autocall
+ * barrier. At maturity it redeems the notional above the protection
+ * barrier, and notional * max(S / S0, floor) below. The five hand-written
+ * autocalls are special cases: SimpleAutocall is {"autocall": {"barrier":
+ * b, "coupon": c}}, a step-down has a barrier schedule, a Phoenix adds
+ * "coupon", an Airbag "floor".
+ *
+ * The compiled form is a set of per-date tables (the ObservationRule of
+ * each date) walked by a loop without per-product branches, so grid
+ * engines, Longstaff-Schwartz and the bridged knock-in see it like any
+ * other autocall. discountedPayoffs() evaluates a date-major batch date by
+ * date with 0/1 masks instead of early exits, which the compiler
+ * vectorises across paths.
+ */
+class CompiledAutocall : public AutocallBase {
+public:
+  /**
+   * @brief Parses and validates a term sheet.
+   * @throws std::runtime_error("TermSheet: ...") on malformed JSON, unknown
+   * members, schedules of the wrong length or memory coupons whose amount
+   * changes between dates (the carried state counts coupons).
+   */
+  static std::unique_ptr<CompiledAutocall>
+  fromTermSheet(const std::string &text, const TermSheetDefaults &defaults);
+
+  void discountedPayoffs(const double *spots, std::size_t count,
+                         const double *discountFactors,
+                         double *out) const override;
+  // Bridged and smoothed terms fall back to the per-path evaluation.
+  bool hasBatchKernel() const override {
+    return !needsBridge() && barrierSmoothing() <= 0.0;
+  }
+  ObservationRule observationRule(std::size_t i) const override;
+  std::vector<double> redemptionBreakpoints() const override;
+
+  double redemptionFloor() const { return floor_; }
+
+private:
+  // Unsmoothed payoff of a path, recording its life in `events` when given.
+  double payoff(PathView path, const double *discountFactors,
+                LifeEvents *events) const override;
+
+  // Per-date tables, in absolute levels and cash amounts.
+  struct Schedule {
+    std::vector<double> callBarrier;   // +inf: not callable at that date.
+    std::vector<double> callAmount;
+    std::vector<double> couponBarrier; // +inf: no coupon at that date.
+    std::vector<double> couponAmount;
+    bool memory{false};
+  };
+
+  CompiledAutocall(std::string underlying, std::vector<double> observationTimes,
+                   double spot0, double notional, double protectionBarrier,
+                   double floor, Schedule schedule);
+
+  double terminalRedemption(double finalSpot) const override;
+  double knockedInRedemption(double finalSpot) const override;
+
+  double floor_; // Minimum redemption below the barrier, in notionals.
+  Schedule schedule_;
+};
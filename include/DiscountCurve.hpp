@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief Zero-coupon discount curve built from zero-rate pillars.
+ *
+ * log DF(t) is interpolated linearly between pillars (piecewise-constant
+ * forward rates), with a flat zero rate before the first pillar and the last
+ * forward rate beyond the last one. A single pillar gives a flat curve.
+ */
+class DiscountCurve {
+public:
+  /**
+   * @brief Flat curve: DF(t) = exp(-rate * t).
+   */
+  explicit DiscountCurve(double flatRate = 0.0);
+
+  /**
+   * @param pillarTimes Strictly increasing positive times (in years).
+   * @param zeroRates Continuously compounded zero rate at each pillar.
+   * @throws std::runtime_error on empty, mismatched or unsorted pillars.
+   */
+  DiscountCurve(std::vector<double> pillarTimes, std::vector<double> zeroRates);
+
+  double logDiscount(double t) const;
+  double discountFactor(double t) const;
+
+  /**
+   * @brief Continuously compounded zero rate at t (first pillar rate at 0).
+   */
+  double zeroRate(double t) const;
+
+  /**
+   * @brief Same curve with every zero rate shifted by a parallel amount.
+   */
+  DiscountCurve shifted(double shift) const;
+
+  bool isFlat() const { return pillarTimes_.size() == 1; }
+
+private:
+  std::vector<double> pillarTimes_;
+  std::vector<double> zeroRates_;
+  std::vector<double> logDiscounts_; // -zeroRates_[k] * pillarTimes_[k]
+};
+
+/**
+ * @brief Observation dates with the curve pre-sampled on them.
+ *
+ * Built once per pricing and shared by the path models (drift) and the
+ * payoffs (discounting), so no exp/log of the curve runs per path.
+ * Interval i goes from t_{i-1} (t_{-1} = 0) to t_i.
+ */
+struct TimeGrid {
+  TimeGrid(std::vector<double> times, const DiscountCurve &curve);
+
+  std::vector<double> times;
+  std::vector<double> dt;     // t_i - t_{i-1}, clamped at 0
+  std::vector<double> sqrtDt; // sqrt(dt)
+  // Integrated short rate over the interval: log(DF(t_{i-1}) / DF(t_i)).
+  std::vector<double> logGrowth;
+  // Average forward rate over the interval (logGrowth / dt, 0 if dt == 0).
+  std::vector<double> forwardRates;
+  std::vector<double> discountFactors; // DF(t_i)
+};
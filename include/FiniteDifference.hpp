@@ -0,0 +1,53 @@
+// Grid and linear-algebra helpers shared by the finite-difference engines.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Builds a non-uniform grid on [lo, hi] with nodes concentrated
+ * around the given critical points (spot, barriers).
+ *
+ * Node density is proportional to 1 + intensity * width / sqrt(width^2 +
+ * (x - c)^2) summed over the critical points. Each critical point is then
+ * moved to the middle of its cell, so that payoff discontinuities never sit
+ * on a node (second-order accuracy for digital conditions).
+ *
+ * @param nodes Number of nodes (>= 3), including both ends.
+ */
+std::vector<double> makeConcentratedGrid(double lo, double hi,
+                                         std::size_t nodes,
+                                         const std::vector<double> &points,
+                                         double width, double intensity = 4.0);
+
+/**
+ * @brief Three-point central-difference weights on a non-uniform grid.
+ *
+ * For interior node j: f'(x_j) ~ d1[0] f_{j-1} + d1[1] f_j + d1[2] f_{j+1},
+ * and likewise d2 for f''.
+ */
+struct Stencil {
+  double d1[3];
+  double d2[3];
+};
+
+std::vector<Stencil> makeStencils(const std::vector<double> &grid);
+
+/**
+ * @brief Solves a tridiagonal system in place (Thomas algorithm).
+ *
+ * lower[0] and upper[n-1] are ignored. rhs receives the solution; scratch
+ * must have the same size as rhs.
+ */
+void solveTridiagonal(const std::vector<double> &lower,
+                      const std::vector<double> &diag,
+                      const std::vector<double> &upper,
+                      std::vector<double> &rhs, std::vector<double> &scratch);
+
+/**
+ * @brief Quadratic interpolation of values on grid at x, with first and
+ * second derivatives (used to read price/delta/gamma at the spot).
+ */
+void interpolateQuadratic(const std::vector<double> &grid,
+                          const double *values, double x, double &value,
+                          double &first, double &second);
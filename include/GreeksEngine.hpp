@@ -0,0 +1,179 @@
+#pragma once
+
+#include "DiscountCurve.hpp"
+#include "PathModel.hpp"
+#include "StructuredProduct.hpp"
+
+#include <cstddef>
+#include <vector>
+
+class PayoffDistribution;
+
+struct GreeksBumps {
+  double spotFraction{0.005};     // Relative spot bump, up and down.
+  double vol{0.01};               // Vol shift of the volUp model.
+  // Vol shift (down) of the volDown model; 0 when the vol parameter is too
+  // small to be shifted down, volDown then being the base model (one-sided
+  // vega and vanna).
+  double volDown{0.01};
+  double rate{1e-4};              // Parallel zero-curve shift, up and down.
+  double timeShift{1.0 / 365.0};  // Valuation date move of theta (years).
+};
+
+struct GreeksEstimate {
+  double price{};
+  // Mean discounted payoff of the paths: the price before the control
+  // variate adjustment (the price itself without a control variate).
+  double payoffMean{};
+  double stdError{};
+  double delta{};
+  double gamma{};
+  double vega{};
+  double vanna{}; // d2V / dS dvol
+  double rho{};
+  double theta{}; // dV/dt per year of calendar time
+};
+
+/**
+ * @brief Control variate of the base price: a model building a second path
+ * from the normals of each base path, on which the product has a known
+ * price.
+ */
+struct ControlVariate {
+  const PathModelBase *model{};
+  double mean{}; // Exact price of the product under `model`.
+};
+
+/**
+ * @brief Optional statistics of the base scenario collected along a run,
+ * path by path, and merged into their current content block by block in
+ * order (so they do not depend on the number of threads).
+ */
+struct PathStatistics {
+  PayoffDistribution *distribution{}; // Discounted base payoff of each path.
+  // Calls, maturities and coupons of each path (discountedPayoff with
+  // events); must cover every observation date.
+  LifeEvents *events{};
+};
+
+/**
+ * @brief One-pass bumped Greeks on a single random stream.
+ *
+ * Each path draws its normals once (pathBlockRng block streams, so the
+ * base price is the one of a plain run) and builds four paths from them: the
+ * base path, the paths of the volUp and volDown models and the path on the
+ * date grid moved forward by bumps.timeShift. Every other scenario is a
+ * rescaling of those paths: all models simulate S_t / S_0 independently of
+ * the spot, so a spot bump scales a path, and a curve shift scales date i by
+ * DF(t_i) / DF'(t_i) (see RateScenario). The twelve scenario payoffs of a
+ * path are evaluated back to back, and the differences below share every
+ * draw:
+ *
+ *   delta = (V(S+) - V(S-)) / 2h          gamma = (V(S+) - 2V + V(S-)) / h^2
+ *   vega  = (V(v+) - V(v-)) / (du + dd)   vanna = (V(S+,v+) - V(S+,v-)
+ *   rho   = (V(r+) - V(r-)) / 2dr                  - V(S-,v+) + V(S-,v-))
+ *   theta = (V(t + dt) - V) / dt                   / 2h (du + dd)
+ *
+ * with du = bumps.vol and dd = bumps.volDown (dd = 0: one-sided in vol).
+ *
+ * Theta keeps the curve and the model fixed in time to maturity (the surface
+ * of a local vol model rolls with the valuation date). On the shorter grid
+ * the path consumes the normals of the base path minus the leading ones the
+ * first interval no longer needs, so the later intervals see the same draws.
+ *
+ * Compared with one Monte Carlo run per bumped scenario, the diffusion runs
+ * four times instead of nine and the random numbers are drawn once.
+ */
+class GreeksEngine {
+public:
+  /**
+   * @param volUp, volDown Model with its vol parameter (sigma, the implied
+   * surface or the Heston v0) shifted by +bumps.vol and -bumps.volDown. All
+   * three models must outlive the engine.
+   */
+  GreeksEngine(const PathModelBase &model, const PathModelBase &volUp,
+               const PathModelBase &volDown, GreeksBumps bumps = {});
+
+  /**
+   * @param control Optional control variate: the price becomes
+   * mean(V) - beta (mean(C) - control->mean) with the regression beta
+   * cov(V, C) / var(C), and the standard error the one of the residual.
+   * The Greeks are left uncontrolled (their differences already share the
+   * draws).
+   * @param statistics Optional per-path statistics of the base scenario.
+   */
+  GreeksEstimate run(const StructuredProduct &product, double spot,
+                     const DiscountCurve &curve, std::size_t paths,
+                     unsigned int seed,
+                     const ControlVariate *control = nullptr,
+                     PathStatistics statistics = {}) const;
+
+  /**
+   * @brief Estimates of several products on the same draws: every path and
+   * its bumped copies are built once and all the products are evaluated on
+   * them, so the diffusion cost is shared across the batch. Each estimate
+   * equals the one of run() for that product alone.
+   * @param statistics Empty, or the statistics of each product (see run()).
+   * @throws std::runtime_error if the products do not share one observation
+   * schedule.
+   */
+  std::vector<GreeksEstimate>
+  runBatch(const std::vector<const StructuredProduct *> &products, double spot,
+           const DiscountCurve &curve, std::size_t paths, unsigned int seed,
+           const std::vector<PathStatistics> &statistics = {}) const;
+
+  /**
+   * @brief Number of sums kept per path block: the run of one product is
+   * fully described by these values for each of its pathBlockCount(paths)
+   * blocks.
+   */
+  static constexpr std::size_t kBlockSumValues = 16;
+
+  /**
+   * @brief Sums of run() over path blocks [firstBlock, lastBlock) only,
+   * kBlockSumValues per block. Blocks draw from their own streams
+   * (pathBlockRng), so a run can be split in block ranges computed apart,
+   * in other threads or processes.
+   * @param statistics Optional statistics of the paths of the range, merged
+   * block by block in order (see run()).
+   * @throws std::runtime_error for a product without observation dates or
+   * a range beyond pathBlockCount(paths).
+   */
+  std::vector<double> blockSums(const StructuredProduct &product, double spot,
+                                const DiscountCurve &curve, std::size_t paths,
+                                unsigned int seed, std::size_t firstBlock,
+                                std::size_t lastBlock,
+                                const ControlVariate *control = nullptr,
+                                PathStatistics statistics = {}) const;
+
+  /**
+   * @brief Estimates from the block sums of every block of the run, in
+   * block order: bit-for-bit the result of run() with the same arguments,
+   * however the blocks were split.
+   * @throws std::runtime_error if `sums` does not hold pathBlockCount(paths)
+   * blocks.
+   */
+  GreeksEstimate fromBlockSums(const StructuredProduct &product,
+                               const std::vector<double> &sums, double spot,
+                               std::size_t paths,
+                               const ControlVariate *control = nullptr) const;
+
+private:
+  std::vector<GreeksEstimate>
+  simulate(const std::vector<const StructuredProduct *> &products, double spot,
+           const DiscountCurve &curve, std::size_t paths, unsigned int seed,
+           const std::vector<const ControlVariate *> &controls,
+           const std::vector<PathStatistics> &statistics) const;
+  std::vector<double>
+  sumBlocks(const std::vector<const StructuredProduct *> &products,
+            double spot, const DiscountCurve &curve, std::size_t paths,
+            unsigned int seed,
+            const std::vector<const ControlVariate *> &controls,
+            const std::vector<PathStatistics> &statistics,
+            std::size_t firstBlock, std::size_t lastBlock) const;
+
+  const PathModelBase &model_;
+  const PathModelBase &volUp_;
+  const PathModelBase &volDown_;
+  GreeksBumps bumps_;
+};
@@ -21,20 +21,31 @@ public:
     HestonMC(double v0, double kappa, double theta, double xi, double rho);
 
     /**
-     * @brief Simulates a path using the Heston model.
+     * @brief Two normals (spot, variance) per sub-step.
+     */
+    std::size_t normalCount(const TimeGrid& grid) const override;
+
+    /**
+     * @brief Builds a path using the Heston model.
      *
-     * Uses an Euler-Maruyama discretization (or similar scheme) for the coupled SDEs.
+     * Uses an Euler-Maruyama discretization (full truncation) for the coupled
+     * SDEs, with sub-steps of at most 0.01 year inside each interval. The
+     * interval variances are the integrated variance sum(v dt) over the
+     * sub-steps of each interval.
      *
      * @param spot0 Initial spot price.
-     * @param times Observation times required by the product.
-     * @param data Market data (risk-free rate, etc.).
-     * @param rng Random number generator.
-     * @return std::vector<double> The simulated path of the underlying asset.
+     * @param grid Observation times required by the product, with the
+     * discount curve sampled on them (the forward rate of each interval is
+     * used as drift for all its sub-steps).
+     * @param normals Two normals per sub-step (spot, then independent).
+     * @param path Receives the simulated path of the underlying asset.
+     * @param intervalVariance Optional output (see PathModelBase).
      */
-    std::vector<double> simulatePath(double spot0,
-                                     const std::vector<double>& times,
-                                     const MarketData& data,
-                                     std::mt19937& rng) const override;
+    void buildPath(double spot0,
+                   const TimeGrid& grid,
+                   const double* normals,
+                   std::vector<double>& path,
+                   double* intervalVariance) const override;
 
 private:
     double v0_;    // Initial variance
@@ -42,4 +53,43 @@ private:
     double theta_; // Long-term variance
     double xi_;    // Vol of vol
     double rho_;   // Correlation between spot and vol
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Black-Scholes paths driven by the spot normals of a HestonMC.
+ *
+ * Walks the same sub-steps as HestonMC and reads the same normals, but moves
+ * the spot with the deterministic vol of each interval,
+ * sqrt(E[integrated variance] / dt) under the CIR mean of v. The paths are
+ * strongly correlated with the Heston ones while their prices are known in
+ * closed form for the products priced by CliquetAnalytic, which makes them
+ * control variates of the Heston prices.
+ *
+ * The interval vols depend on the grid only, so they are computed once, for
+ * the grid given at construction; buildPath must be called with that grid.
+ */
+class HestonControlMC : public PathModelBase {
+public:
+    HestonControlMC(double v0, double kappa, double theta,
+                    const TimeGrid& grid);
+
+    /**
+     * @brief Vol of each interval of the construction grid (0 for an empty
+     * interval).
+     */
+    const std::vector<double>& intervalVols() const { return vols_; }
+
+    std::size_t normalCount(const TimeGrid& grid) const override;
+
+    void buildPath(double spot0,
+                   const TimeGrid& grid,
+                   const double* normals,
+                   std::vector<double>& path,
+                   double* intervalVariance) const override;
+
+private:
+    double v0_;
+    double kappa_;
+    double theta_;
+    std::vector<double> vols_;
+};
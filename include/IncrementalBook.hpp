@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MarketData.hpp"
+#include "PathCache.hpp"
+#include "PricerRunner.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Book of trades revalued tick-by-tick on cached path shapes.
+ *
+ * Each trade is priced in full once when added, by Monte Carlo whatever its
+ * engineType, so that the full and the cached prices use the same paths. Its path shapes are kept in a
+ * PathCache shared with every other trade of the same underlying, model,
+ * schedule, path count and seed. A later spot or curve move only rescales the
+ * cached shapes and re-evaluates the payoffs: price, standard error, delta and
+ * bid/ask are refreshed, while vega stays the one of the last full pricing
+ * since a volatility move requires a new simulation.
+ */
+class IncrementalBook {
+public:
+  /**
+   * @brief Prices the trade from scratch and registers it in the book.
+   * @return Index of the trade in the results of revalue().
+   */
+  std::size_t addTrade(const PricingInputs &inputs);
+
+  /**
+   * @brief Prices the trades from scratch as one book
+   * (priceAutocallPortfolio) and registers them in order.
+   * @return Index of the first of them in the results of revalue().
+   * @throws std::runtime_error if a trade cannot be cached; none of the
+   * trades is added then.
+   */
+  std::size_t addTrades(const std::vector<PricingInputs> &trades);
+
+  std::size_t size() const { return trades_.size(); }
+
+  /**
+   * @brief Revalues every trade on the spots/discount curve of the given
+   * market.
+   *
+   * Trades sharing a cache are evaluated path by path, so each rescaled path
+   * is built once and reused by all of them; the paths are spread over
+   * workerCount() threads by block, and the block sums merged in block order
+   * (results do not depend on the thread count).
+   */
+  std::vector<PricingResults> revalue(const MarketData &market) const;
+
+private:
+  struct Trade {
+    PricingInputs inputs;
+    std::unique_ptr<StructuredProduct> product;
+    double vega{};
+  };
+
+  struct Group {
+    PricingInputs key;
+    SymbolId underlyingId{};
+    std::shared_ptr<PathCache> cache;
+    std::vector<std::size_t> trades;
+  };
+
+  Group &groupFor(const PricingInputs &inputs);
+
+  std::vector<Trade> trades_;
+  std::vector<Group> groups_;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Minimal JSON document (RFC 8259 subset used by term sheets and the
+ * pricing server).
+ *
+ * Numbers are doubles; objects keep their members in document order. The
+ * parser accepts exactly one value surrounded by whitespace.
+ */
+class JsonValue {
+public:
+  enum class Type { Null, Bool, Number, String, Array, Object };
+  using Member = std::pair<std::string, JsonValue>;
+
+  JsonValue() = default;
+
+  /**
+   * @throws std::runtime_error("Json: ...") with the byte offset of the
+   * first syntax error.
+   */
+  static JsonValue parse(const std::string &text);
+
+  // Builders of each type (a default-constructed value is null).
+  static JsonValue boolean(bool value);
+  static JsonValue number(double value);
+  static JsonValue string(std::string value);
+  static JsonValue array(std::vector<JsonValue> items);
+  static JsonValue object(std::vector<Member> members);
+
+  /**
+   * @brief Compact text of the value; numbers keep 17 significant digits so
+   * that they parse back exactly, non-finite ones are written as null.
+   */
+  std::string dump() const;
+
+  Type type() const { return type_; }
+  bool isNull() const { return type_ == Type::Null; }
+  bool isNumber() const { return type_ == Type::Number; }
+  bool isArray() const { return type_ == Type::Array; }
+  bool isObject() const { return type_ == Type::Object; }
+
+  // Typed accessors; throw std::runtime_error on a type mismatch.
+  bool asBool() const;
+  double asNumber() const;
+  const std::string &asString() const;
+  const std::vector<JsonValue> &asArray() const;
+  const std::vector<Member> &asObject() const;
+
+  /**
+   * @brief Member `key` of an object, or nullptr when absent (or when this
+   * value is not an object).
+   */
+  const JsonValue *find(const std::string &key) const;
+
+private:
+  friend class JsonParser;
+
+  Type type_{Type::Null};
+  bool bool_{false};
+  double number_{0.0};
+  std::string string_;
+  std::vector<JsonValue> array_;
+  std::vector<Member> object_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+// Compensated (Kahan) summation: keeps the payoff sums accurate over millions
+// of paths.
+struct KahanSum {
+  double sum{0.0};
+  double compensation{0.0};
+
+  void add(double value) {
+    const double y = value - compensation;
+    const double t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+  }
+};
+
+// Centred second moments of a sample of pairs (x, y): updated one pair at a
+// time (Welford) and merged across blocks (Chan, Golub and LeVeque), so the
+// variances never come from sum(x^2) - n mean^2, which cancels when the
+// payoffs spread little around a large mean. y is optional (left at zero).
+struct CentredMoments {
+  double count{0.0};
+  double meanX{0.0};
+  double meanY{0.0};
+  double m2X{0.0}; // sum (x - meanX)^2
+  double m2Y{0.0}; // sum (y - meanY)^2
+  double cXY{0.0}; // sum (x - meanX)(y - meanY)
+
+  void add(double x, double y = 0.0) {
+    count += 1.0;
+    const double dx = x - meanX;
+    const double dy = y - meanY;
+    meanX += dx / count;
+    meanY += dy / count;
+    m2X += dx * (x - meanX);
+    m2Y += dy * (y - meanY);
+    cXY += dx * (y - meanY);
+  }
+
+  void merge(const CentredMoments &other) {
+    if (other.count == 0.0) {
+      return;
+    }
+    const double total = count + other.count;
+    const double dx = other.meanX - meanX;
+    const double dy = other.meanY - meanY;
+    const double weight = count * other.count / total;
+    meanX += dx * other.count / total;
+    meanY += dy * other.count / total;
+    m2X += other.m2X + dx * dx * weight;
+    m2Y += other.m2Y + dy * dy * weight;
+    cXY += other.cXY + dx * dy * weight;
+    count = total;
+  }
+
+  // Unbiased sample variances and covariance (zero below two pairs).
+  double varianceX() const { return count > 1.0 ? m2X / (count - 1.0) : 0.0; }
+  double varianceY() const { return count > 1.0 ? m2Y / (count - 1.0) : 0.0; }
+  double covariance() const {
+    return count > 1.0 ? cXY / (count - 1.0) : 0.0;
+  }
+};
+
+// Sums of a Monte Carlo estimator: the compensated payoff sum for the mean,
+// the centred moments for its standard error. Per-block sums merged in block
+// order do not depend on the number of threads.
+struct PayoffSums {
+  KahanSum payoff;
+  CentredMoments moments;
+
+  void add(double value) {
+    payoff.add(value);
+    moments.add(value);
+  }
+  void merge(const PayoffSums &other) {
+    payoff.add(other.payoff.sum);
+    moments.merge(other.moments);
+  }
+
+  double mean() const {
+    return moments.count > 0.0 ? payoff.sum / moments.count : 0.0;
+  }
+  double stdError() const {
+    return moments.count > 0.0
+               ? std::sqrt(moments.varianceX() / moments.count)
+               : 0.0;
+  }
+};
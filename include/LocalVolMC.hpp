@@ -0,0 +1,128 @@
+#pragma once
+
+#include "PathModel.hpp"
+#include "UniformTable.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Implied-volatility surface on (expiry, forward moneyness).
+ *
+ * Quotes are given for each expiry T_j and forward moneyness m_i = K / F(T_j).
+ * Total variance w = sigma^2 * T is interpolated with a natural cubic spline
+ * in y = log(m) at each expiry (flat outside the quoted strikes) and linearly
+ * in T between expiries (constant implied vol before the first / after the
+ * last expiry).
+ */
+class ImpliedVolSurface {
+public:
+  /**
+   * @param expiries Strictly increasing positive expiries (in years).
+   * @param moneyness Strictly increasing forward moneyness K / F(T).
+   * @param vols Row-major implied vols, vols[j * moneyness.size() + i].
+   * @throws std::runtime_error on inconsistent sizes or ordering.
+   */
+  ImpliedVolSurface(std::vector<double> expiries, std::vector<double> moneyness,
+                    std::vector<double> vols);
+
+  /**
+   * @brief Flat surface at a single volatility.
+   */
+  static ImpliedVolSurface flat(double sigma);
+
+  /**
+   * @brief Total variance and its first two log-moneyness derivatives.
+   */
+  double totalVariance(double y, double t, double *dy = nullptr,
+                       double *dyy = nullptr) const;
+
+  double lastExpiry() const { return expiries_.back(); }
+  double maxVol() const;
+
+  /**
+   * @brief Same surface with every implied vol shifted by a parallel amount.
+   */
+  ImpliedVolSurface shifted(double volShift) const;
+
+private:
+  // Spline of w in y at expiry j: value and derivatives at y.
+  double expiryVariance(std::size_t j, double y, double *dy,
+                        double *dyy) const;
+
+  std::vector<double> expiries_;
+  std::vector<double> logMoneyness_;
+  std::vector<double> vols_;
+  std::vector<double> variances_;   // w at the nodes, [j * n + i]
+  std::vector<double> secondDerivs_; // spline second derivatives, same layout
+};
+
+struct LocalVolSettings {
+  double stepsPerYear{100.0};       // Simulation sub-steps per year.
+  double tableStepsPerYear{52.0};   // Time rows of the local-vol table.
+  std::size_t logSpotNodes{161};    // Log-moneyness columns of the table.
+};
+
+/**
+ * @brief Dupire local volatility pre-tabulated on a uniform
+ * (time, log forward moneyness) grid.
+ *
+ * Lookups go through a UniformTable, so no surface maths runs in the path
+ * loop. The table covers
+ * [0, lastExpiry] in time (the last row is used beyond) and +/- 4 sigma_max
+ * sqrt(lastExpiry) in log-moneyness (clamped outside).
+ */
+class LocalVolTable {
+public:
+  LocalVolTable(const ImpliedVolSurface &surface,
+                const LocalVolSettings &settings);
+
+  double volatility(double t, double x) const { return table_(t, x); }
+
+  /**
+   * @brief Underlying grid (the SLV calibration reuses its axes).
+   */
+  const UniformTable &grid() const { return table_; }
+
+private:
+  UniformTable table_;
+};
+
+// Equal sub-steps of at most 1 / stepsPerYear covering an interval of length
+// dt (none for an empty interval). Shared by the local vol and SLV schemes.
+inline std::size_t subStepCount(double dt, double stepsPerYear) {
+  if (dt <= 1e-8) {
+    return 0;
+  }
+  return std::max<std::size_t>(
+      1, static_cast<std::size_t>(std::ceil(dt * stepsPerYear - 1e-9)));
+}
+
+/**
+ * @brief Monte Carlo path generator for the Dupire local-volatility model.
+ *
+ * Simulates X_t = log(S_t / F(t)) with dX = -0.5 sigma_loc^2 dt + sigma_loc
+ * dW, so the curve drift is exact and S_t = S_0 / DF(t) * exp(X_t). Each
+ * observation interval is split into ceil(dt * stepsPerYear) equal sub-steps
+ * ending exactly on the observation date.
+ */
+class LocalVolMC : public PathModelBase {
+public:
+  explicit LocalVolMC(const ImpliedVolSurface &surface,
+                      LocalVolSettings settings = {});
+
+  // One normal per sub-step.
+  std::size_t normalCount(const TimeGrid &grid) const override;
+  // Interval variances: sum(sigma_loc^2 h) over the sub-steps.
+  void buildPath(double spot0, const TimeGrid &grid, const double *normals,
+                 std::vector<double> &path,
+                 double *intervalVariance) const override;
+
+  const LocalVolTable &table() const { return table_; }
+
+private:
+  LocalVolSettings settings_;
+  LocalVolTable table_;
+};
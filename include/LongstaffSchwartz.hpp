@@ -0,0 +1,90 @@
+#pragma once
+
+#include "DiscountCurve.hpp"
+#include "PathModel.hpp"
+#include "StructuredProduct.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct LsmSettings {
+  // Paths of the regression pass. The regression buffer holds three floats
+  // per path and date (12 MB per 100k paths x 10 dates); the pricing pass
+  // streams its paths and does not depend on this count.
+  std::size_t regressionPaths{65536};
+  std::size_t firstCallDate{0}; // Non-call period: no issuer call before.
+};
+
+/**
+ * @brief Longstaff-Schwartz engine for issuer-callable notes.
+ *
+ * On top of the contractual flows of the product (coupons, autocall,
+ * maturity), the issuer may redeem the note at any observation date before
+ * maturity. An autocall is called at the amount paid on an autocall
+ * (ObservationRule::callAmount), a cliquet at the payoff accrued so far. The
+ * issuer calls when the expected value of the remaining flows exceeds the
+ * call amount.
+ *
+ * fit() simulates an independent regression set and stores, for each date,
+ * the spot relative to the fit spot, the path state (unpaid memory coupons
+ * or accrued cliquet payoff) and the contractual flow, in float
+ * date-major (SoA) arrays. The continuation value is then regressed
+ * backwards on {1, x, x^2, x^3} (plus {y, x y} when the product carries a
+ * state), with the normal equations accumulated over fixed-size batches of
+ * paths and merged in batch order. price() replays the fitted rule on fresh
+ * paths: the rule is not fitted on the paths it prices, so the estimate is
+ * free of the in-sample (foresight) bias and, the rule being at best
+ * optimal for the issuer, can only overstate the note value.
+ */
+class LongstaffSchwartz {
+public:
+  /**
+   * @param product Note terms; must outlive the engine.
+   * @throws std::runtime_error for products other than single-asset
+   * autocalls and cliquets.
+   */
+  explicit LongstaffSchwartz(const StructuredProduct &product,
+                             LsmSettings settings = {});
+  ~LongstaffSchwartz();
+
+  LongstaffSchwartz(const LongstaffSchwartz &) = delete;
+  LongstaffSchwartz &operator=(const LongstaffSchwartz &) = delete;
+
+  /**
+   * @brief Fits the exercise rule on settings.regressionPaths paths drawn
+   * from `seed` (use a seed different from the pricing one).
+   */
+  void fit(const PathModelBase &model, double spot, const DiscountCurve &curve,
+           unsigned int seed);
+
+  /**
+   * @brief Prices the callable note with the fitted rule, using the
+   * Monte Carlo block streams of `seed` (pathBlockRng).
+   *
+   * The rule stays the one of fit(), so bumped prices (spot, vol, curve)
+   * share it: to first order the exercise boundary does not move the price.
+   */
+  double price(const PathModelBase &model, double spot,
+               const DiscountCurve &curve, std::size_t paths, unsigned int seed,
+               double &standardError) const;
+
+  bool fitted() const { return !coefficients_.empty(); }
+
+  // Product adapter (autocall or cliquet), defined in the source file.
+  class Terms;
+
+private:
+  double continuation(std::size_t date, double x, double y) const;
+
+  std::unique_ptr<const Terms> terms_;
+  std::vector<double> times_;
+  bool bridge_{false}; // Simulate interval variances (knock-in monitoring).
+  LsmSettings settings_;
+  std::size_t basisSize_{};
+  double referenceSpot_{};
+  // coefficients_[date * basisSize_ + k]; callable_[date] is false when the
+  // date is not callable or had too few live paths to regress.
+  std::vector<double> coefficients_;
+  std::vector<char> callable_;
+};
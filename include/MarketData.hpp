@@ -1,36 +1,103 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include "DiscountCurve.hpp"
+#include "SymbolTable.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct MarketQuote {
+    double spot;
+    double sigma;
+};
+
+/**
+ * @brief Immutable market snapshot: (SymbolId, quote) pairs sorted by ID.
+ *
+ * Lookups are a binary search, and a snapshot only holds its own quotes,
+ * whatever the number of symbols interned by the process. Snapshots are
+ * shared between MarketData instances and never modified once built.
+ */
+class MarketSnapshot {
+public:
+    MarketSnapshot() = default;
+
+    /**
+     * @brief Builds a snapshot from (ID, quote) pairs; later pairs win.
+     */
+    explicit MarketSnapshot(const std::vector<std::pair<SymbolId, MarketQuote>>& quotes);
+
+    /**
+     * @brief Quote of a symbol, or nullptr if absent.
+     */
+    const MarketQuote* find(SymbolId id) const;
+
+    /**
+     * @brief All quotes of the snapshot as (ID, quote) pairs, sorted by ID.
+     */
+    const std::vector<std::pair<SymbolId, MarketQuote>>& entries() const { return quotes_; }
+
+private:
+    std::vector<std::pair<SymbolId, MarketQuote>> quotes_;
+};
 
 /**
  * @brief Container for market data.
  *
- * Holds risk-free rates and market quotes (spot prices, volatilities)
+ * Holds the discount curve and market quotes (spot prices, volatilities)
  * for various underlying assets.
+ *
+ * Quotes live in a shared immutable MarketSnapshot plus a small overlay of
+ * overridden quotes. Copying a MarketData (e.g. for a bumped scenario) copies
+ * a pointer and the overlay, never the snapshot itself. The discount curve
+ * is shared the same way.
  */
 class MarketData {
 public:
-    struct Quote {
-        double spot;
-        double sigma;
-    };
+    using Quote = MarketQuote;
 
+    MarketData() = default;
+    explicit MarketData(std::shared_ptr<const MarketSnapshot> snapshot);
+
+    /**
+     * @brief Sets a flat discount curve at rate r.
+     */
     void setRiskFreeRate(double r);
+    /**
+     * @brief Short end of the discount curve (the rate of a flat curve).
+     */
     double riskFreeRate() const;
 
+    void setDiscountCurve(DiscountCurve curve);
+    const DiscountCurve& discountCurve() const { return *curve_; }
+
     /**
      * @brief Stores a quote for a specific underlying.
+     *
+     * The quote goes to the overlay; the shared snapshot is left untouched.
+     * Names are resolved by the caller (internSymbol), once, outside the
+     * pricing loops.
      */
-    void setQuote(const std::string& underlying, const Quote& quote);
+    void setQuote(SymbolId underlying, const Quote& quote);
 
     /**
-     * @brief Retrieves the quote for a specific underlying.
+     * @brief Retrieves the quote for a specific underlying, by value: a
+     * later setQuote or freeze may move the stored quotes.
      * @throws std::runtime_error if the underlying is not found.
      */
-    const Quote& getQuote(const std::string& underlying) const;
+    Quote getQuote(SymbolId underlying) const;
+
+    /**
+     * @brief Folds the overlay into a new shared snapshot.
+     */
+    void freeze();
+
+    const std::shared_ptr<const MarketSnapshot>& snapshot() const { return base_; }
 
 private:
-    double riskFreeRate_{0.0};
-    std::unordered_map<std::string, Quote> quotes_;
-};
\ No newline at end of file
+    std::shared_ptr<const DiscountCurve> curve_{std::make_shared<const DiscountCurve>()};
+    std::shared_ptr<const MarketSnapshot> base_;
+    std::vector<std::pair<SymbolId, Quote>> overrides_;
+};
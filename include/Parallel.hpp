@@ -0,0 +1,157 @@
+// Thread helpers shared by the Monte Carlo engines: a process-wide pool and
+// the parallelFor loops that borrow it.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Number of threads used by parallelFor.
+ *
+ * Hardware concurrency by default; the PRICER_THREADS environment variable
+ * overrides it (PRICER_THREADS=1 runs everything on the calling thread).
+ */
+inline std::size_t workerCount() {
+  static const std::size_t count = [] {
+    if (const char *env = std::getenv("PRICER_THREADS")) {
+      const long requested = std::strtol(env, nullptr, 10);
+      if (requested > 0) {
+        return static_cast<std::size_t>(requested);
+      }
+    }
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  }();
+  return count;
+}
+
+/**
+ * @brief Whether the calling thread is already one of the workers of a
+ * parallel loop (parallelFor, runWorkStealing, InlineParallelLoops). Nested
+ * loops then run on that thread alone rather than borrowing the pool.
+ */
+inline bool &insideParallelWorker() {
+  thread_local bool inside = false;
+  return inside;
+}
+
+/**
+ * @brief Marks the calling thread as a worker while in scope, so the
+ * parallelFor loops it starts run on it alone (a task that already is one
+ * thread's share of a parallel job).
+ */
+class InlineParallelLoops {
+public:
+  InlineParallelLoops() : wasInside_(insideParallelWorker()) {
+    insideParallelWorker() = true;
+  }
+  ~InlineParallelLoops() { insideParallelWorker() = wasInside_; }
+  InlineParallelLoops(const InlineParallelLoops &) = delete;
+  InlineParallelLoops &operator=(const InlineParallelLoops &) = delete;
+
+private:
+  bool wasInside_;
+};
+
+namespace detail {
+// One parallelFor loop, run by its caller and by the pool threads that join
+// it. Indices are handed out through `next`.
+struct ParallelJob {
+  std::size_t count{};
+  std::atomic<std::size_t> next{0};
+  void (*call)(void *fn, std::size_t i){};
+  void *fn{};
+  std::size_t active{}; // Pool threads inside work() (guarded by the pool).
+  std::exception_ptr error;
+  std::mutex errorMutex;
+
+  void work() {
+    for (std::size_t i = next++; i < count; i = next++) {
+      try {
+        call(fn, i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next = count; // Stop handing out work.
+      }
+    }
+  }
+};
+
+/**
+ * @brief workerCount() - 1 threads started on first use and kept for the
+ * whole process, lent to the parallelFor loops of every thread.
+ */
+class WorkerPool {
+public:
+  static WorkerPool &instance();
+
+  /**
+   * @brief Runs job.work() on the calling thread, helped by up to `helpers`
+   * pool threads, and returns once all of them have left the job. Helpers
+   * busy elsewhere never join it: the caller then does the work itself.
+   */
+  void run(ParallelJob &job, std::size_t helpers);
+
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+private:
+  explicit WorkerPool(std::size_t threads);
+  void loop();
+
+  std::mutex mutex_;
+  std::condition_variable ready_; // A ticket was queued, or stopping_.
+  std::condition_variable left_;  // A helper left its job.
+  std::deque<ParallelJob *> tickets_; // One per helper asked for.
+  bool stopping_{false};
+  std::vector<std::thread> threads_;
+};
+} // namespace detail
+
+/**
+ * @brief Calls fn(i) for every i in [0, count), spread over workerCount()
+ * threads: the calling thread and the threads of a pool kept for the whole
+ * process (on the calling thread alone when it already is a worker).
+ *
+ * Loops started concurrently by several threads share the pool, so they
+ * never run more than workerCount() - 1 helper threads between them.
+ * Indices are handed out one at a time through an atomic counter, so fn must
+ * only touch state owned by index i (or read-only shared state). The first
+ * exception thrown by fn is rethrown on the calling thread once all workers
+ * have stopped.
+ */
+template <typename Fn> void parallelFor(std::size_t count, Fn &&fn) {
+  const std::size_t threads =
+      insideParallelWorker() ? 1 : std::min(workerCount(), count);
+  if (threads <= 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  detail::ParallelJob job;
+  job.count = count;
+  job.fn = &fn;
+  job.call = [](void *f, std::size_t i) {
+    (*static_cast<std::remove_reference_t<Fn> *>(f))(i);
+  };
+  insideParallelWorker() = true;
+  detail::WorkerPool::instance().run(job, threads - 1);
+  insideParallelWorker() = false;
+  if (job.error) {
+    std::rethrow_exception(job.error);
+  }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "DiscountCurve.hpp"
+#include "PathModel.hpp"
+#include "StructuredProduct.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief In-memory set of simulated paths stored as spot/rate-free shapes.
+ *
+ * Both BlackScholesMC and HestonMC produce paths of the form
+ * S_t = S_0 / DF(t) * X_t, where the shape X_t only depends on the model
+ * parameters and the random draws. The cache keeps X_t for every path so that
+ * a spot or curve move only costs a rescaling plus the payoff evaluation.
+ */
+class PathCache {
+public:
+  /**
+   * @brief Simulates and stores the path shapes.
+   *
+   * The random stream is the one of the Monte Carlo engines for the same
+   * seed (pathBlockRng block streams, as in GreeksEngine), so a revaluation
+   * at the original spot/curve reproduces the base price of priceAutocall.
+   *
+   * @param model Path generator (BS or Heston).
+   * @param times Observation times of the products priced on these paths.
+   * @param spot Spot used for the simulation.
+   * @param curve Discount curve used for the simulation.
+   * @param paths Number of Monte Carlo paths.
+   * @param seed Seed of the Mersenne Twister.
+   * @param keepBridge Also keep the variance of log(S) over each interval
+   * of each path, for products monitoring a barrier between dates (it does
+   * not depend on the spot or the curve).
+   */
+  PathCache(const PathModelBase &model, std::vector<double> times, double spot,
+            const DiscountCurve &curve, std::size_t paths, unsigned int seed,
+            bool keepBridge = false);
+
+  std::size_t pathCount() const { return paths_; }
+  const std::vector<double> &times() const { return times_; }
+
+  /**
+   * @brief Per-date multipliers spot / DF(t_i) applied to the shapes.
+   */
+  std::vector<double> dateScales(double spot, const DiscountCurve &curve) const;
+
+  /**
+   * @brief Rebuilds path p from its shape and precomputed date scales.
+   */
+  void fillPath(std::size_t p, const std::vector<double> &scales,
+                std::vector<double> &out) const;
+
+  /**
+   * @brief Interval variances of path p (see PathView::withBridge), or
+   * nullptr when the cache was built without keepBridge.
+   */
+  const double *intervalVariance(std::size_t p) const {
+    return variances_.empty() ? nullptr
+                              : variances_.data() + p * times_.size();
+  }
+
+  /**
+   * @brief Rebuilds paths [first, first + count) date-major
+   * (out[i * count + k] is path first + k at date i), the layout of
+   * StructuredProduct::discountedPayoffs.
+   */
+  void fillBatch(std::size_t first, std::size_t count,
+                 const std::vector<double> &scales,
+                 std::vector<double> &out) const;
+
+  // Paths per batch handed to discountedPayoffs; a batch (dates x paths)
+  // stays in cache.
+  static constexpr std::size_t kBatchPaths = 256;
+
+  /**
+   * @brief Prices a product on the cached paths for a new spot/curve.
+   * @param standardError Receives the Monte Carlo standard error.
+   */
+  double price(const StructuredProduct &product, double spot,
+               const DiscountCurve &curve, double &standardError) const;
+
+private:
+  std::vector<double> times_;
+  std::size_t paths_{};
+  std::vector<double> shapes_; // path-major: shapes_[p * dates + i]
+  std::vector<double> variances_; // Same layout; empty without keepBridge.
+};
@@ -1,18 +1,86 @@
 // Abstract interface for Monte Carlo path generators (BS, Heston, ...).
 #pragma once
 
-#include "MarketData.hpp"
+#include "DiscountCurve.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <random>
 #include <vector>
 
+// Random stream convention shared by every Monte Carlo consumer (runner,
+// path caches, path stores): paths are grouped in fixed-size blocks and
+// block b draws from its own generator seeded with {seed, b}. Results do not
+// depend on how blocks are spread over threads, and path p always sees the
+// same draws.
+constexpr std::size_t kPathsPerBlock = 2048;
+
+inline std::size_t pathBlockCount(std::size_t paths) {
+    return (paths + kPathsPerBlock - 1) / kPathsPerBlock;
+}
+
+inline std::size_t pathBlockEnd(std::size_t block, std::size_t paths) {
+    return std::min(paths, (block + 1) * kPathsPerBlock);
+}
+
+inline std::mt19937 pathBlockRng(unsigned int seed, std::size_t block) {
+    std::seed_seq sequence{seed, static_cast<unsigned int>(block)};
+    return std::mt19937(sequence);
+}
+
+// Fills out with count standard normals, drawn in order from a fresh
+// distribution: the stream every model consumes for one path.
+inline void drawNormals(std::mt19937& rng, std::size_t count,
+                        std::vector<double>& out) {
+    out.resize(count);
+    std::normal_distribution<double> dist(0.0, 1.0);
+    for (double& z : out) {
+        z = dist(rng);
+    }
+}
+
 class PathModelBase {
 public:
     virtual ~PathModelBase() = default;
 
-    virtual std::vector<double> simulatePath(
-        double spot0,
-        const std::vector<double>& times,
-        const MarketData& data,
-        std::mt19937& rng) const = 0;
+    // Number of standard normals one path consumes on this grid.
+    virtual std::size_t normalCount(const TimeGrid& grid) const = 0;
+
+    // Builds the path driven by the given normals (normalCount(grid) of them,
+    // in the order simulatePath draws them); path is resized to the grid.
+    // intervalVariance, when not null, receives the variance of log(S)
+    // accumulated over each interval (t_{i-1}, t_i] (t_{-1} = 0), which lets
+    // payoffs bridge barrier crossings between observation dates.
+    // Separating the draws from the diffusion lets several scenarios (bumped
+    // models, shifted grids) be built from the same normals.
+    virtual void buildPath(double spot0,
+                           const TimeGrid& grid,
+                           const double* normals,
+                           std::vector<double>& path,
+                           double* intervalVariance) const = 0;
+
+    // The grid carries the observation dates and the curve sampled on them;
+    // the drift over each interval is read from grid.logGrowth.
+    std::vector<double> simulatePath(double spot0,
+                                     const TimeGrid& grid,
+                                     std::mt19937& rng) const {
+        thread_local std::vector<double> normals;
+        drawNormals(rng, normalCount(grid), normals);
+        std::vector<double> path;
+        buildPath(spot0, grid, normals.data(), path, nullptr);
+        return path;
+    }
+
+    // Same draws and path, with the interval variances.
+    std::vector<double> simulatePath(double spot0,
+                                     const TimeGrid& grid,
+                                     std::mt19937& rng,
+                                     std::vector<double>& intervalVariance) const {
+        thread_local std::vector<double> normals;
+        drawNormals(rng, normalCount(grid), normals);
+        intervalVariance.assign(grid.times.size(), 0.0);
+        std::vector<double> path;
+        buildPath(spot0, grid, normals.data(), path, intervalVariance.data());
+        return path;
+    }
 };
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "PathModel.hpp"
+#include "PricerRunner.hpp"
+#include "StructuredProduct.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class PathPrecision { Float64, Float32 };
+
+/**
+ * @brief Description of a stored path set (written in the file header).
+ */
+struct PathStoreInfo {
+  ModelType modelType{ModelType::BlackScholes};
+  // BS: {sigma}; Heston: {v0, kappa, theta, xi, rho}; local vol/SLV: {}.
+  std::vector<double> modelParams;
+  double spot{};
+  double rate{};
+  unsigned int seed{};
+  std::vector<double> times;
+  PathPrecision precision{PathPrecision::Float64};
+  std::uint64_t pathCount{};
+};
+
+/**
+ * @brief Model description of a PricingInputs, ready for a path store header.
+ */
+PathStoreInfo makePathStoreInfo(const PricingInputs &inputs,
+                                PathPrecision precision);
+
+/**
+ * @brief Writes simulated paths to a binary path store.
+ *
+ * File layout (host endianness): a fixed-size header with the model, its
+ * parameters, spot, rate, seed, precision, counts and tile size, then the
+ * date grid as float64, then the paths. Paths are stored in tiles of
+ * kPathsPerBlock paths (one Monte Carlo block; the last tile may be shorter),
+ * each tile date-major (tile[i * count + k] is its path k at date i), so a
+ * tile is handed to StructuredProduct::discountedPayoffs as it is.
+ */
+class PathStoreWriter {
+public:
+  /**
+   * @brief Creates the file, sized for info.pathCount paths.
+   */
+  PathStoreWriter(const std::string &filename, PathStoreInfo info);
+  ~PathStoreWriter();
+
+  PathStoreWriter(const PathStoreWriter &) = delete;
+  PathStoreWriter &operator=(const PathStoreWriter &) = delete;
+
+  std::size_t tileCount() const;
+  std::size_t tilePathCount(std::size_t tile) const;
+
+  /**
+   * @brief Writes tile `tile` from date-major spots (tilePathCount(tile)
+   * paths). Distinct tiles may be written concurrently.
+   */
+  void writeTile(std::size_t tile, const double *spots) const;
+
+  /**
+   * @brief Closes the file.
+   */
+  void close();
+
+private:
+  PathStoreInfo info_;
+  int fd_{-1};
+  std::size_t payloadOffset_{};
+};
+
+/**
+ * @brief Simulates paths with the Monte Carlo block streams (pathBlockRng,
+ * as in GreeksEngine), one block per tile on parallelFor threads, and writes
+ * them to a new path store.
+ */
+void writePathStore(const std::string &filename, const PathModelBase &model,
+                    PathStoreInfo info, std::size_t paths);
+
+/**
+ * @brief Read-only memory-mapped view of a path store.
+ *
+ * Float64 tiles are read in place; Float32 tiles are widened into a caller
+ * buffer.
+ */
+class PathStoreReader {
+public:
+  explicit PathStoreReader(const std::string &filename);
+  ~PathStoreReader();
+
+  PathStoreReader(const PathStoreReader &) = delete;
+  PathStoreReader &operator=(const PathStoreReader &) = delete;
+
+  const PathStoreInfo &info() const { return info_; }
+  std::size_t pathCount() const {
+    return static_cast<std::size_t>(info_.pathCount);
+  }
+  std::size_t dateCount() const { return info_.times.size(); }
+  std::size_t tileCount() const;
+  std::size_t tilePathCount(std::size_t tile) const;
+
+  /**
+   * @brief Date-major spots of tile `tile`: a pointer into the mapping for
+   * Float64 stores, Float32 values widened into scratch otherwise.
+   */
+  const double *tile(std::size_t tile, std::vector<double> &scratch) const;
+
+  /**
+   * @brief Prices a product on the stored paths, discounting at the stored
+   * rate (the rate the paths drift at).
+   *
+   * The product must use the stored date grid. Tiles are priced on
+   * parallelFor threads with StructuredProduct::discountedPayoffs and their
+   * sums merged in tile order, so the result does not depend on the thread
+   * count.
+   *
+   * @param standardError Receives the Monte Carlo standard error.
+   */
+  double price(const StructuredProduct &product, double &standardError) const;
+
+private:
+  PathStoreInfo info_;
+  std::size_t tilePaths_{};
+  void *mapping_{nullptr};
+  std::size_t mappingSize_{};
+  const unsigned char *payload_{nullptr};
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Streaming quantile sketch (merging t-digest, Dunning & Ertl).
+ *
+ * Values are buffered and periodically folded into weighted centroids kept
+ * sorted by mean. A centroid may only grow while it spans at most one unit
+ * of the scale k(q) = compression / (2 pi) asin(2q - 1), so centroids are
+ * small in the tails (where VaR and expected shortfall are read) and larger
+ * in the body: memory is O(compression) whatever the number of values.
+ * Digests merge by folding one's centroids into the other; the result only
+ * depends on the order of the merges.
+ *
+ * Only add(), merge(), compress() and clear() modify the digest; the const
+ * queries never do, so a digest may be read from several threads at once.
+ * A query on a digest with buffered values folds a copy of it: compress()
+ * before publishing a digest avoids that copy on every query.
+ */
+class TDigest {
+public:
+  explicit TDigest(double compression = 200.0);
+
+  void add(double value);
+  // Folds other's centroids and buffered values into this digest; an empty
+  // digest takes a folded one as is.
+  void merge(const TDigest &other);
+
+  // Total weight: the centroids' and the buffered values'.
+  double count() const;
+  double min() const { return min_; }
+  double max() const { return max_; }
+
+  /**
+   * @brief Value below which a fraction q of the weight lies, interpolated
+   * linearly between the centroid centres (and the extreme values).
+   */
+  double quantile(double q) const;
+
+  /**
+   * @brief Mean of the lowest fraction q of the values (the integral of
+   * quantile() over [0, q], divided by q).
+   */
+  double meanBelow(double q) const;
+
+  /**
+   * @brief Folds the buffered values into the centroids (done by add()
+   * whenever the buffer is full, and by merge()).
+   */
+  void compress();
+
+  // Forgets every value (the compression stays).
+  void clear();
+
+private:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+  // Breakpoint of the piecewise-linear quantile function.
+  struct Knot {
+    double fraction; // Cumulative weight fraction.
+    double value;
+  };
+
+  // Knots of the folded digest (of a folded copy if values are buffered).
+  std::vector<Knot> quantileKnots() const;
+
+  double compression_;
+  std::vector<Centroid> centroids_;
+  std::vector<Centroid> buffer_;
+  double weight_{0.0}; // Total weight of centroids_.
+  double min_;
+  double max_;
+};
+
+/**
+ * @brief Counts on equal-width bins over [low, high); values outside are
+ * counted apart. Merges exactly.
+ */
+class FixedHistogram {
+public:
+  FixedHistogram() = default;
+  FixedHistogram(double low, double high, std::size_t bins);
+
+  void add(double value);
+  void merge(const FixedHistogram &other);
+  void clear();
+
+  double low() const { return low_; }
+  double width() const { return width_; }
+  const std::vector<std::uint64_t> &counts() const { return counts_; }
+  std::uint64_t below() const { return below_; }
+  std::uint64_t above() const { return above_; }
+
+private:
+  double low_{0.0};
+  double width_{1.0};
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t below_{0};
+  std::uint64_t above_{0};
+};
+
+/**
+ * @brief Distribution of the discounted payoffs of a Monte Carlo run,
+ * accumulated without storing them: a t-digest for quantiles and tail
+ * means, a fixed-bin histogram, and the exact count of payoffs below
+ * lossThreshold (the capital-loss level).
+ *
+ * The engine fills one per path block, starting from emptyCopy() of the
+ * caller's, and merges them in block order: the result does not depend on
+ * the number of threads.
+ */
+class PayoffDistribution {
+public:
+  PayoffDistribution(double histogramLow, double histogramHigh,
+                     std::size_t bins, double lossThreshold);
+
+  // Same histogram bins and loss threshold, no values.
+  PayoffDistribution emptyCopy() const;
+
+  void add(double payoff) {
+    digest_.add(payoff);
+    histogram_.add(payoff);
+    count_ += 1;
+    losses_ += payoff < lossThreshold_ ? 1 : 0;
+  }
+  void merge(const PayoffDistribution &other);
+
+  std::uint64_t count() const { return count_; }
+  // Fraction of the payoffs below lossThreshold.
+  double lossProbability() const;
+  const TDigest &digest() const { return digest_; }
+  TDigest &digest() { return digest_; }
+  const FixedHistogram &histogram() const { return histogram_; }
+
+private:
+  TDigest digest_;
+  FixedHistogram histogram_;
+  double lossThreshold_;
+  std::uint64_t count_{0};
+  std::uint64_t losses_{0};
+};
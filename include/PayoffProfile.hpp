@@ -0,0 +1,74 @@
+#pragma once
+
+#include "DiscountCurve.hpp"
+#include "PathCache.hpp"
+#include "PricerRunner.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Paths of the payoff profile chart: enough for 40 bins of 500 paths.
+inline constexpr std::size_t kProfilePaths = 20000;
+
+// Payoffs of the paths ending in one range of terminal spots.
+struct PayoffProfileBin {
+  double terminalSpot{}; // Mean terminal spot of the paths of the bin.
+  double mean{};         // Expected discounted payoff given that range.
+  double lower{};        // PayoffProfile::kLowerBand quantile of the payoffs.
+  double upper{};        // PayoffProfile::kUpperBand quantile.
+  std::size_t paths{};
+};
+
+/**
+ * @brief Expected discounted payoff conditional on the terminal spot,
+ * estimated on simulated paths of the pricing model.
+ *
+ * The paths (shapes and, for monitored barriers, interval variances) are
+ * simulated once into a PathCache and sorted by terminal shape; a spot or
+ * curve move rescales every path by the same factor per date, so the order
+ * holds. compute() then evaluates the product on every cached path and cuts
+ * the sorted paths into bins of equal count: each bin gives the mean payoff
+ * and a quantile band, which shows what path dependence (earlier calls,
+ * coupons, knock-ins) does to paths ending at the same spot. Issuer calls
+ * are left out: their exercise comes from a regression, not from the path.
+ *
+ * A profile is immutable once built and may be shared between threads.
+ */
+class PayoffProfile {
+public:
+  static constexpr double kLowerBand = 0.10;
+  static constexpr double kUpperBand = 0.90;
+
+  /**
+   * @brief Simulates `paths` paths of the inputs' model (inputs.paths is
+   * not used), with the seed of the inputs.
+   * @throws std::runtime_error("PayoffProfile: ...") for worst-of baskets
+   * (no single terminal spot) and products without observation dates.
+   */
+  explicit PayoffProfile(const PricingInputs &inputs,
+                         std::size_t paths = kProfilePaths);
+
+  /**
+   * @brief Whether the cached paths are the ones `inputs` would simulate,
+   * so that compute(inputs) needs no new simulation: same model, dates and
+   * seed; the spot and curve may differ under Black-Scholes and Heston,
+   * whose path shapes do not depend on them.
+   */
+  bool covers(const PricingInputs &inputs) const;
+
+  /**
+   * @brief Profile of the product of `inputs` (at its spot and curve) in
+   * `bins` bins of terminal spot, from low to high.
+   * @throws std::runtime_error if the paths do not cover the inputs.
+   */
+  std::vector<PayoffProfileBin> compute(const PricingInputs &inputs,
+                                        std::size_t bins = 40) const;
+
+  std::size_t pathCount() const { return cache_->pathCount(); }
+
+private:
+  PricingInputs inputs_; // paths set to the profile's path count.
+  std::unique_ptr<PathCache> cache_;
+  std::vector<std::size_t> order_; // Paths by increasing terminal shape.
+};
@@ -8,9 +8,12 @@ public:
                   double callBarrier, double protectionBarrier,
                   double couponBarrier);
 
-  double discountedPayoff(const std::vector<double> &path,
-                          double riskFreeRate) const override;
+  ObservationRule observationRule(std::size_t i) const override;
 
 private:
+  // Unsmoothed payoff of a path, recording its life in `events` when given.
+  double payoff(PathView path, const double *discountFactors,
+                LifeEvents *events) const override;
+
   double couponBarrier_{};
 };
\ No newline at end of file
@@ -1,20 +1,49 @@
 // Public-facing pricing inputs/results plus product/model enums used by the runner.
 #pragma once
 
+#include "DiscountCurve.hpp"
+#include "StructuredProduct.hpp"
+
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
+class MultiAssetPathModel;
+class PathModelBase;
+struct SchedulerStats;
+
 enum class ProductFamily { Autocall, Cliquet };
 enum class AutocallType { Simple, Phoenix, MemoryPhoenix, StepDown, Airbag };
 enum class CliquetType { MaxReturn, CappedCoupons };
-enum class ModelType { BlackScholes, Heston };
+// Slv: Heston stochastic local vol (Heston parameters + implied surface).
+enum class ModelType { BlackScholes, Heston, LocalVol, Slv };
+// Pde: finite-difference engine for the autocall family (falls back to Monte
+// Carlo for products/models it does not cover, for non-flat curves and for
+// protection barriers monitored during the life of the note).
+// Auto: closed form or deterministic quadrature where the model has one
+// under Black-Scholes (cliquets, see CliquetAnalytic; autocalls without a
+// coupon barrier below the autocall barrier, see AutocallQuadrature), Monte
+// Carlo otherwise.
+enum class EngineType { MonteCarlo, Pde, Auto };
+
+// One component of a worst-of basket. Heston assets share kappa, theta, xi
+// and rho with the single-asset inputs and only differ by their v0.
+struct BasketAsset {
+    std::string name;
+    double spot{};
+    double sigma{0.20};
+    double hestonV0{0.04};
+};
 
 struct PricingInputs {
     std::string underlying{"SPX"};
     double spot{4000.0};
     double sigma{0.20};
     double rate{0.02};
+    // Zero-rate pillars of the discount curve (empty: flat at `rate`).
+    std::vector<double> curveTimes;
+    std::vector<double> curveZeroRates;
     double notional{1000.0};
     double coupon{0.05};
     double autocallBarrier{4100.0};
@@ -27,16 +56,92 @@ struct PricingInputs {
     AutocallType autocallType{AutocallType::Simple};
     CliquetType cliquetType{CliquetType::MaxReturn};
     ModelType modelType{ModelType::BlackScholes};
+    EngineType engineType{EngineType::Auto};
     double couponBarrier{4100.0};
     std::vector<double> callBarriers;
     double airbagFloor{0.7};
+    // Autocalls: knock-in of the protection barrier on the final spot only,
+    // or at any time (daily closes or continuously), bridged between the
+    // observation dates.
+    BarrierMonitoring protectionMonitoring{BarrierMonitoring::AtMaturity};
+    // Autocalls: width of the call spreads replacing the autocall, coupon
+    // and protection digitals, relative to each barrier (0: exact payoff).
+    // Stabilises bumped Monte Carlo Greeks; ignored by the PDE engines.
+    double barrierSmoothing{0.0};
     double hestonV0{0.04};
     double hestonKappa{1.5};
     double hestonTheta{0.04};
     double hestonXi{0.5};
     double hestonRho{-0.5};
+    // Implied-vol surface for ModelType::LocalVol/Slv: expiries (years), forward
+    // moneyness K/F(T) and row-major vols [expiry][moneyness] (empty: flat
+    // at `sigma`).
+    std::vector<double> volExpiries;
+    std::vector<double> volMoneyness;
+    std::vector<double> volMatrix;
     double cliquetParticipation{1.0};
     double cliquetCap{0.05};
+    // Non-empty: worst-of on these assets. Barriers stay expressed in `spot`,
+    // which is used as the reference level of the worst performance.
+    std::vector<BasketAsset> basket;
+    // Row-major spot correlation matrix of the basket (empty: independent).
+    std::vector<double> basketCorrelation;
+    // The issuer may also redeem at any observation date before maturity
+    // (from issuerCallFirstDate on). Priced by Longstaff-Schwartz regression
+    // on lsmRegressionPaths independent paths, then on `paths` pricing paths;
+    // Monte Carlo only, single-asset products only.
+    bool issuerCallable{false};
+    std::size_t issuerCallFirstDate{0};
+    std::size_t lsmRegressionPaths{65536};
+    // Non-empty: autocall described by this JSON term sheet (see
+    // CompiledAutocall) instead of productFamily/autocallType. Values the
+    // sheet leaves out come from underlying, spot, notional,
+    // observationTimes and protectionMonitoring.
+    std::string termSheet;
+};
+
+// Levels of PayoffDistributionSummary::quantiles.
+inline constexpr double kPayoffQuantileLevels[] = {0.01, 0.05, 0.10, 0.25, 0.50,
+                                                   0.75, 0.90, 0.95, 0.99};
+
+// Distribution of the discounted payoff over the paths of a single-asset
+// Monte Carlo price, accumulated without storing the paths (see
+// PayoffDistribution). Left empty by the other engines.
+struct PayoffDistributionSummary {
+    std::vector<double> quantiles; // Payoff quantiles at kPayoffQuantileLevels.
+    // Losses of the holder against the mean payoff at the 95% and 99%
+    // levels: VaR = mean - q(1 - level), ES = mean - mean payoff below
+    // q(1 - level). The mean is that of the same raw payoffs as the
+    // quantiles: the price, except under a control variate (Heston
+    // cliquets), where the price is the adjusted estimator and differs
+    // from it by Monte Carlo noise.
+    double valueAtRisk95{};
+    double expectedShortfall95{};
+    double valueAtRisk99{};
+    double expectedShortfall99{};
+    // Fraction of the paths paying back less than the notional in present
+    // value (discounted payoff below notional x DF(maturity)).
+    double capitalLossProbability{};
+    // Fraction of the paths in each bin [low + b width, low + (b+1) width),
+    // over [0, 2 notional).
+    double histogramLow{};
+    double histogramWidth{};
+    std::vector<double> histogram;
+};
+
+// When the note ends and which coupons it pays, over the paths of a
+// single-asset Monte Carlo price (collected in the pricing pass, see
+// LifeEvents). Left empty by the other engines.
+struct AutocallLifeSummary {
+    // Probability of an early redemption at each observation date (at the
+    // last one: called at maturity).
+    std::vector<double> callProbabilities;
+    // Probability of reaching maturity without being called.
+    double maturityProbability{};
+    // Probability of a conditional coupon being paid at each date.
+    std::vector<double> couponProbabilities;
+    double expectedLife{};    // Years until the call or maturity.
+    double expectedCoupons{}; // Number of conditional coupons paid.
 };
 
 struct PricingResults {
@@ -46,6 +151,97 @@ struct PricingResults {
     double vega{};
     double bid{};
     double ask{};
+    double gamma{}; // Single-asset notes, except issuer-callable ones.
+    double rho{};   // dV/dr for a parallel shift of the zero curve.
+    double vanna{}; // d2V/dS dvol; single-asset Monte Carlo only.
+    double theta{}; // dV/dt per year; single-asset Monte Carlo only.
+    std::vector<double> assetDeltas{}; // Worst-of only: dV/dS_k per asset.
+    PayoffDistributionSummary distribution{};
+    AutocallLifeSummary life{};
 };
 
 PricingResults priceAutocall(const PricingInputs& inputs);
+
+/**
+ * @brief Prices several requests at once. Monte Carlo requests that share a
+ * simulation (sharesSimulation) are coalesced: their products are evaluated
+ * on one set of paths (GreeksEngine::runBatch), and each result equals the
+ * one of priceAutocall for that request alone. The requests priced by
+ * another engine or with a control variate go to priceAutocallPortfolio
+ * together (to priceAutocall when alone).
+ * @throws the first error of any request (see priceAutocall).
+ */
+std::vector<PricingResults> priceAutocalls(const std::vector<PricingInputs>& batch);
+
+/**
+ * @brief Prices a book of unrelated trades, whose costs may differ by orders
+ * of magnitude, on the work-stealing scheduler (runWorkStealing).
+ *
+ * Monte Carlo trades are cut into tasks of consecutive path blocks, sized by
+ * an estimated cost per block (normals drawn for the four paths of
+ * GreeksEngine, model sub-steps included, plus the payoffs evaluated at
+ * every date): a long Heston note becomes many tasks, a short Black-Scholes
+ * one a few. The other trades (closed forms, PDE, baskets, issuer calls)
+ * are single tasks. The block sums are merged in block order, so price,
+ * standard error and Greeks are bit-for-bit those of priceAutocall. The
+ * payoff distribution and the life analytics are kept per block and merged
+ * in block order too, so they match priceAutocall's whatever the task
+ * boundaries. Block range tasks run their loops inline; the other tasks
+ * borrow the pool threads left idle.
+ *
+ * @param stats when given, receives the per-worker task counts, steals and
+ * busy times of the run.
+ * @throws the first error of any trade.
+ */
+std::vector<PricingResults>
+priceAutocallPortfolio(const std::vector<PricingInputs>& trades,
+                       SchedulerStats* stats = nullptr);
+
+// Whether two requests simulate the same path shapes: everything that
+// drives the random draws and the diffusion, but not the spot or the curve,
+// is identical.
+bool sharesPaths(const PricingInputs& a, const PricingInputs& b);
+// sharesPaths with the same spot and curve: the paths themselves coincide.
+bool sharesSimulation(const PricingInputs& a, const PricingInputs& b);
+
+// Sharded Monte Carlo (see priceAutocallSharded). Whether the request is
+// priced by single-asset Monte Carlo on a non-empty schedule, the only runs
+// split by path blocks.
+bool isShardable(const PricingInputs& inputs);
+// Sums of the priceAutocall run over path blocks [firstBlock, lastBlock)
+// (GreeksEngine::kBlockSumValues per block; see GreeksEngine::blockSums).
+std::vector<double> autocallBlockSums(const PricingInputs& inputs,
+                                      std::size_t firstBlock,
+                                      std::size_t lastBlock);
+// Results from the sums of every block, identical to priceAutocall
+// except for the payoff distribution and the life analytics, which block
+// sums do not carry.
+PricingResults autocallFromBlockSums(const PricingInputs& inputs,
+                                     const std::vector<double>& sums);
+
+// The run of autocallBlockSums built once (product, models, control
+// variate), for callers summing it range by range: checkpointed runs and
+// the local shards of a sharded run.
+class AutocallBlockRun {
+public:
+    explicit AutocallBlockRun(const PricingInputs& inputs);
+    ~AutocallBlockRun();
+    AutocallBlockRun(const AutocallBlockRun&) = delete;
+    AutocallBlockRun& operator=(const AutocallBlockRun&) = delete;
+
+    // autocallBlockSums(inputs, firstBlock, lastBlock).
+    std::vector<double> blockSums(std::size_t firstBlock,
+                                  std::size_t lastBlock) const;
+    // autocallFromBlockSums(inputs, sums).
+    PricingResults results(const std::vector<double>& sums) const;
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+// Factories shared by the runner and the incremental/batch engines.
+std::unique_ptr<StructuredProduct> makeProduct(const PricingInputs& inputs);
+std::unique_ptr<PathModelBase> makePathModel(const PricingInputs& inputs);
+std::unique_ptr<MultiAssetPathModel> makeBasketModel(const PricingInputs& inputs);
+DiscountCurve makeDiscountCurve(const PricingInputs& inputs);
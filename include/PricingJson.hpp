@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Json.hpp"
+#include "PricerRunner.hpp"
+
+/**
+ * @brief PricingInputs from a JSON object whose members are the field
+ * names of PricingInputs (absent members keep the value of `defaults`).
+ *
+ * Enumerations are strings: productFamily "autocall" | "cliquet";
+ * autocallType "simple" | "phoenix" | "memoryPhoenix" | "stepDown" |
+ * "airbag"; cliquetType "maxReturn" | "cappedCoupons"; modelType
+ * "blackScholes" | "heston" | "localVol" | "slv"; engineType "monteCarlo" |
+ * "pde" | "auto"; protectionMonitoring "maturity" | "daily" | "continuous".
+ * basket is an array of {"name", "spot", "sigma", "hestonV0"} and termSheet
+ * a term sheet object (or its text).
+ *
+ * @throws std::runtime_error("PricingJson: ...") on unknown members and on
+ * values of the wrong type.
+ */
+PricingInputs pricingInputsFromJson(const JsonValue &request,
+                                    const PricingInputs &defaults = {});
+
+// Every field of the inputs, in the form read back (exactly, numbers
+// included) by pricingInputsFromJson.
+JsonValue pricingInputsToJson(const PricingInputs &inputs);
+
+// Every field of the results, assetDeltas only for worst-of notes and
+// distribution and life only for single-asset Monte Carlo prices.
+JsonValue pricingResultsToJson(const PricingResults &results);
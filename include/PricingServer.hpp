@@ -0,0 +1,152 @@
+#pragma once
+
+#include "PricerRunner.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Lock-free histogram of latencies on log-spaced buckets (16 per
+ * doubling from 1 microsecond, about 4.4% wide, up to ~100 s).
+ */
+class LatencyHistogram {
+public:
+  void record(double seconds);
+  std::uint64_t count() const { return count_.load(); }
+
+  /**
+   * @brief Latency (seconds) below which a fraction q of the recorded ones
+   * fall, read at the middle of its bucket (0 when nothing was recorded).
+   */
+  double quantile(double q) const;
+
+  static constexpr std::size_t kBucketsPerDoubling = 16;
+  static constexpr std::size_t kBuckets = 27 * kBucketsPerDoubling;
+
+private:
+  std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+  std::atomic<std::uint64_t> count_{0};
+};
+
+struct ServerOptions {
+  std::string unixPath;      // Unix-domain socket path (empty: TCP).
+  std::uint16_t tcpPort{0};  // TCP port on 127.0.0.1 when unixPath is empty.
+  std::size_t workers{0};    // Batch workers (0: workerCount()).
+  // Largest paths (and lsmRegressionPaths) of a request: the cost of a
+  // request grows with it, and one request must not hold a worker for hours.
+  std::size_t maxPaths{10000000};
+  // Time the dispatcher waits after a request for others to coalesce with,
+  // and the largest batch it hands to a worker.
+  std::chrono::microseconds batchWindow{2000};
+  std::size_t maxBatch{64};
+  std::size_t maxFrameBytes{1 << 20};
+};
+
+/**
+ * @brief Long-running pricing service on a local socket.
+ *
+ * Frames are a 4-byte big-endian length followed by a UTF-8 JSON object, in
+ * both directions. A request is a PricingInputs object (see
+ * pricingInputsFromJson) and is answered by the PricingResults object, or
+ * {"error": "..."}; {"command": "stats"} returns the request count and the
+ * p50/p99 latencies in milliseconds. There is no binary request format:
+ * parsing a full request (about 1 kB) takes about 25 microseconds against
+ * milliseconds of pricing, and JSON keeps the optional members (curve, term sheet, basket)
+ * versionless. Requests above maxPaths are answered with an error. Each
+ * connection is served by its own thread, requests on one connection being
+ * answered in order.
+ *
+ * Requests from all connections go to one queue. A dispatcher collects them
+ * for batchWindow after the first one arrives (or until maxBatch), splits
+ * the batch by simulation (sharesSimulation) and hands each part to a pool
+ * of worker threads started with the server, which price it with
+ * priceAutocalls: requests sharing an underlying and model are evaluated on
+ * a single set of paths. The path blocks of every batch are spread over the
+ * process-wide parallelFor pool, shared by all the batch workers, and
+ * simulated in the pool threads' own buffers, kept from one request to the
+ * next. Latencies run from the complete request frame to the serialised
+ * response.
+ */
+class PricingServer {
+public:
+  /**
+   * @brief Binds and listens, then starts the dispatcher and the workers.
+   * @throws std::runtime_error("Socket: ...") if the socket cannot be set
+   * up (see listenStream).
+   */
+  explicit PricingServer(ServerOptions options);
+  ~PricingServer();
+
+  PricingServer(const PricingServer &) = delete;
+  PricingServer &operator=(const PricingServer &) = delete;
+
+  /**
+   * @brief Accepts connections until stop() (blocking).
+   */
+  void serve();
+
+  /**
+   * @brief Stops accepting, closes the open connections, and lets the
+   * workers finish the queued requests. Safe from any thread, once or more.
+   */
+  void stop();
+
+  /**
+   * @brief Queues one request with the others and waits for its result (the
+   * in-process path of a socket request).
+   * @throws std::runtime_error if the request asks for more than maxPaths
+   * paths, or the pricing error of the request.
+   */
+  PricingResults price(const PricingInputs &inputs);
+
+  const LatencyHistogram &latency() const { return latency_; }
+
+  // Answer to one request frame (a JSON object), without the length prefix.
+  std::string respond(const std::string &request);
+
+private:
+  struct Pending {
+    PricingInputs inputs;
+    std::promise<PricingResults> result;
+  };
+  using Batch = std::vector<Pending>;
+
+  struct Connection {
+    int fd;
+    bool done; // Closed by its thread (guarded by connectionMutex_).
+    std::thread thread;
+  };
+
+  void dispatchLoop();
+  void workLoop();
+  void serveConnection(Connection &connection);
+
+  ServerOptions options_;
+  int listenFd_{-1};
+  std::atomic<bool> stopping_{false};
+  LatencyHistogram latency_;
+
+  std::mutex queueMutex_;
+  std::condition_variable queueReady_;
+  std::deque<Pending> queue_;     // Requests not yet batched.
+  std::deque<Batch> batches_;     // Coalesced batches for the workers.
+  std::condition_variable batchReady_;
+  bool drained_{false};           // Dispatcher done: workers may exit.
+
+  std::thread dispatcher_;
+  std::vector<std::thread> workers_;
+
+  std::mutex connectionMutex_;
+  std::list<Connection> connections_;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "PricerRunner.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Accumulator state of a Monte Carlo run after a prefix of its path
+ * blocks: everything needed to finish it as if it had never stopped.
+ *
+ * The path index is the block count (block b always draws from
+ * pathBlockRng(seed, b), so no generator state is kept), and the
+ * accumulators are the block sums of GreeksEngine (the twelve scenario sums,
+ * the control variate sum and the block's centred second moments), merged
+ * in block order only once the run is complete.
+ */
+struct RunCheckpoint {
+  std::uint64_t fingerprint{}; // Identity of the run (runFingerprint).
+  std::uint64_t totalBlocks{};
+  // GreeksEngine::kBlockSumValues per completed block, in block order.
+  std::vector<double> sums;
+
+  std::size_t completedBlocks() const;
+};
+
+/**
+ * @brief Writes the checkpoint atomically: to `path`.tmp, flushed to disk,
+ * then renamed over `path`, so that a job killed while writing leaves the
+ * previous checkpoint intact.
+ *
+ * File layout (host endianness): a fixed header (magic, version, fingerprint,
+ * total and completed blocks, values per block), the sums as float64, and a
+ * 64-bit FNV-1a checksum of everything before it.
+ *
+ * @throws std::runtime_error("RunCheckpoint: ...") on I/O errors.
+ */
+void writeCheckpoint(const std::string &path, const RunCheckpoint &checkpoint);
+
+/**
+ * @brief Reads a checkpoint written by writeCheckpoint.
+ * @return false when there is no file at `path`.
+ * @throws std::runtime_error("RunCheckpoint: ...") for a truncated, corrupt
+ * or foreign file.
+ */
+bool readCheckpoint(const std::string &path, RunCheckpoint &checkpoint);
+
+// Identity of a pricing run: hash of every input (pricingInputsToJson).
+std::uint64_t runFingerprint(const PricingInputs &inputs);
+
+struct CheckpointOptions {
+  std::string path;
+  // Continue from the checkpoint at `path` when there is one.
+  bool resume{false};
+  // Minimum time between two checkpoints. A checkpoint costs one write of
+  // 128 bytes per 2048 paths done, against seconds of simulation.
+  std::chrono::milliseconds interval{std::chrono::seconds(60)};
+};
+
+/**
+ * @brief priceAutocall, checkpointed: the Monte Carlo run goes through its
+ * path blocks in chunks and saves the completed prefix to options.path at
+ * most every options.interval, and once more when it completes. Resumed
+ * from that file, the run only simulates the missing blocks and its price,
+ * standard error and Greeks are bit-for-bit those of an uninterrupted
+ * priceAutocall (the payoff distribution and the life analytics are not
+ * collected).
+ *
+ * Requests not priced by single-asset Monte Carlo (see isShardable) are
+ * priced directly, without a checkpoint.
+ *
+ * @throws std::runtime_error("RunCheckpoint: ...") when resuming from the
+ * checkpoint of other inputs, and on I/O errors.
+ */
+PricingResults priceAutocallCheckpointed(const PricingInputs &inputs,
+                                         const CheckpointOptions &options);
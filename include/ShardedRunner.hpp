@@ -0,0 +1,61 @@
+#pragma once
+
+#include "PricerRunner.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct ShardOptions {
+  // pricer_shard_worker processes: "host:port" or a Unix socket path.
+  std::vector<std::string> workers;
+  // pricer_shard_worker processes started by the coordinator over socket
+  // pairs (local runs and tests); they exit with the run.
+  std::size_t localWorkers{0};
+  // Executable of the local workers, searched in PATH when it has no '/'.
+  std::string workerProgram{"pricer_shard_worker"};
+  // Path blocks (kPathsPerBlock paths each) per shard.
+  std::size_t blocksPerShard{16};
+  // A worker silent this long on one shard is considered lost.
+  std::chrono::milliseconds shardTimeout{std::chrono::minutes(10)};
+};
+
+/**
+ * @brief priceAutocall with the Monte Carlo path blocks spread over worker
+ * processes, on this machine or others.
+ *
+ * The run is split into shards of consecutive path blocks. Each block draws
+ * from its own stream (pathBlockRng of the seed and the block index), so the
+ * shards are disjoint substreams of the single-process run. A shard request
+ * is a frame holding {"inputs": <pricingInputsToJson>, "firstBlock",
+ * "lastBlock"}; the worker answers with the block sums of the range
+ * (autocallBlockSums) as raw IEEE doubles. Every connection pulls shards
+ * from a shared queue, and the coordinator merges the sums in block order
+ * (autocallFromBlockSums): price, standard error and Greeks are bit-for-bit
+ * those of priceAutocall with the same seed, for any number of workers,
+ * as long as they run the same build on the same architecture. The payoff
+ * distribution and the life analytics are not collected.
+ *
+ * A worker that closes its connection, fails to answer within shardTimeout
+ * or cannot be reached loses its shard, which goes back to the queue for the
+ * remaining workers; shards left when no worker remains are computed in
+ * this process. A pricing error reported by a worker is rethrown.
+ *
+ * Requests not priced by single-asset Monte Carlo (closed forms, PDE,
+ * baskets, issuer calls) go to priceAutocall unchanged. Local workers are
+ * new processes running workerProgram --stdin (posix_spawnp, the socket
+ * pair end as standard input), never forks of the calling process: they
+ * share none of its threads or locks. A program that cannot be started
+ * means one local worker fewer. The command-line coordinator is
+ * pricer_sharded.
+ */
+PricingResults priceAutocallSharded(const PricingInputs &inputs,
+                                    const ShardOptions &options);
+
+/**
+ * @brief Worker side: answers shard requests on the connected socket fd
+ * until the peer closes it (does not close fd). pricer_shard_worker runs it
+ * on every accepted connection, or on its standard input with --stdin.
+ */
+void serveShards(int fd);
@@ -7,6 +7,8 @@ public:
                  double spot0, double notional, double couponRate,
                  double callBarrier, double protectionBarrier);
 
-  double discountedPayoff(const std::vector<double> &path,
-                          double riskFreeRate) const override;
+private:
+  // Unsmoothed payoff of a path, recording its life in `events` when given.
+  double payoff(PathView path, const double *discountFactors,
+                LifeEvents *events) const override;
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "LocalVolMC.hpp"
+#include "PathModel.hpp"
+#include "UniformTable.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct HestonParameters {
+  double v0{0.04};
+  double kappa{1.5};
+  double theta{0.04};
+  double xi{0.5};
+  double rho{-0.5};
+};
+
+struct SlvSettings {
+  std::size_t particles{100000};     // Calibration population.
+  double stepsPerYear{100.0};        // Calibration and simulation step.
+  std::size_t logSpotNodes{101};     // Columns of the leverage table.
+  std::size_t minParticlesPerBin{50}; // Sparser bins borrow a neighbour.
+  unsigned int seed{20240601};       // Calibration stream (not the pricing one).
+  LocalVolSettings localVol{};
+};
+
+/**
+ * @brief Leverage function of a Heston stochastic local volatility model.
+ *
+ * The spot follows dS/S = r dt + L(t, x) sqrt(v) dW with x = log(S / F(t))
+ * and Heston variance v. Matching the Dupire local vol requires
+ *   L(t, x)^2 = sigma_loc(t, x)^2 / E[v_t | x_t = x].
+ * The conditional expectation is estimated with the particle method: a
+ * population of (x, v) particles is advanced step by step, and at each step
+ * the particles are binned on the x columns to get E[v | x], which fixes the
+ * leverage row used for the next step.
+ *
+ * Particles are split in fixed-size chunks, each with its own random stream,
+ * and chunk statistics are merged in chunk order: the calibration runs on
+ * every core and does not depend on the number of threads.
+ */
+class SlvLeverage {
+public:
+  SlvLeverage(const ImpliedVolSurface &surface,
+              const HestonParameters &heston, const SlvSettings &settings = {});
+
+  double operator()(double t, double x) const { return table_(t, x); }
+  const UniformTable &table() const { return table_; }
+  const HestonParameters &heston() const { return heston_; }
+  double stepsPerYear() const { return stepsPerYear_; }
+
+private:
+  HestonParameters heston_;
+  double stepsPerYear_{};
+  UniformTable table_;
+};
+
+/**
+ * @brief Monte Carlo path generator for the Heston stochastic local vol
+ * model, driven by a calibrated (and shareable) leverage table.
+ *
+ * Same scheme as the calibration: full-truncation Euler on (log(S/F), v),
+ * with sub-steps of at most 1/stepsPerYear ending on each observation date.
+ */
+class SlvMC : public PathModelBase {
+public:
+  explicit SlvMC(std::shared_ptr<const SlvLeverage> leverage);
+
+  // Two normals per sub-step.
+  std::size_t normalCount(const TimeGrid &grid) const override;
+  // Interval variances: sum(L^2 v h) over the sub-steps.
+  void buildPath(double spot0, const TimeGrid &grid, const double *normals,
+                 std::vector<double> &path,
+                 double *intervalVariance) const override;
+
+private:
+  std::shared_ptr<const SlvLeverage> leverage_;
+};
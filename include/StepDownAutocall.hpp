@@ -8,9 +8,12 @@ public:
                    double spot0, double notional, double couponRate,
                    std::vector<double> callBarriers, double protectionBarrier);
 
-  double discountedPayoff(const std::vector<double> &path,
-                          double riskFreeRate) const override;
+  ObservationRule observationRule(std::size_t i) const override;
 
 private:
+  // Unsmoothed payoff of a path, recording its life in `events` when given.
+  double payoff(PathView path, const double *discountFactors,
+                LifeEvents *events) const override;
+
   std::vector<double> callBarriers_;
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+// Stream sockets and length-prefixed frames shared by the pricing server
+// and the shard workers.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Listening socket on `address`: a Unix-domain socket path (any
+ * address containing '/', replacing a stale socket file) or "host:port"
+ * (TCP; "127.0.0.1:port" for local clients only, "0.0.0.0:port" for every
+ * interface).
+ * @throws std::runtime_error("Socket: ...") if it cannot be bound.
+ */
+int listenStream(const std::string &address);
+
+/**
+ * @brief Connected socket to `address` (same forms as listenStream).
+ * @throws std::runtime_error("Socket: ...") if the connection fails.
+ */
+int connectStream(const std::string &address);
+
+// Later reads on fd fail once no byte arrived for `timeout`.
+void setReceiveTimeout(int fd, std::chrono::milliseconds timeout);
+
+enum class FrameRead { Ok, Closed, TooLarge };
+
+/**
+ * @brief Reads one frame (4-byte big-endian length, then the payload) into
+ * `payload`, whose capacity is reused across frames.
+ * @return Closed on end of stream, error or timeout; TooLarge, without
+ * reading the payload, if it exceeds maxBytes.
+ */
+FrameRead readFrame(int fd, std::string &payload, std::size_t maxBytes);
+
+/**
+ * @brief Writes `payload` as one frame, assembled in `buffer` (reused
+ * across frames). A peer gone away is a false return, not a SIGPIPE.
+ */
+bool writeFrame(int fd, const std::string &payload, std::string &buffer);
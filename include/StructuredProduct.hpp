@@ -1,27 +1,201 @@
 #pragma once
 
+#include "SymbolTable.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+/**
+ * @brief Read-only, non-owning view over a simulated path.
+ *
+ * Lets payoffs run directly on memory they do not own (path caches,
+ * memory-mapped path stores) without copying into a std::vector.
+ */
+class PathView {
+public:
+  PathView(const double *data, std::size_t size) : data_(data), size_(size) {}
+  PathView(const std::vector<double> &path)
+      : data_(path.data()), size_(path.size()) {}
+
+  /**
+   * @brief Same view carrying Brownian-bridge data: the spot at t = 0 and
+   * the variance of log(S) over each interval (see PathModelBase).
+   */
+  PathView withBridge(double startSpot, const double *intervalVariance) const {
+    PathView view(*this);
+    view.startSpot_ = startSpot;
+    view.intervalVariance_ = intervalVariance;
+    return view;
+  }
+
+  double operator[](std::size_t i) const { return data_[i]; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  double back() const { return data_[size_ - 1]; }
+  const double *data() const { return data_; }
+  const double *begin() const { return data_; }
+  const double *end() const { return data_ + size_; }
+
+  bool hasBridge() const { return intervalVariance_ != nullptr; }
+  double startSpot() const { return startSpot_; }
+  const double *intervalVariance() const { return intervalVariance_; }
+
+private:
+  const double *data_;
+  std::size_t size_;
+  double startSpot_{};
+  const double *intervalVariance_{nullptr};
+};
+
+/**
+ * @brief How notes ended and which coupons they paid, summed over the paths
+ * they were evaluated on (one instance per thread, merged afterwards).
+ *
+ * Every path adds a total weight of one to the calls and the maturities:
+ * 1 at the date it ends, or fractions spread over dates when the barriers
+ * are smoothed (the weight of the note being alive and called there).
+ */
+class LifeEvents {
+public:
+  LifeEvents() = default;
+  explicit LifeEvents(std::size_t dates) : calls_(dates), coupons_(dates) {}
+
+  void called(std::size_t date, double weight = 1.0) {
+    calls_[date] += weight;
+  }
+  void matured(double weight = 1.0) { matured_ += weight; }
+  void couponPaid(std::size_t date, double weight = 1.0) {
+    coupons_[date] += weight;
+  }
+
+  // Adds the counts of other, which must cover the same dates.
+  void merge(const LifeEvents &other) {
+    if (other.calls_.size() != calls_.size()) {
+      throw std::runtime_error("LifeEvents: merging " +
+                               std::to_string(other.calls_.size()) +
+                               " dates into " +
+                               std::to_string(calls_.size()));
+    }
+    for (std::size_t i = 0; i < calls_.size(); ++i) {
+      calls_[i] += other.calls_[i];
+      coupons_[i] += other.coupons_[i];
+    }
+    matured_ += other.matured_;
+  }
+
+  // Early redemptions at each date (the last included: called at maturity).
+  const std::vector<double> &calls() const { return calls_; }
+  // Paths redeemed at maturity without being called.
+  double maturities() const { return matured_; }
+  const std::vector<double> &coupons() const { return coupons_; }
+
+private:
+  std::vector<double> calls_;
+  std::vector<double> coupons_;
+  double matured_{0.0};
+};
+
+// Monitoring of a barrier: on the final spot only, or at any time during the
+// life of the product (daily closes or continuously).
+enum class BarrierMonitoring { AtMaturity, Daily, Continuous };
+
 class StructuredProduct {
 public:
   StructuredProduct(std::string underlying,
                     std::vector<double> observationTimes)
       : underlying_(std::move(underlying)),
+        underlyingId_(internSymbol(underlying_)),
         observationTimes_(std::move(observationTimes)) {}
 
   virtual ~StructuredProduct() = default;
 
-  // Calcule directement le payoff total actualisé pour un chemin donné
-  virtual double discountedPayoff(const std::vector<double> &path,
-                                  double riskFreeRate) const = 0;
+  // Calcule directement le payoff total actualisé pour un chemin donné.
+  // discountFactors[i] is the discount factor of observationTimes()[i],
+  // sampled once per pricing (see TimeGrid).
+  virtual double discountedPayoff(PathView path,
+                                  const double *discountFactors) const = 0;
+
+  /**
+   * @brief Convenience form discounting at a flat continuously compounded
+   * rate (computes the discount factors on each call). Not an overload of
+   * discountedPayoff: products overriding that one would hide it.
+   */
+  double discountedPayoffAtRate(PathView path, double riskFreeRate) const;
+
+  /**
+   * @brief Same payoff, also recording in `events` when the note ends and
+   * the conditional coupons it pays (events must cover every observation
+   * date). The default records a redemption at maturity and no coupon;
+   * autocalls report their calls and coupons.
+   */
+  virtual double discountedPayoff(PathView path, const double *discountFactors,
+                                  LifeEvents &events) const {
+    events.matured();
+    return discountedPayoff(path, discountFactors);
+  }
+
+  /**
+   * @brief Discounted payoffs of `count` paths stored date-major
+   * (spots[i * count + p] is the spot of path p at date i), written to
+   * out[p]. One spot per date (single-asset layout), no bridge data.
+   *
+   * The default gathers each path and calls discountedPayoff; table-driven
+   * products override it with a kernel running date by date over the batch.
+   */
+  virtual void discountedPayoffs(const double *spots, std::size_t count,
+                                 const double *discountFactors,
+                                 double *out) const;
+
+  /**
+   * @brief Whether discountedPayoffs is a real batch kernel. Engines holding
+   * path-major paths only transpose them into batches when it is.
+   */
+  virtual bool hasBatchKernel() const { return false; }
+
+  /**
+   * @brief Whether discountedPayoff reads the bridge data of the path.
+   * Engines then simulate interval variances and pass them with the path.
+   */
+  virtual bool needsBridge() const { return false; }
 
   const std::vector<double> &observationTimes() const {
     return observationTimes_;
   }
   const std::string &underlying() const { return underlying_; }
+  // Interned once at construction; use it for market data lookups.
+  SymbolId underlyingId() const { return underlyingId_; }
 
 private:
   std::string underlying_;
+  SymbolId underlyingId_;
   std::vector<double> observationTimes_;
-};
\ No newline at end of file
+};
+
+inline double
+StructuredProduct::discountedPayoffAtRate(PathView path,
+                                          double riskFreeRate) const {
+  const auto &times = observationTimes();
+  // Never empty, so cliquets paying at t = 0 still get a valid pointer.
+  std::vector<double> discountFactors(times.empty() ? 1 : times.size(), 1.0);
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    discountFactors[i] = std::exp(-riskFreeRate * times[i]);
+  }
+  return discountedPayoff(path, discountFactors.data());
+}
+
+inline void StructuredProduct::discountedPayoffs(const double *spots,
+                                                 std::size_t count,
+                                                 const double *discountFactors,
+                                                 double *out) const {
+  const std::size_t dates = observationTimes().size();
+  std::vector<double> path(dates);
+  for (std::size_t p = 0; p < count; ++p) {
+    for (std::size_t i = 0; i < dates; ++i) {
+      path[i] = spots[i * count + p];
+    }
+    out[p] = discountedPayoff(path, discountFactors);
+  }
+}
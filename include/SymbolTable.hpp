@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Dense integer identifier of an interned underlying name.
+ */
+using SymbolId = std::uint32_t;
+
+/**
+ * @brief Returns the ID of a symbol, interning it on first use.
+ *
+ * IDs are process-wide, dense (0, 1, 2, ...) and stable for the lifetime of
+ * the process. Thread-safe; meant to be called when products and market data
+ * are built, not inside pricing loops.
+ */
+SymbolId internSymbol(const std::string& name);
+
+/**
+ * @brief Name of an interned symbol.
+ * @throws std::runtime_error if the ID was never issued.
+ */
+std::string symbolName(SymbolId id);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "DiscountCurve.hpp"
+#include "PathCache.hpp"
+#include "PricerRunner.hpp"
+
+#include <cstddef>
+#include <memory>
+
+// Product term solved for by TermSolver, and the PricingInputs member it sets.
+enum class SolveTarget {
+  Coupon,            // coupon
+  CallBarrier,       // autocallBarrier (a callBarriers schedule moves with it)
+  ProtectionBarrier, // protectionBarrier
+  AirbagFloor        // airbagFloor (Airbag autocalls only)
+};
+
+struct SolveResult {
+  double level{};         // Solved value of the term.
+  double stdError{};      // Monte Carlo error of the level (delta method;
+                          // infinite when the price is flat there).
+  double price{};         // Price at the solved level on the cached paths.
+  double priceStdError{};
+  std::size_t evaluations{}; // Payoff passes over the cached paths.
+};
+
+/**
+ * @brief Finds the term of an autocall that makes it price at a target.
+ *
+ * The paths of the inputs' model are simulated once into a PathCache at
+ * construction; every trial level then only rebuilds the product and
+ * re-evaluates its payoff on the cached paths, so all trials share the same
+ * draws and the price is a deterministic function of the level.
+ *
+ * The coupon enters every autocall payoff linearly, V(c) = A + c B path by
+ * path, so it is solved in closed form from two passes (c = 0 and c = 1).
+ * Barriers and the airbag floor are bracketed and solved by Illinois
+ * regula falsi; on a finite path set the price is piecewise constant in a
+ * barrier, so the bracket shrinks to the level where the price crosses the
+ * target.
+ *
+ * The error of the level is the price error at the solution divided by the
+ * slope dV/dlevel (exact for the coupon, a central difference of
+ * kSlopeBumpFraction of the level on the cached paths otherwise).
+ */
+class TermSolver {
+public:
+  /**
+   * @brief Simulates the paths of a single-asset autocall.
+   * @throws std::runtime_error("TermSolver: ...") for cliquets, term sheets,
+   * worst-of baskets, issuer-callable notes and protection barriers
+   * monitored during the life of the note (the cache keeps no bridge data).
+   */
+  explicit TermSolver(const PricingInputs &inputs);
+
+  /**
+   * @brief Solves for the term giving `targetPrice` (in currency, e.g.
+   * 0.98 * notional).
+   * @param lower, upper Bracket of the level; ignored for the coupon.
+   * @throws std::runtime_error if the price does not depend on the term or
+   * the target is not bracketed.
+   */
+  SolveResult solve(SolveTarget target, double targetPrice, double lower = 0.0,
+                    double upper = 0.0) const;
+
+  /**
+   * @brief Price and standard error on the cached paths with `target` set
+   * to `level`.
+   */
+  double price(SolveTarget target, double level, double &stdError) const;
+
+  // Relative bump of the level for the slope of the error estimate.
+  static constexpr double kSlopeBumpFraction = 0.01;
+
+private:
+  PricingInputs withLevel(SolveTarget target, double level) const;
+  SolveResult solveCoupon(double targetPrice) const;
+  SolveResult solveBracketed(SolveTarget target, double targetPrice,
+                             double lower, double upper) const;
+
+  PricingInputs inputs_;
+  DiscountCurve curve_;
+  std::unique_ptr<PathCache> cache_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Values on a uniform (time, x) grid with bilinear lookup.
+ *
+ * Rows cover [0, horizon] in time and columns [xMin, xMax]; lookups outside
+ * are clamped to the border. Both axes are uniform, so a lookup is two
+ * multiplications, two clamps and a bilinear blend, cheap enough for the
+ * inner loop of a path simulation.
+ */
+class UniformTable {
+public:
+  UniformTable() = default;
+  UniformTable(double horizon, std::size_t rows, double xMin, double xMax,
+               std::size_t cols)
+      : rows_(rows < 2 ? 2 : rows), cols_(cols < 2 ? 2 : cols),
+        invDt_(static_cast<double>(rows_ - 1) / horizon), xMin_(xMin),
+        invDx_(static_cast<double>(cols_ - 1) / (xMax - xMin)),
+        maxRow_(static_cast<double>(rows_ - 1)),
+        maxCol_(static_cast<double>(cols_ - 1)), values_(rows_ * cols_, 0.0) {}
+
+  std::size_t rows() const { return rows_; }
+  std::size_t cols() const { return cols_; }
+  double rowTime(std::size_t row) const {
+    return static_cast<double>(row) / invDt_;
+  }
+  double colX(std::size_t col) const {
+    return xMin_ + static_cast<double>(col) / invDx_;
+  }
+
+  double &at(std::size_t row, std::size_t col) {
+    return values_[row * cols_ + col];
+  }
+  double at(std::size_t row, std::size_t col) const {
+    return values_[row * cols_ + col];
+  }
+  double *row(std::size_t r) { return values_.data() + r * cols_; }
+
+  double operator()(double t, double x) const {
+    double ft = t * invDt_;
+    ft = ft < 0.0 ? 0.0 : (ft > maxRow_ ? maxRow_ : ft);
+    double fx = (x - xMin_) * invDx_;
+    fx = fx < 0.0 ? 0.0 : (fx > maxCol_ ? maxCol_ : fx);
+    std::size_t it = static_cast<std::size_t>(ft);
+    std::size_t ix = static_cast<std::size_t>(fx);
+    if (it + 1 >= rows_) it = rows_ - 2;
+    if (ix + 1 >= cols_) ix = cols_ - 2;
+    const double wt = ft - static_cast<double>(it);
+    const double wx = fx - static_cast<double>(ix);
+    const double *r0 = values_.data() + it * cols_ + ix;
+    const double *r1 = r0 + cols_;
+    const double v0 = r0[0] + wx * (r0[1] - r0[0]);
+    const double v1 = r1[0] + wx * (r1[1] - r1[0]);
+    return v0 + wt * (v1 - v0);
+  }
+
+  /**
+   * @brief Row-wise lookup in x only (time fixed to the given row).
+   */
+  double rowValue(std::size_t r, double x) const {
+    double fx = (x - xMin_) * invDx_;
+    fx = fx < 0.0 ? 0.0 : (fx > maxCol_ ? maxCol_ : fx);
+    std::size_t ix = static_cast<std::size_t>(fx);
+    if (ix + 1 >= cols_) ix = cols_ - 2;
+    const double wx = fx - static_cast<double>(ix);
+    const double *v = values_.data() + r * cols_ + ix;
+    return v[0] + wx * (v[1] - v[0]);
+  }
+
+  /**
+   * @brief Nearest column of x (clamped).
+   */
+  std::size_t nearestCol(double x) const {
+    double fx = (x - xMin_) * invDx_ + 0.5;
+    fx = fx < 0.0 ? 0.0 : (fx > maxCol_ ? maxCol_ : fx);
+    return static_cast<std::size_t>(fx);
+  }
+
+private:
+  std::size_t rows_{};
+  std::size_t cols_{};
+  double invDt_{};
+  double xMin_{};
+  double invDx_{};
+  double maxRow_{};
+  double maxCol_{};
+  std::vector<double> values_; // [row * cols_ + col]
+};
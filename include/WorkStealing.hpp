@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Parallel.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Work done by one worker of a runWorkStealing call.
+struct WorkerStats {
+  std::size_t tasks{};  // Tasks run, stolen ones included.
+  std::size_t stolen{}; // Tasks taken from another worker's deque.
+  double busySeconds{}; // Time spent inside tasks.
+  double cost{};        // Sum of the estimated costs of the tasks run.
+};
+
+struct SchedulerStats {
+  double wallSeconds{};
+  std::vector<WorkerStats> workers;
+
+  // Fraction of the workers' time spent inside tasks: busy time over
+  // workers x wall time (1 when no worker waited or stole).
+  double utilisation() const;
+};
+
+/**
+ * @brief Runs task(i) for every i in [0, costs.size()) on `threads` workers,
+ * each owning a deque of tasks, and returns what every worker did.
+ *
+ * costs[i] is an estimate of the run time of task i, in any unit. The tasks
+ * are dealt by decreasing cost to the deque of the least loaded worker, so
+ * the deques start with balanced estimated costs. A worker runs its own
+ * deque from the front (expensive tasks first); once it is empty, it steals
+ * from the back of the deque with the most estimated cost left, which
+ * corrects the errors of the cost model. Tasks do not create tasks, so a
+ * worker stops when every deque is empty.
+ *
+ * The workers are the calling thread and the threads of the shared pool
+ * (see parallelFor): concurrent calls share its workerCount() - 1 threads
+ * instead of starting their own. Inside another parallel loop the caller
+ * runs every deque alone. parallelFor loops inside a task borrow the pool
+ * threads left idle, unless the task marks itself InlineParallelLoops. The
+ * first exception thrown by a task stops the workers (tasks already started
+ * finish) and is rethrown.
+ */
+SchedulerStats runWorkStealing(const std::vector<double> &costs,
+                               const std::function<void(std::size_t)> &task,
+                               std::size_t threads = workerCount());
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "StructuredProduct.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Worst-of wrapper turning any single-asset product into a basket one.
+ *
+ * The wrapped product (typically an AutocallBase) is defined on a reference
+ * level: barriers and strikes are expressed in that level, as for a
+ * single-asset trade. Paths are read in the [date][asset] layout produced by
+ * MultiAssetPathModel; at each date the reference level is replaced by
+ *   referenceLevel * min_k S_k(t) / S_k(0)
+ * and the wrapped payoff is evaluated on that worst-performance path.
+ */
+class WorstOfProduct : public StructuredProduct {
+public:
+  /**
+   * @param product Single-asset product on the reference level.
+   * @param assets Names of the basket assets (MarketData keys).
+   * @param initialSpots Strike-date fixing of each asset.
+   * @param referenceLevel Level mapped to 100% performance.
+   */
+  WorstOfProduct(std::unique_ptr<StructuredProduct> product,
+                 std::vector<std::string> assets,
+                 std::vector<double> initialSpots, double referenceLevel);
+
+  /**
+   * @param path Joint path of size dates * assetCount(), [date][asset].
+   * @throws std::runtime_error if the path does not match the basket.
+   */
+  using StructuredProduct::discountedPayoff;
+  double discountedPayoff(PathView path,
+                          const double *discountFactors) const override;
+
+  const StructuredProduct &product() const { return *product_; }
+  const std::vector<std::string> &assets() const { return assets_; }
+  const std::vector<SymbolId> &assetIds() const { return assetIds_; }
+  std::size_t assetCount() const { return assets_.size(); }
+
+private:
+  std::unique_ptr<StructuredProduct> product_;
+  std::vector<std::string> assets_;
+  std::vector<SymbolId> assetIds_;
+  std::vector<double> inverseFixings_; // referenceLevel / S_k(0)
+};
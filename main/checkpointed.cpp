@@ -0,0 +1,97 @@
+#include "Json.hpp"
+#include "PricingJson.hpp"
+#include "RunCheckpoint.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace {
+void usage() {
+  std::fprintf(stderr,
+               "usage: pricer_checkpointed --checkpoint PATH [--resume]\n"
+               "                           [--interval-s N] [REQUEST.json]\n");
+}
+
+unsigned long numberArgument(const char *text) {
+  char *end = nullptr;
+  const unsigned long value = std::strtoul(text, &end, 10);
+  if (end == text || *end != '\0') {
+    throw std::runtime_error(std::string("invalid number: ") + text);
+  }
+  return value;
+}
+} // namespace
+
+// Long Monte Carlo run with checkpoints (priceAutocallCheckpointed): prices
+// the PricingInputs JSON object read from REQUEST.json (standard input by
+// default), saving its progress to PATH, and prints the PricingResults JSON
+// object. Run again with --resume after an interruption, with the same
+// request, to continue from PATH.
+int main(int argc, char *argv[]) {
+  CheckpointOptions options;
+  std::string requestPath;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string flag = argv[i];
+      if (flag == "--resume") {
+        options.resume = true;
+        continue;
+      }
+      if (flag.rfind("--", 0) != 0) {
+        if (!requestPath.empty()) {
+          usage();
+          return 2;
+        }
+        requestPath = flag;
+        continue;
+      }
+      if (i + 1 >= argc) {
+        usage();
+        return 2;
+      }
+      const char *value = argv[++i];
+      if (flag == "--checkpoint") {
+        options.path = value;
+      } else if (flag == "--interval-s") {
+        options.interval = std::chrono::seconds(numberArgument(value));
+      } else {
+        usage();
+        return 2;
+      }
+    }
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_checkpointed: %s\n", ex.what());
+    return 2;
+  }
+  if (options.path.empty()) {
+    usage();
+    return 2;
+  }
+
+  try {
+    std::string request;
+    if (requestPath.empty()) {
+      request.assign(std::istreambuf_iterator<char>(std::cin), {});
+    } else {
+      std::ifstream file(requestPath);
+      if (!file) {
+        throw std::runtime_error("cannot open " + requestPath);
+      }
+      request.assign(std::istreambuf_iterator<char>(file), {});
+    }
+    const PricingResults results = priceAutocallCheckpointed(
+        pricingInputsFromJson(JsonValue::parse(request)), options);
+    std::printf("%s\n", pricingResultsToJson(results).dump().c_str());
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_checkpointed: %s\n", ex.what());
+    return 1;
+  }
+  return 0;
+}
@@ -1,13 +1,7 @@
-#include "AirbagAutocall.hpp"
-#include "CliquetCappedCoupons.hpp"
-#include "CliquetMaxReturn.hpp"
 #include "InputUtils.hpp"
-#include "MemoryPhoenixAutocall.hpp"
-#include "PhoenixAutocall.hpp"
+#include "PayoffProfile.hpp"
 #include "PricerRunner.hpp"
-#include "SimpleAutocall.hpp"
-#include "StepDownAutocall.hpp"
-#include "StructuredProduct.hpp"
+#include "PricingJson.hpp"
 
 #include <QApplication>
 #include <QCloseEvent>
@@ -21,14 +15,17 @@
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QPen>
+#include <QPointF>
 #include <QPushButton>
 #include <QScrollArea>
 #include <QSettings>
 #include <QSizePolicy>
 #include <QString>
+#include <QThread>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <QtCharts/QAbstractAxis>
+#include <QtCharts/QAreaSeries>
 #include <QtCharts/QChart>
 #include <QtCharts/QChartGlobal>
 #include <QtCharts/QChartView>
@@ -36,19 +33,20 @@
 #include <QtCharts/QValueAxis>
 
 #include <algorithm> // Ajout nécessaire pour std::max
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
-// Minimal Qt window: handles user inputs, instantiates the chosen
-// product/model, runs pricing via PricerRunner, and renders a simple payoff
-// chart.
+// Minimal Qt window: handles user inputs, runs pricing via PricerRunner,
+// and charts the payoff profile and distribution of the chosen product.
 class PricerWindow : public QWidget {
   Q_OBJECT
 
 public:
   PricerWindow(QWidget *parent = nullptr);
+  ~PricerWindow() override;
 
 protected:
   void closeEvent(QCloseEvent *event) override;
@@ -69,11 +67,15 @@ private:
   void showError(const QString &message);
   PricingInputs gatherInputs() const;
   void updatePayoffChart();
+  void showPayoffProfile(const std::vector<PayoffProfileBin> &bins,
+                         const PricingInputs &inputs);
+  void clearPayoffProfile(const QString &message);
+  void updateBarrierMarkers(const PricingInputs &inputs, double minY,
+                            double maxY);
+  void updateDistributionChart(const PricingResults &results);
   void connectInputField(QLineEdit *edit);
   void connectInputs();
   std::vector<double> defaultCallBarrierList() const;
-  std::unique_ptr<StructuredProduct>
-  createProduct(const PricingInputs &inputs) const;
   void loadSettings();
   void saveSettings() const;
 
@@ -85,6 +87,8 @@ private:
   QComboBox *autocallCombo_{};
   QComboBox *cliquetCombo_{};
   QComboBox *modelCombo_{};
+  QComboBox *engineCombo_{};
+  QComboBox *redemptionCombo_{};
   QLineEdit *spotEdit_{};
   QLineEdit *volEdit_{};
   QLineEdit *rateEdit_{};
@@ -99,6 +103,8 @@ private:
   QLineEdit *seedEdit_{};
   QLineEdit *spreadEdit_{};
   QLineEdit *airbagEdit_{};
+  QComboBox *monitoringCombo_{};
+  QLineEdit *smoothingEdit_{};
   QLineEdit *cliquetParticipationEdit_{};
   QLineEdit *cliquetCapEdit_{};
   QLineEdit *hestonV0Edit_{};
@@ -110,11 +116,36 @@ private:
   QLabel *priceLabel_{};
   QLabel *stdErrorLabel_{};
   QLabel *deltaLabel_{};
+  QLabel *gammaLabel_{};
   QLabel *vegaLabel_{};
+  QLabel *vannaLabel_{};
+  QLabel *rhoLabel_{};
+  QLabel *thetaLabel_{};
   QLabel *bidLabel_{};
   QLabel *askLabel_{};
+  QLabel *valueAtRiskLabel_{};
+  QLabel *expectedShortfallLabel_{};
+  QLabel *capitalLossLabel_{};
+  QLabel *expectedLifeLabel_{};
   QLabel *chartLabel_{};
   QChartView *chartView_{};
+  // Payoff profile: series and axes built once, their points replaced on
+  // each update.
+  QLineSeries *profileMeanSeries_{};
+  QLineSeries *profileUpperSeries_{};
+  QLineSeries *profileLowerSeries_{};
+  QAreaSeries *profileBandSeries_{};
+  QValueAxis *profileAxisX_{};
+  QValueAxis *profileAxisY_{};
+  std::vector<QLineSeries *> barrierMarkers_;
+  // Worker computing the profile, one at a time; edits made meanwhile are
+  // coalesced into one more run when it finishes.
+  QThread *profileThread_{};
+  bool profilePending_{false};
+  QString profileKey_; // Inputs of the profile shown (JSON), if any.
+  std::shared_ptr<const PayoffProfile> profile_; // Paths reused across edits.
+  QLabel *distributionLabel_{};
+  QChartView *distributionView_{};
 
   QGroupBox *productGroup_{};
   QGroupBox *cliquetGroup_{};
@@ -175,6 +206,18 @@ PricerWindow::PricerWindow(QWidget *parent) : QWidget(parent) {
   modelCombo_ = new QComboBox();
   modelCombo_->addItem("Black-Scholes");
   modelCombo_->addItem("Heston");
+  engineCombo_ = new QComboBox();
+  engineCombo_->addItem("Monte Carlo");
+  engineCombo_->addItem("PDE (Crank-Nicolson)");
+  engineCombo_->addItem("Auto (closed form if available)");
+  engineCombo_->setCurrentIndex(2);
+  engineCombo_->setToolTip(
+      "Auto prices Black-Scholes cliquets in closed form and the eligible "
+      "Black-Scholes autocalls by quadrature; everything else runs Monte "
+      "Carlo.");
+  redemptionCombo_ = new QComboBox();
+  redemptionCombo_->addItem("Contractual only");
+  redemptionCombo_->addItem("Issuer callable (LSM)");
   spotEdit_ = new QLineEdit(doubleToQString(defaults_.spot));
   volEdit_ = new QLineEdit(doubleToQString(defaults_.sigma));
   rateEdit_ = new QLineEdit(doubleToQString(defaults_.rate));
@@ -197,6 +240,8 @@ PricerWindow::PricerWindow(QWidget *parent) : QWidget(parent) {
   generalForm->addRow("Cliquet type", cliquetCombo_);
   cliquetLabel_ = generalForm->labelForField(cliquetCombo_);
   generalForm->addRow("Model", modelCombo_);
+  generalForm->addRow("Engine", engineCombo_);
+  generalForm->addRow("Early redemption", redemptionCombo_);
   generalForm->addRow("Spot", spotEdit_);
   generalForm->addRow("Rate", rateEdit_);
   generalForm->addRow("Notional", notionalEdit_);
@@ -220,6 +265,13 @@ PricerWindow::PricerWindow(QWidget *parent) : QWidget(parent) {
   airbagEdit_ = new QLineEdit(doubleToQString(defaults_.airbagFloor));
   productLayout_->addRow("Airbag floor", airbagEdit_);
   airbagLabel_ = productLayout_->labelForField(airbagEdit_);
+  monitoringCombo_ = new QComboBox();
+  monitoringCombo_->addItem("At maturity");
+  monitoringCombo_->addItem("Daily");
+  monitoringCombo_->addItem("Continuous");
+  productLayout_->addRow("Protection monitoring", monitoringCombo_);
+  smoothingEdit_ = new QLineEdit(doubleToQString(defaults_.barrierSmoothing));
+  productLayout_->addRow("Barrier smoothing", smoothingEdit_);
   leftLayout->addWidget(productGroup_);
 
   // Cliquet-specific parameters (participation/cap for capped coupons).
@@ -269,16 +321,32 @@ PricerWindow::PricerWindow(QWidget *parent) : QWidget(parent) {
   priceLabel_ = new QLabel("-");
   stdErrorLabel_ = new QLabel("-");
   deltaLabel_ = new QLabel("-");
+  gammaLabel_ = new QLabel("-");
   vegaLabel_ = new QLabel("-");
+  vannaLabel_ = new QLabel("-");
+  rhoLabel_ = new QLabel("-");
+  thetaLabel_ = new QLabel("-");
   bidLabel_ = new QLabel("-");
   askLabel_ = new QLabel("-");
+  valueAtRiskLabel_ = new QLabel("-");
+  expectedShortfallLabel_ = new QLabel("-");
+  capitalLossLabel_ = new QLabel("-");
+  expectedLifeLabel_ = new QLabel("-");
 
   resultsLayout->addRow("Price", priceLabel_);
   resultsLayout->addRow("Std error", stdErrorLabel_);
   resultsLayout->addRow("Delta", deltaLabel_);
+  resultsLayout->addRow("Gamma", gammaLabel_);
   resultsLayout->addRow("Vega", vegaLabel_);
+  resultsLayout->addRow("Vanna", vannaLabel_);
+  resultsLayout->addRow("Rho", rhoLabel_);
+  resultsLayout->addRow("Theta", thetaLabel_);
   resultsLayout->addRow("Bid", bidLabel_);
   resultsLayout->addRow("Ask", askLabel_);
+  resultsLayout->addRow("VaR 99%", valueAtRiskLabel_);
+  resultsLayout->addRow("ES 99%", expectedShortfallLabel_);
+  resultsLayout->addRow("P(capital loss)", capitalLossLabel_);
+  resultsLayout->addRow("Expected life", expectedLifeLabel_);
 
   leftLayout->addLayout(resultsLayout);
   leftLayout->addStretch();
@@ -292,18 +360,53 @@ PricerWindow::PricerWindow(QWidget *parent) : QWidget(parent) {
   inputScroll_->setWidget(inputContainer_);
   mainLayout->addWidget(inputScroll_, 2);
 
-  // Right side: payoff chart + legend (non-scrolling).
+  // Right side: payoff chart + legend, and the simulated payoff distribution
+  // below it (non-scrolling).
   auto *rightContainer = new QWidget();
   auto *rightLayout = new QVBoxLayout(rightContainer);
   rightLayout->setContentsMargins(0, 0, 0, 0);
   rightLayout->setSpacing(10);
-  chartLabel_ = new QLabel("Terminal payoff (linear scenario)");
+  chartLabel_ = new QLabel("Expected payoff given the terminal spot");
   chartView_ = new QChartView(new QChart());
   chartView_->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
   chartView_->setRenderHint(QPainter::Antialiasing);
-  chartView_->chart()->legend()->setVisible(false);
+  {
+    QChart *chart = chartView_->chart();
+    profileMeanSeries_ = new QLineSeries();
+    profileMeanSeries_->setName("Expected payoff");
+    profileUpperSeries_ = new QLineSeries(this);
+    profileLowerSeries_ = new QLineSeries(this);
+    profileBandSeries_ =
+        new QAreaSeries(profileUpperSeries_, profileLowerSeries_);
+    profileBandSeries_->setName(
+        QString("%1%-%2% of paths")
+            .arg(100.0 * PayoffProfile::kLowerBand, 0, 'f', 0)
+            .arg(100.0 * PayoffProfile::kUpperBand, 0, 'f', 0));
+    profileBandSeries_->setColor(QColor(21, 101, 192, 60));
+    profileBandSeries_->setBorderColor(QColor(21, 101, 192, 60));
+    chart->addSeries(profileBandSeries_);
+    chart->addSeries(profileMeanSeries_);
+    profileAxisX_ = new QValueAxis();
+    profileAxisX_->setTitleText("Terminal spot S_T");
+    profileAxisY_ = new QValueAxis();
+    profileAxisY_->setTitleText("Discounted payoff");
+    chart->addAxis(profileAxisX_, Qt::AlignBottom);
+    chart->addAxis(profileAxisY_, Qt::AlignLeft);
+    profileBandSeries_->attachAxis(profileAxisX_);
+    profileBandSeries_->attachAxis(profileAxisY_);
+    profileMeanSeries_->attachAxis(profileAxisX_);
+    profileMeanSeries_->attachAxis(profileAxisY_);
+  }
   rightLayout->addWidget(chartLabel_);
   rightLayout->addWidget(chartView_, 1);
+  distributionLabel_ = new QLabel("Payoff distribution (Monte Carlo only)");
+  distributionView_ = new QChartView(new QChart());
+  distributionView_->setSizePolicy(QSizePolicy::Expanding,
+                                   QSizePolicy::Expanding);
+  distributionView_->setRenderHint(QPainter::Antialiasing);
+  distributionView_->chart()->legend()->setVisible(false);
+  rightLayout->addWidget(distributionLabel_);
+  rightLayout->addWidget(distributionView_, 1);
   mainLayout->addWidget(rightContainer, 3);
   mainLayout->setStretch(0, 2);
   mainLayout->setStretch(1, 3);
@@ -407,6 +510,18 @@ PricingInputs PricerWindow::gatherInputs() const {
   }
   inputs.modelType = modelCombo_->currentIndex() == 1 ? ModelType::Heston
                                                       : ModelType::BlackScholes;
+  switch (engineCombo_->currentIndex()) {
+  case 1:
+    inputs.engineType = EngineType::Pde;
+    break;
+  case 2:
+    inputs.engineType = EngineType::Auto;
+    break;
+  default:
+    inputs.engineType = EngineType::MonteCarlo;
+    break;
+  }
+  inputs.issuerCallable = redemptionCombo_->currentIndex() == 1;
   inputs.spot = readDouble(spotEdit_, defaults_.spot);
   inputs.sigma = readDouble(volEdit_, defaults_.sigma);
   inputs.rate = readDouble(rateEdit_, defaults_.rate);
@@ -426,6 +541,21 @@ PricingInputs PricerWindow::gatherInputs() const {
       inputs.autocallType == AutocallType::Airbag) {
     inputs.airbagFloor = readDouble(airbagEdit_, defaults_.airbagFloor);
   }
+  if (inputs.productFamily == ProductFamily::Autocall) {
+    switch (monitoringCombo_->currentIndex()) {
+    case 1:
+      inputs.protectionMonitoring = BarrierMonitoring::Daily;
+      break;
+    case 2:
+      inputs.protectionMonitoring = BarrierMonitoring::Continuous;
+      break;
+    default:
+      inputs.protectionMonitoring = BarrierMonitoring::AtMaturity;
+      break;
+    }
+    inputs.barrierSmoothing =
+        readDouble(smoothingEdit_, defaults_.barrierSmoothing);
+  }
   if (inputs.productFamily == ProductFamily::Cliquet) {
     inputs.cliquetParticipation =
         readDouble(cliquetParticipationEdit_, defaults_.cliquetParticipation);
@@ -453,6 +583,7 @@ void PricerWindow::handlePrice() {
     const PricingResults results = priceAutocall(inputs);
     updateResults(results);
     updatePayoffChart();
+    updateDistributionChart(results);
   } catch (const std::exception &ex) {
     showError(QString::fromStdString(ex.what()));
   }
@@ -462,9 +593,46 @@ void PricerWindow::updateResults(const PricingResults &results) {
   priceLabel_->setText(QString::number(results.price, 'f', 4));
   stdErrorLabel_->setText(QString::number(results.stdError, 'f', 4));
   deltaLabel_->setText(QString::number(results.delta, 'f', 4));
+  gammaLabel_->setText(QString::number(results.gamma, 'g', 4));
   vegaLabel_->setText(QString::number(results.vega, 'f', 4));
+  vannaLabel_->setText(QString::number(results.vanna, 'g', 4));
+  rhoLabel_->setText(QString::number(results.rho, 'f', 4));
+  thetaLabel_->setText(QString::number(results.theta, 'f', 4));
   bidLabel_->setText(QString::number(results.bid, 'f', 4));
   askLabel_->setText(QString::number(results.ask, 'f', 4));
+  const PayoffDistributionSummary &distribution = results.distribution;
+  if (distribution.quantiles.empty()) {
+    valueAtRiskLabel_->setText("-");
+    expectedShortfallLabel_->setText("-");
+    capitalLossLabel_->setText("-");
+  } else {
+    valueAtRiskLabel_->setText(
+        QString::number(distribution.valueAtRisk99, 'f', 4));
+    expectedShortfallLabel_->setText(
+        QString::number(distribution.expectedShortfall99, 'f', 4));
+    capitalLossLabel_->setText(
+        QString::number(100.0 * distribution.capitalLossProbability, 'f', 2) +
+        " %");
+  }
+  const AutocallLifeSummary &life = results.life;
+  if (life.callProbabilities.empty()) {
+    expectedLifeLabel_->setText("-");
+    expectedLifeLabel_->setToolTip(QString());
+  } else {
+    expectedLifeLabel_->setText(QString::number(life.expectedLife, 'f', 2) +
+                                " y");
+    // Per-date detail for sales: call and coupon probabilities.
+    QString detail = "Date: P(call) / P(coupon)";
+    for (std::size_t i = 0; i < life.callProbabilities.size(); ++i) {
+      detail += QString("\n%1: %2 % / %3 %")
+                    .arg(i + 1)
+                    .arg(100.0 * life.callProbabilities[i], 0, 'f', 1)
+                    .arg(100.0 * life.couponProbabilities[i], 0, 'f', 1);
+    }
+    detail += QString("\nMaturity without call: %1 %")
+                  .arg(100.0 * life.maturityProbability, 0, 'f', 1);
+    expectedLifeLabel_->setToolTip(detail);
+  }
 }
 
 void PricerWindow::showError(const QString &message) {
@@ -567,6 +735,7 @@ void PricerWindow::connectInputs() {
   connectInputField(seedEdit_);
   connectInputField(spreadEdit_);
   connectInputField(airbagEdit_);
+  connectInputField(smoothingEdit_);
   connectInputField(cliquetParticipationEdit_);
   connectInputField(cliquetCapEdit_);
   connectInputField(hestonV0Edit_);
@@ -595,182 +764,245 @@ void PricerWindow::saveSettings() const {
   settings.setValue("geometry", saveGeometry());
 }
 
-// Build the correct StructuredProduct for the chosen family/type.
-std::unique_ptr<StructuredProduct>
-PricerWindow::createProduct(const PricingInputs &inputs) const {
-  if (inputs.productFamily == ProductFamily::Autocall) {
-    switch (inputs.autocallType) {
-    case AutocallType::Simple:
-      return std::make_unique<SimpleAutocall>(
-          inputs.underlying, inputs.observationTimes, inputs.spot,
-          inputs.notional, inputs.coupon, inputs.autocallBarrier,
-          inputs.protectionBarrier);
-    case AutocallType::Phoenix:
-      return std::make_unique<PhoenixAutocall>(
-          inputs.underlying, inputs.observationTimes, inputs.spot,
-          inputs.notional, inputs.coupon, inputs.autocallBarrier,
-          inputs.protectionBarrier, inputs.couponBarrier);
-    case AutocallType::MemoryPhoenix:
-      return std::make_unique<MemoryPhoenixAutocall>(
-          inputs.underlying, inputs.observationTimes, inputs.spot,
-          inputs.notional, inputs.coupon, inputs.autocallBarrier,
-          inputs.protectionBarrier, inputs.couponBarrier);
-    case AutocallType::StepDown: {
-      std::vector<double> schedule = inputs.callBarriers;
-      if (schedule.empty()) {
-        schedule.assign(inputs.observationTimes.size(), inputs.autocallBarrier);
-      }
-      return std::make_unique<StepDownAutocall>(
-          inputs.underlying, inputs.observationTimes, inputs.spot,
-          inputs.notional, inputs.coupon, schedule, inputs.protectionBarrier);
-    }
-    case AutocallType::Airbag:
-      return std::make_unique<AirbagAutocall>(
-          inputs.underlying, inputs.observationTimes, inputs.spot,
-          inputs.notional, inputs.coupon, inputs.autocallBarrier,
-          inputs.protectionBarrier, inputs.airbagFloor);
-    }
-  } else {
-    switch (inputs.cliquetType) {
-    case CliquetType::MaxReturn:
-      return std::make_unique<CliquetMaxReturn>(inputs.underlying,
-                                                inputs.observationTimes,
-                                                inputs.spot, inputs.notional);
-    case CliquetType::CappedCoupons:
-      return std::make_unique<CliquetCappedCoupons>(
-          inputs.underlying, inputs.observationTimes, inputs.spot,
-          inputs.notional, inputs.cliquetParticipation, inputs.cliquetCap);
-    }
+PricerWindow::~PricerWindow() {
+  // The worker posts its result to this window: let it finish first.
+  if (profileThread_) {
+    profileThread_->wait();
   }
-  return nullptr;
 }
 
-// Refresh the payoff chart.
-// Uses a simulated linear path (S0 -> ST) to estimate payoff for visualization.
+// Refresh the payoff chart: the expected payoff given the terminal spot and
+// its band, computed on a worker thread from simulated paths (see
+// PayoffProfile). The paths are kept while only the spot, curve or product
+// terms change, so most edits only re-evaluate payoffs.
 void PricerWindow::updatePayoffChart() {
-  QChart *chart = chartView_->chart();
-  try {
-    const PricingInputs inputs = gatherInputs();
-    auto product = createProduct(inputs);
-    if (!product) {
-      chart->removeAllSeries();
-      return;
+  const PricingInputs inputs = gatherInputs();
+  const QString key =
+      QString::fromStdString(pricingInputsToJson(inputs).dump());
+  if (key == profileKey_) {
+    return; // editingFinished without a change.
+  }
+  if (profileThread_) {
+    profilePending_ = true;
+    return;
+  }
+  const std::shared_ptr<const PayoffProfile> cached = profile_;
+  profileThread_ = QThread::create([this, key, inputs, cached]() {
+    try {
+      const std::shared_ptr<const PayoffProfile> profile =
+          cached && cached->covers(inputs)
+              ? cached
+              : std::make_shared<const PayoffProfile>(inputs);
+      const std::vector<PayoffProfileBin> bins = profile->compute(inputs);
+      QMetaObject::invokeMethod(
+          this,
+          [this, key, inputs, profile, bins]() {
+            // Recorded on success only: a failed profile is retried on the
+            // next edit, even back to the same inputs.
+            profileKey_ = key;
+            profile_ = profile;
+            showPayoffProfile(bins, inputs);
+          },
+          Qt::QueuedConnection);
+    } catch (const std::exception &ex) {
+      const QString message = QString::fromStdString(ex.what());
+      QMetaObject::invokeMethod(
+          this,
+          [this, message]() {
+            profileKey_.clear();
+            clearPayoffProfile(message);
+          },
+          Qt::QueuedConnection);
     }
-    if (inputs.productFamily == ProductFamily::Cliquet) {
-      chartLabel_->setText(
-          "Cliquet payoff shown for a reference linear path (path-dependent)");
-    } else {
-      chartLabel_->setText("Terminal payoff (linear scenario)");
+  });
+  profileThread_->setParent(this);
+  connect(profileThread_, &QThread::finished, this, [this]() {
+    profileThread_->deleteLater();
+    profileThread_ = nullptr;
+    if (profilePending_) {
+      profilePending_ = false;
+      updatePayoffChart();
     }
+  });
+  profileThread_->start();
+}
 
-    const double spot = std::max(inputs.spot, 1.0);
-    const double maxSpot = spot * 1.5;
-    constexpr int samples = 200;
-    auto *payoffSeries = new QLineSeries();
-    payoffSeries->setName("Redemption");
-
-    double minY = std::numeric_limits<double>::max();
-    double maxYValue = std::numeric_limits<double>::lowest();
-
-    const auto &times = product->observationTimes();
-    const double finalTime = times.empty() ? 1.0 : times.back();
-
-    for (int i = 0; i < samples; ++i) {
-      const double st =
-          maxSpot * static_cast<double>(i) / static_cast<double>(samples - 1);
-
-      // Build a synthetic linear path from S0 to ST
-      std::vector<double> path;
-      path.reserve(times.size());
-      for (double t : times) {
-        // S(t) = S0 + (ST - S0) * (t / T)
-        double val = inputs.spot + (st - inputs.spot) * (t / finalTime);
-        if (val < 0.0)
-          val = 0.0;
-        path.push_back(val);
-      }
-
-      // Calculate total payoff (sum of all flows)
-      // Use 0.0 rate to get the raw sum of flows for the chart
-      double totalPayoff = product->discountedPayoff(path, 0.0);
-
-      payoffSeries->append(st, totalPayoff);
-      minY = std::min(minY, totalPayoff);
-      maxYValue = std::max(maxYValue, totalPayoff);
-    }
+void PricerWindow::showPayoffProfile(const std::vector<PayoffProfileBin> &bins,
+                                     const PricingInputs &inputs) {
+  if (bins.empty()) {
+    clearPayoffProfile("No payoff profile");
+    return;
+  }
+  QList<QPointF> mean, upper, lower;
+  double minY = std::numeric_limits<double>::max();
+  double maxY = std::numeric_limits<double>::lowest();
+  for (const PayoffProfileBin &bin : bins) {
+    mean.append(QPointF(bin.terminalSpot, bin.mean));
+    upper.append(QPointF(bin.terminalSpot, bin.upper));
+    lower.append(QPointF(bin.terminalSpot, bin.lower));
+    minY = std::min(minY, bin.lower);
+    maxY = std::max(maxY, bin.upper);
+  }
+  const double margin = maxY > minY ? 0.05 * (maxY - minY)
+                                    : 0.05 * std::max(std::abs(maxY), 1.0);
+  minY -= margin;
+  maxY += margin;
+
+  profileMeanSeries_->replace(mean);
+  profileUpperSeries_->replace(upper);
+  profileLowerSeries_->replace(lower);
+  profileAxisX_->setRange(bins.front().terminalSpot, bins.back().terminalSpot);
+  profileAxisY_->setRange(minY, maxY);
+  updateBarrierMarkers(inputs, minY, maxY);
+  chartLabel_->setText(
+      QString("Expected discounted payoff given the terminal spot "
+              "(%1 simulated paths)")
+          .arg(profile_ ? profile_->pathCount() : 0));
+}
 
-    if (minY == maxYValue) {
-      minY *= 0.9;
-      maxYValue *= 1.1;
-    }
+void PricerWindow::clearPayoffProfile(const QString &message) {
+  profileMeanSeries_->clear();
+  profileUpperSeries_->clear();
+  profileLowerSeries_->clear();
+  updateBarrierMarkers(PricingInputs{}, 0.0, 0.0);
+  chartLabel_->setText(message);
+}
 
-    chart->removeAllSeries();
-    const auto axes = chart->axes();
-    for (QAbstractAxis *axis : axes) {
-      chart->removeAxis(axis);
-      delete axis;
-    }
-    chart->addSeries(payoffSeries);
-
-    auto *axisX = new QValueAxis();
-    axisX->setRange(0.0, maxSpot);
-    axisX->setTitleText("Terminal spot S_T");
-    auto *axisY = new QValueAxis();
-    axisY->setRange(minY, maxYValue);
-    axisY->setTitleText("Total Payoff (Redemption + Coupons)");
-    chart->addAxis(axisX, Qt::AlignBottom);
-    chart->addAxis(axisY, Qt::AlignLeft);
-    payoffSeries->attachAxis(axisX);
-    payoffSeries->attachAxis(axisY);
-
-    auto addMarker = [&](double x, const QString &label, const QColor &color) {
-      if (x <= 0.0 || x > axisX->max()) {
-        return;
-      }
-      auto *marker = new QLineSeries();
-      marker->setName(label);
-      QPen pen(color);
-      pen.setStyle(Qt::DashLine);
-      pen.setWidthF(1.0);
-      marker->setPen(pen);
-      marker->append(x, minY);
-      marker->append(x, maxYValue);
-      chart->addSeries(marker);
-      marker->attachAxis(axisX);
-      marker->attachAxis(axisY);
-    };
-
-    if (inputs.productFamily == ProductFamily::Autocall) {
-      addMarker(inputs.protectionBarrier, "Protection barrier",
-                QColor("#c62828"));
-      if (inputs.autocallType == AutocallType::StepDown) {
-        std::vector<double> schedule = inputs.callBarriers;
-        if (schedule.empty()) {
-          schedule.assign(inputs.observationTimes.size(),
-                          inputs.autocallBarrier);
-        }
-        for (double barrier : schedule) {
-          addMarker(barrier, "Call barrier", QColor("#1565c0"));
-        }
-      } else {
-        addMarker(inputs.autocallBarrier, "Call barrier", QColor("#1565c0"));
+// Barrier levels as dashed vertical lines; the series are reused from one
+// update to the next.
+void PricerWindow::updateBarrierMarkers(const PricingInputs &inputs,
+                                        double minY, double maxY) {
+  struct Marker {
+    double x;
+    QString label;
+    QColor color;
+  };
+  std::vector<Marker> markers;
+  if (maxY > minY && inputs.productFamily == ProductFamily::Autocall &&
+      inputs.termSheet.empty()) {
+    markers.push_back(
+        {inputs.protectionBarrier, "Protection barrier", QColor("#c62828")});
+    if (inputs.autocallType == AutocallType::StepDown) {
+      std::vector<double> schedule = inputs.callBarriers;
+      if (schedule.empty()) {
+        schedule.assign(inputs.observationTimes.size(),
+                        inputs.autocallBarrier);
       }
-
-      if (inputs.autocallType == AutocallType::Phoenix ||
-          inputs.autocallType == AutocallType::MemoryPhoenix) {
-        addMarker(inputs.couponBarrier, "Coupon barrier", QColor("#2e7d32"));
+      for (double barrier : schedule) {
+        markers.push_back({barrier, "Call barrier", QColor("#1565c0")});
       }
+    } else {
+      markers.push_back(
+          {inputs.autocallBarrier, "Call barrier", QColor("#1565c0")});
     }
-
-    chart->legend()->setVisible(chart->series().size() > 1);
-  } catch (...) {
-    chart->removeAllSeries();
-    const auto axes = chart->axes();
-    for (QAbstractAxis *axis : axes) {
-      chart->removeAxis(axis);
-      delete axis;
+    if (inputs.autocallType == AutocallType::Phoenix ||
+        inputs.autocallType == AutocallType::MemoryPhoenix) {
+      markers.push_back(
+          {inputs.couponBarrier, "Coupon barrier", QColor("#2e7d32")});
     }
   }
+  markers.erase(std::remove_if(markers.begin(), markers.end(),
+                               [&](const Marker &marker) {
+                                 return marker.x < profileAxisX_->min() ||
+                                        marker.x > profileAxisX_->max();
+                               }),
+                markers.end());
+
+  QChart *chart = chartView_->chart();
+  while (barrierMarkers_.size() > markers.size()) {
+    chart->removeSeries(barrierMarkers_.back());
+    delete barrierMarkers_.back();
+    barrierMarkers_.pop_back();
+  }
+  while (barrierMarkers_.size() < markers.size()) {
+    auto *series = new QLineSeries();
+    chart->addSeries(series);
+    series->attachAxis(profileAxisX_);
+    series->attachAxis(profileAxisY_);
+    barrierMarkers_.push_back(series);
+  }
+  for (std::size_t k = 0; k < markers.size(); ++k) {
+    QLineSeries *series = barrierMarkers_[k];
+    series->setName(markers[k].label);
+    QPen pen(markers[k].color);
+    pen.setStyle(Qt::DashLine);
+    pen.setWidthF(1.0);
+    series->setPen(pen);
+    series->replace(QList<QPointF>{QPointF(markers[k].x, minY),
+                                   QPointF(markers[k].x, maxY)});
+  }
+}
+
+// Histogram of the discounted payoffs of the last Monte Carlo price, as a
+// step line, with the price and the 1% quantile marked.
+void PricerWindow::updateDistributionChart(const PricingResults &results) {
+  QChart *chart = distributionView_->chart();
+  chart->removeAllSeries();
+  const auto axes = chart->axes();
+  for (QAbstractAxis *axis : axes) {
+    chart->removeAxis(axis);
+    delete axis;
+  }
+  const PayoffDistributionSummary &distribution = results.distribution;
+  if (distribution.histogram.empty()) {
+    distributionLabel_->setText("Payoff distribution (Monte Carlo only)");
+    chart->legend()->setVisible(false);
+    return;
+  }
+  distributionLabel_->setText("Discounted payoff distribution (% of paths)");
+
+  auto *histogramSeries = new QLineSeries();
+  histogramSeries->setName("Paths");
+  const double low = distribution.histogramLow;
+  const double width = distribution.histogramWidth;
+  const double high =
+      low + width * static_cast<double>(distribution.histogram.size());
+  double maxY = 0.0;
+  histogramSeries->append(low, 0.0);
+  for (std::size_t b = 0; b < distribution.histogram.size(); ++b) {
+    const double percent = 100.0 * distribution.histogram[b];
+    const double left = low + width * static_cast<double>(b);
+    histogramSeries->append(left, percent);
+    histogramSeries->append(left + width, percent);
+    maxY = std::max(maxY, percent);
+  }
+  histogramSeries->append(high, 0.0);
+  if (maxY <= 0.0) {
+    maxY = 1.0;
+  }
+  chart->addSeries(histogramSeries);
+
+  auto *axisX = new QValueAxis();
+  axisX->setRange(low, high);
+  axisX->setTitleText("Discounted payoff");
+  auto *axisY = new QValueAxis();
+  axisY->setRange(0.0, maxY * 1.05);
+  axisY->setTitleText("% of paths");
+  chart->addAxis(axisX, Qt::AlignBottom);
+  chart->addAxis(axisY, Qt::AlignLeft);
+  histogramSeries->attachAxis(axisX);
+  histogramSeries->attachAxis(axisY);
+
+  auto addMarker = [&](double x, const QString &label, const QColor &color) {
+    if (x < low || x > high) {
+      return;
+    }
+    auto *marker = new QLineSeries();
+    marker->setName(label);
+    QPen pen(color);
+    pen.setStyle(Qt::DashLine);
+    pen.setWidthF(1.0);
+    marker->setPen(pen);
+    marker->append(x, 0.0);
+    marker->append(x, maxY * 1.05);
+    chart->addSeries(marker);
+    marker->attachAxis(axisX);
+    marker->attachAxis(axisY);
+  };
+  addMarker(results.price, "Price", QColor("#1565c0"));
+  // kPayoffQuantileLevels starts at the 1% level.
+  addMarker(distribution.quantiles.front(), "1% quantile", QColor("#c62828"));
+  chart->legend()->setVisible(true);
 }
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,91 @@
+#include "PricerRunner.hpp"
+#include "WorkStealing.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <vector>
+
+// Prints the portfolio scaling line of the README: a heterogeneous book
+// (short and long Black-Scholes and Heston notes, a smoothed step-down, a
+// worst-of, an issuer-callable note, a Heston cliquet and a quadrature
+// price) priced trade after trade with priceAutocall, then at once with
+// priceAutocallPortfolio, on workerCount() threads (set PRICER_THREADS to
+// compare). Usage:
+//   pricer_portfolio_bench [PATHS]
+int main(int argc, char *argv[]) {
+  const std::size_t paths =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+
+  std::vector<PricingInputs> book;
+  PricingInputs shortNote;
+  shortNote.engineType = EngineType::MonteCarlo;
+  shortNote.paths = paths;
+  book.push_back(shortNote);
+
+  PricingInputs longHeston = shortNote;
+  longHeston.modelType = ModelType::Heston;
+  longHeston.autocallType = AutocallType::MemoryPhoenix;
+  longHeston.paths = 3 * paths;
+  longHeston.seed = 7;
+  longHeston.observationTimes.clear();
+  for (int i = 1; i <= 28; ++i) {
+    longHeston.observationTimes.push_back(0.25 * i);
+  }
+  book.push_back(longHeston);
+
+  PricingInputs stepDown = shortNote;
+  stepDown.autocallType = AutocallType::StepDown;
+  stepDown.barrierSmoothing = 0.02;
+  stepDown.paths = paths / 4;
+  book.push_back(stepDown);
+
+  PricingInputs worstOf = shortNote;
+  worstOf.basket = {{"A", 4000.0, 0.20, 0.04}, {"B", 4000.0, 0.25, 0.04}};
+  book.push_back(worstOf);
+
+  PricingInputs callable = shortNote;
+  callable.issuerCallable = true;
+  callable.lsmRegressionPaths = paths / 2;
+  book.push_back(callable);
+
+  PricingInputs cliquet = shortNote;
+  cliquet.modelType = ModelType::Heston;
+  cliquet.productFamily = ProductFamily::Cliquet;
+  book.push_back(cliquet);
+
+  PricingInputs quadrature;
+  quadrature.autocallType = AutocallType::Phoenix;
+  book.push_back(quadrature);
+
+  try {
+    const auto start = std::chrono::steady_clock::now();
+    for (const PricingInputs &inputs : book) {
+      priceAutocall(inputs);
+    }
+    const double sequential = std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+    SchedulerStats stats;
+    priceAutocallPortfolio(book, &stats);
+    std::size_t tasks = 0;
+    std::size_t stolen = 0;
+    for (const WorkerStats &worker : stats.workers) {
+      tasks += worker.tasks;
+      stolen += worker.stolen;
+    }
+    std::printf("| Threads | priceAutocall x%zu (s) | Portefeuille (s) | "
+                "Accélération | Utilisation | Tâches | Vols |\n",
+                book.size());
+    std::printf("|---|---|---|---|---|---|---|\n");
+    std::printf("| %zu | %.2f | %.2f | x%.2f | %.0f %% | %zu | %zu |\n",
+                workerCount(), sequential, stats.wallSeconds,
+                sequential / stats.wallSeconds, 100.0 * stats.utilisation(),
+                tasks, stolen);
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_portfolio_bench: %s\n", ex.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include "PricingServer.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+
+namespace {
+void usage() {
+  std::fprintf(stderr,
+               "usage: pricer_server (--unix PATH | --port N) [--workers N]\n"
+               "                     [--window-us N] [--max-batch N]\n"
+               "                     [--max-paths N]\n");
+}
+
+// Thread taking SIGINT/SIGTERM (blocked everywhere else, the server threads
+// inheriting the mask) to stop the server. Joined before the server is
+// destroyed: when no signal came, it is woken by a SIGTERM of its own.
+class SignalThread {
+public:
+  SignalThread(PricingServer &server, const sigset_t &signals)
+      : thread_([&server, signals] {
+          int received = 0;
+          sigwait(&signals, &received);
+          server.stop();
+        }) {}
+
+  ~SignalThread() {
+    pthread_kill(thread_.native_handle(), SIGTERM);
+    thread_.join();
+  }
+
+  SignalThread(const SignalThread &) = delete;
+  SignalThread &operator=(const SignalThread &) = delete;
+
+private:
+  std::thread thread_;
+};
+
+unsigned long numberArgument(const char *text) {
+  char *end = nullptr;
+  const unsigned long value = std::strtoul(text, &end, 10);
+  if (end == text || *end != '\0') {
+    throw std::runtime_error(std::string("invalid number: ") + text);
+  }
+  return value;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  ServerOptions options;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string flag = argv[i];
+      if (i + 1 >= argc) {
+        usage();
+        return 2;
+      }
+      const char *value = argv[++i];
+      if (flag == "--unix") {
+        options.unixPath = value;
+      } else if (flag == "--port") {
+        options.tcpPort = static_cast<std::uint16_t>(numberArgument(value));
+      } else if (flag == "--workers") {
+        options.workers = numberArgument(value);
+      } else if (flag == "--window-us") {
+        options.batchWindow = std::chrono::microseconds(numberArgument(value));
+      } else if (flag == "--max-batch") {
+        options.maxBatch = numberArgument(value);
+      } else if (flag == "--max-paths") {
+        options.maxPaths = numberArgument(value);
+      } else {
+        usage();
+        return 2;
+      }
+    }
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_server: %s\n", ex.what());
+    return 2;
+  }
+  if (options.unixPath.empty() && options.tcpPort == 0) {
+    usage();
+    return 2;
+  }
+
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  try {
+    PricingServer server(options);
+    const SignalThread signalThread(server, signals);
+
+    std::fprintf(stderr, "pricer_server: listening on %s\n",
+                 options.unixPath.empty()
+                     ? ("127.0.0.1:" + std::to_string(options.tcpPort)).c_str()
+                     : options.unixPath.c_str());
+    server.serve();
+
+    const LatencyHistogram &latency = server.latency();
+    std::fprintf(stderr,
+                 "pricer_server: %llu requests, p50 %.3f ms, p99 %.3f ms\n",
+                 static_cast<unsigned long long>(latency.count()),
+                 1.0e3 * latency.quantile(0.5), 1.0e3 * latency.quantile(0.99));
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_server: %s\n", ex.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,50 @@
+#include "ShardedRunner.hpp"
+#include "StreamSocket.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Shard worker of priceAutocallSharded: serves every coordinator connecting
+// to ADDRESS ("host:port" or a Unix socket path) until killed, or with
+// --stdin the coordinator that started it, over the socket on its standard
+// input, until that coordinator closes it.
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::fprintf(stderr,
+                 "usage: pricer_shard_worker (HOST:PORT | PATH | --stdin)\n");
+    return 2;
+  }
+  if (std::strcmp(argv[1], "--stdin") == 0) {
+    serveShards(STDIN_FILENO);
+    return 0;
+  }
+  int listenFd = -1;
+  try {
+    listenFd = listenStream(argv[1]);
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_shard_worker: %s\n", ex.what());
+    return 1;
+  }
+  std::fprintf(stderr, "pricer_shard_worker: listening on %s\n", argv[1]);
+  for (;;) {
+    const int fd = ::accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      std::fprintf(stderr, "pricer_shard_worker: accept: %s\n",
+                   std::strerror(errno));
+      return 1;
+    }
+    std::thread([fd] {
+      serveShards(fd);
+      ::close(fd);
+    }).detach();
+  }
+}
@@ -0,0 +1,95 @@
+#include "Json.hpp"
+#include "PricingJson.hpp"
+#include "ShardedRunner.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace {
+void usage() {
+  std::fprintf(stderr,
+               "usage: pricer_sharded [--local N] [--worker ADDRESS]...\n"
+               "                      [--worker-program PATH] "
+               "[--blocks-per-shard N]\n"
+               "                      [--timeout-s N] [REQUEST.json]\n");
+}
+
+unsigned long numberArgument(const char *text) {
+  char *end = nullptr;
+  const unsigned long value = std::strtoul(text, &end, 10);
+  if (end == text || *end != '\0') {
+    throw std::runtime_error(std::string("invalid number: ") + text);
+  }
+  return value;
+}
+} // namespace
+
+// Coordinator of priceAutocallSharded: prices the PricingInputs JSON object
+// read from REQUEST.json (standard input by default) over local and remote
+// shard workers, and prints the PricingResults JSON object.
+int main(int argc, char *argv[]) {
+  ShardOptions options;
+  std::string requestPath;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string flag = argv[i];
+      if (flag.rfind("--", 0) != 0) {
+        if (!requestPath.empty()) {
+          usage();
+          return 2;
+        }
+        requestPath = flag;
+        continue;
+      }
+      if (i + 1 >= argc) {
+        usage();
+        return 2;
+      }
+      const char *value = argv[++i];
+      if (flag == "--local") {
+        options.localWorkers = numberArgument(value);
+      } else if (flag == "--worker") {
+        options.workers.emplace_back(value);
+      } else if (flag == "--worker-program") {
+        options.workerProgram = value;
+      } else if (flag == "--blocks-per-shard") {
+        options.blocksPerShard = numberArgument(value);
+      } else if (flag == "--timeout-s") {
+        options.shardTimeout = std::chrono::seconds(numberArgument(value));
+      } else {
+        usage();
+        return 2;
+      }
+    }
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_sharded: %s\n", ex.what());
+    return 2;
+  }
+
+  try {
+    std::string request;
+    if (requestPath.empty()) {
+      request.assign(std::istreambuf_iterator<char>(std::cin), {});
+    } else {
+      std::ifstream file(requestPath);
+      if (!file) {
+        throw std::runtime_error("cannot open " + requestPath);
+      }
+      request.assign(std::istreambuf_iterator<char>(file), {});
+    }
+    const PricingResults results = priceAutocallSharded(
+        pricingInputsFromJson(JsonValue::parse(request)), options);
+    std::printf("%s\n", pricingResultsToJson(results).dump().c_str());
+  } catch (const std::exception &ex) {
+    std::fprintf(stderr, "pricer_sharded: %s\n", ex.what());
+    return 1;
+  }
+  return 0;
+}
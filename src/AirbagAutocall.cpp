@@ -10,25 +10,38 @@ AirbagAutocall::AirbagAutocall(std::string underlying,
                    notional, couponRate, callBarrier, protectionBarrier),
       airbagFloor_(airbagFloor) {}
 
-double AirbagAutocall::discountedPayoff(const std::vector<double> &path,
-                                        double riskFreeRate) const {
+double AirbagAutocall::payoff(PathView path, const double *discountFactors,
+                              LifeEvents *events) const {
   const auto &obs = times();
   const std::size_t steps = std::min(path.size(), obs.size());
 
   for (std::size_t i = 0; i < steps; ++i) {
     if (path[i] >= callBarrier()) {
       double amount = notional() * (1.0 + couponRate());
-      return amount * std::exp(-riskFreeRate * obs[i]);
+      if (events) {
+        events->called(i);
+      }
+      return amount * discountFactors[i];
     }
   }
 
-  const double finalSpot = (steps > 0) ? path[steps - 1] : spot0();
-  double amount = terminalRedemption(finalSpot);
-  return amount * std::exp(-riskFreeRate * obs.back());
+  if (events) {
+    events->matured();
+  }
+  double amount = maturityRedemption(path);
+  return amount * discountFactors[obs.size() - 1];
 }
 
 double AirbagAutocall::terminalRedemption(double spotT) const {
   double base = AutocallBase::terminalRedemption(spotT);
   double minRedemption = notional() * airbagFloor_;
   return std::max(base, minRedemption);
-}
\ No newline at end of file
+}
+double AirbagAutocall::knockedInRedemption(double spotT) const {
+  return std::max(AutocallBase::knockedInRedemption(spotT),
+                  notional() * airbagFloor_);
+}
+
+std::vector<double> AirbagAutocall::redemptionBreakpoints() const {
+  return {protectionBarrier(), spot0() * airbagFloor_};
+}
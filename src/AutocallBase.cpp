@@ -1,5 +1,18 @@
 #include "AutocallBase.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+// Broadie-Glasserman-Kou: a barrier watched at spacing dt behaves like a
+// continuous barrier moved away from the spot by exp(beta sigma sqrt(dt)),
+// with beta = -zeta(1/2) / sqrt(2 pi).
+constexpr double kBgkBeta = 0.5826;
+constexpr double kTradingDaysPerYear = 252.0;
+} // namespace
+
 AutocallBase::AutocallBase(std::string underlying,
                            std::vector<double> observationTimes,
                            double spot0,
@@ -20,4 +33,136 @@ double AutocallBase::terminalRedemption(double finalSpot) const {
     }
     // Capital at risk: The investor loses money proportional to the spot drop.
     return notional_ * (finalSpot / spot0_);
-}
\ No newline at end of file
+}
+
+AutocallBase::ObservationRule
+AutocallBase::observationRule(std::size_t /*i*/) const {
+    return {callBarrier_, notional_ * (1.0 + couponRate_),
+            std::numeric_limits<double>::infinity(), 0.0, false};
+}
+
+std::vector<double> AutocallBase::redemptionBreakpoints() const {
+    return {protectionBarrier_};
+}
+
+double AutocallBase::knockedInRedemption(double finalSpot) const {
+    return notional_ * std::min(1.0, finalSpot / spot0_);
+}
+
+double AutocallBase::maturityRedemption(PathView path) const {
+    const double finalSpot = path.empty() ? spot0_ : path.back();
+    if (protectionMonitoring_ == BarrierMonitoring::AtMaturity) {
+        return terminalRedemption(finalSpot);
+    }
+    if (!path.hasBridge()) {
+        throw std::runtime_error(
+            "Autocall: knock-in monitoring needs interval variances");
+    }
+
+    const auto &obs = times();
+    const double *variance = path.intervalVariance();
+    double survival = 1.0;
+    double previous = path.startSpot();
+    double previousTime = 0.0;
+    const std::size_t dates = std::min(path.size(), obs.size());
+    for (std::size_t i = 0; i < dates && survival > 0.0; ++i) {
+        double barrier = protectionBarrier_;
+        const double dt = obs[i] - previousTime;
+        if (protectionMonitoring_ == BarrierMonitoring::Daily && dt > 0.0 &&
+            variance[i] > 0.0) {
+            const double sigma = std::sqrt(variance[i] / dt);
+            barrier *= std::exp(-kBgkBeta * sigma /
+                                std::sqrt(kTradingDaysPerYear));
+        }
+        if (previous <= barrier || path[i] <= barrier) {
+            survival = 0.0;
+        } else if (variance[i] > 0.0) {
+            survival *= 1.0 - std::exp(-2.0 * std::log(previous / barrier) *
+                                       std::log(path[i] / barrier) /
+                                       variance[i]);
+        }
+        previous = path[i];
+        previousTime = obs[i];
+    }
+    return survival * terminalRedemption(finalSpot) +
+           (1.0 - survival) * knockedInRedemption(finalSpot);
+}
+
+double AutocallBase::smoothStep(double spot, double barrier) const {
+    if (!std::isfinite(barrier)) {
+        return barrier > 0.0 ? 0.0 : 1.0;
+    }
+    const double width = barrierSmoothing_ * std::abs(barrier);
+    if (width <= 0.0) {
+        return spot >= barrier ? 1.0 : 0.0;
+    }
+    return std::clamp((spot - barrier) / width + 0.5, 0.0, 1.0);
+}
+
+double AutocallBase::discountedPayoff(PathView path,
+                                      const double *discountFactors) const {
+    if (barrierSmoothing_ > 0.0) {
+        return smoothedPayoff(path, discountFactors);
+    }
+    return payoff(path, discountFactors, nullptr);
+}
+
+double AutocallBase::discountedPayoff(PathView path,
+                                      const double *discountFactors,
+                                      LifeEvents &events) const {
+    if (barrierSmoothing_ > 0.0) {
+        return smoothedPayoff(path, discountFactors, &events);
+    }
+    return payoff(path, discountFactors, &events);
+}
+
+double AutocallBase::smoothedPayoff(PathView path,
+                                    const double *discountFactors,
+                                    LifeEvents *events) const {
+    const auto &obs = times();
+    const std::size_t steps = std::min(path.size(), obs.size());
+    double totalValue = 0.0;
+    double alive = 1.0;
+    double carried = 0.0; // Unpaid memory coupons (fractional).
+
+    for (std::size_t i = 0; i < steps && alive > 0.0; ++i) {
+        const ObservationRule rule = observationRule(i);
+        const double spot = path[i];
+
+        const double couponWeight = smoothStep(spot, rule.couponBarrier);
+        if (rule.couponAmount != 0.0) {
+            const double due =
+                rule.couponAmount * (rule.memory ? carried + 1.0 : 1.0);
+            totalValue += alive * couponWeight * due * discountFactors[i];
+            if (events) {
+                events->couponPaid(i, alive * couponWeight);
+            }
+            carried = rule.memory ? (1.0 - couponWeight) * (carried + 1.0) : 0.0;
+        }
+
+        const double callWeight = smoothStep(spot, rule.callBarrier);
+        totalValue += alive * callWeight * rule.callAmount * discountFactors[i];
+        if (events) {
+            events->called(i, alive * callWeight);
+        }
+        alive *= 1.0 - callWeight;
+    }
+
+    if (alive > 0.0) {
+        double redemption = maturityRedemption(path);
+        if (protectionMonitoring_ == BarrierMonitoring::AtMaturity) {
+            // Bridged knock-ins are already continuous in the path.
+            const double finalSpot = steps > 0 ? path[steps - 1] : spot0_;
+            const double weight = smoothStep(finalSpot, protectionBarrier_);
+            redemption =
+                weight * terminalRedemption(std::max(finalSpot,
+                                                     protectionBarrier_)) +
+                (1.0 - weight) * knockedInRedemption(finalSpot);
+        }
+        totalValue += alive * redemption * discountFactors[obs.size() - 1];
+        if (events) {
+            events->matured(alive);
+        }
+    }
+    return totalValue;
+}
@@ -0,0 +1,385 @@
+#include "AutocallQuadrature.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+constexpr double kInvSqrt2Pi = 0.39894228040143267794;
+// Grid step, in units of the smallest period log-vol, extent of each date's
+// grid and truncation of the transition kernel, in standard deviations.
+constexpr double kStepsPerVol = 8.0;
+constexpr double kGridStdDevs = 7.0;
+constexpr double kKernelStdDevs = 7.5;
+constexpr std::size_t kMaxGridPoints = 4097;
+
+double normalPdf(double x) { return kInvSqrt2Pi * std::exp(-0.5 * x * x); }
+
+double normalCdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+double logLevel(double level) {
+  if (!(level > 0.0)) {
+    return -std::numeric_limits<double>::infinity();
+  }
+  return std::log(level);
+}
+
+// A value, its first two derivatives in the mean of log(S) and its
+// derivative in the vol.
+struct Moments {
+  double value{};
+  double dm{};
+  double dmm{};
+  double dv{};
+};
+
+// P(lo <= X < hi) for X ~ N(mean, s^2), with its derivatives in the mean,
+// and in s at fixed mean (dv).
+Moments band(double lo, double hi, double mean, double s) {
+  const double uLo = (lo - mean) / s;
+  const double uHi = (hi - mean) / s;
+  Moments out;
+  out.value = normalCdf(uHi) - normalCdf(uLo);
+  if (std::isfinite(lo)) {
+    out.dm += normalPdf(uLo) / s;
+    out.dmm += uLo * normalPdf(uLo) / (s * s);
+    out.dv += uLo * normalPdf(uLo) / s;
+  }
+  if (std::isfinite(hi)) {
+    out.dm -= normalPdf(uHi) / s;
+    out.dmm -= uHi * normalPdf(uHi) / (s * s);
+    out.dv -= uHi * normalPdf(uHi) / s;
+  }
+  return out;
+}
+
+// Derivative in s of the transition density phi(u) / s, u = (x - mean) / s,
+// at fixed forward (mean + s^2 / 2), over the density itself.
+double densitySlope(double u, double s) { return (u * u - 1.0) / s - u; }
+
+// a + b S for lo <= log(S) < hi.
+struct Piece {
+  double lo;
+  double hi;
+  double a;
+  double b;
+};
+
+// E[f(e^X)] for a payoff linear on each piece, X ~ N(mean, s^2): digitals
+// and asset-or-nothing pieces, E[e^X 1{..}] = e^{mean + s^2 / 2} P(..)
+// under the measure shifted by s^2. dv is the derivative in sigma, with
+// s = sigma sqrtDt and the forward e^{mean + s^2 / 2} held fixed.
+Moments expectation(const std::vector<Piece> &pieces, double mean, double s,
+                    double sqrtDt) {
+  Moments out;
+  double ds = 0.0;
+  for (const Piece &piece : pieces) {
+    const Moments digital = band(piece.lo, piece.hi, mean, s);
+    out.value += piece.a * digital.value;
+    out.dm += piece.a * digital.dm;
+    out.dmm += piece.a * digital.dmm;
+    ds += piece.a * (digital.dv - s * digital.dm);
+    if (piece.b != 0.0) {
+      const double forward = std::exp(mean + 0.5 * s * s);
+      const Moments asset = band(piece.lo, piece.hi, mean + s * s, s);
+      const double scale = piece.b * forward;
+      out.value += scale * asset.value;
+      out.dm += scale * (asset.value + asset.dm);
+      out.dmm += scale * (asset.value + 2.0 * asset.dm + asset.dmm);
+      ds += scale * (asset.dv + s * asset.dm);
+    }
+  }
+  out.dv = ds * sqrtDt;
+  return out;
+}
+
+// Splits `payoff` (linear between the breakpoints) into pieces on
+// [from, inf), reading each piece's coefficients from two of its points.
+template <class Payoff>
+std::vector<Piece> piecesOf(const Payoff &payoff, std::vector<double> points,
+                            double from) {
+  std::vector<Piece> pieces;
+  if (!(from < std::numeric_limits<double>::infinity())) {
+    return pieces;
+  }
+  from = std::max(from, 0.0);
+  points.erase(std::remove_if(points.begin(), points.end(),
+                              [&](double p) {
+                                return !(p > from) || !std::isfinite(p);
+                              }),
+               points.end());
+  std::sort(points.begin(), points.end());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  points.push_back(std::numeric_limits<double>::infinity());
+
+  double start = from;
+  for (double end : points) {
+    double x1, x2;
+    if (std::isfinite(end)) {
+      x1 = start + (end - start) / 3.0;
+      x2 = start + 2.0 * (end - start) / 3.0;
+    } else {
+      x1 = start > 0.0 ? 2.0 * start : 1.0;
+      x2 = 2.0 * x1;
+    }
+    const double y1 = payoff(x1);
+    const double b = (payoff(x2) - y1) / (x2 - x1);
+    pieces.push_back({logLevel(start), logLevel(end), y1 - b * x1, b});
+    start = end;
+  }
+  return pieces;
+}
+
+// Nodes x_k = anchor - k h, k < nodes, below the barrier of one date.
+struct DateGrid {
+  double anchor{};
+  std::size_t nodes{};
+};
+
+struct Layout {
+  double h{};
+  std::vector<DateGrid> grids; // One per date; the last one stays empty.
+};
+
+struct Schedule {
+  std::vector<double> sqrtDt;
+  std::vector<double> logGrowth;
+  std::vector<std::vector<Piece>> pieces; // Value at or above the barrier.
+};
+
+Layout layoutOf(const Schedule &schedule, const std::vector<double> &logCall,
+                double logSpot, double sigma) {
+  const std::size_t dates = schedule.sqrtDt.size();
+  std::vector<double> low(dates), high(dates);
+  double smallestVol = std::numeric_limits<double>::infinity();
+  double mean = logSpot;
+  double variance = 0.0;
+  double extent = 0.0;
+  for (std::size_t i = 0; i < dates; ++i) {
+    const double s = sigma * schedule.sqrtDt[i];
+    smallestVol = std::min(smallestVol, s);
+    mean += schedule.logGrowth[i] - 0.5 * s * s;
+    variance += s * s;
+    low[i] = mean - kGridStdDevs * std::sqrt(variance);
+    high[i] = std::min(logCall[i], mean + kGridStdDevs * std::sqrt(variance));
+    extent = std::max(extent, high[i] - low[i]);
+  }
+
+  Layout layout;
+  layout.h = std::max(smallestVol / kStepsPerVol,
+                      extent / static_cast<double>(kMaxGridPoints - 1));
+  layout.grids.resize(dates);
+  for (std::size_t i = 0; i + 1 < dates; ++i) {
+    if (high[i] <= low[i]) {
+      continue; // Called on (almost) every path.
+    }
+    // An even number of intervals, so that every other node is the grid of
+    // step 2h used by the extrapolation.
+    const auto intervals = static_cast<std::size_t>(
+        std::ceil(0.5 * (high[i] - low[i]) / layout.h));
+    layout.grids[i] = {high[i], 2 * intervals + 1};
+  }
+  return layout;
+}
+
+// Value of the note at time 0 seen from log-spot `logSpot`, by backward
+// induction over the dates. The vega is carried along: on the fixed grid,
+// C_i and its derivative in sigma follow the same recursion, with the
+// kernel and the tails differentiated in sigma.
+Moments inducted(const Schedule &schedule, const Layout &layout,
+                 double logSpot, double sigma) {
+  const double h = layout.h;
+  std::vector<double> values; // C_i on the grid of date i.
+  std::vector<double> slopes; // dC_i / dsigma on the same grid.
+  std::vector<double> weighted, weightedSlopes, kernel, kernelSlopes;
+  for (std::size_t i = schedule.sqrtDt.size(); i-- > 0;) {
+    const double sqrtDt = schedule.sqrtDt[i];
+    const double s = sigma * sqrtDt;
+    const double drift = schedule.logGrowth[i] - 0.5 * s * s;
+    const DateGrid &source = layout.grids[i];
+    weighted.assign(source.nodes, 0.0);
+    weightedSlopes.assign(source.nodes, 0.0);
+    for (std::size_t k = 0; k < source.nodes; ++k) {
+      const double w = (k == 0 || k + 1 == source.nodes) ? 0.5 : 1.0;
+      weighted[k] = w * h * values[k];
+      weightedSlopes[k] = w * h * slopes[k];
+    }
+
+    if (i == 0) {
+      Moments out =
+          expectation(schedule.pieces[0], logSpot + drift, s, sqrtDt);
+      for (std::size_t k = 0; k < source.nodes; ++k) {
+        const double u =
+            (source.anchor - static_cast<double>(k) * h - logSpot - drift) / s;
+        const double kernelValue = normalPdf(u) / s;
+        const double density = weighted[k] * kernelValue;
+        out.value += density;
+        out.dm += density * u / s;
+        out.dmm += density * (u * u - 1.0) / (s * s);
+        out.dv += weightedSlopes[k] * kernelValue +
+                  density * densitySlope(u, s) * sqrtDt;
+      }
+      return out;
+    }
+
+    const DateGrid &target = layout.grids[i - 1];
+    std::vector<double> next(target.nodes);
+    std::vector<double> nextSlopes(target.nodes);
+    // x_k - y_a - drift = delta + (a - k) h: the kernel is tabulated once on
+    // the offsets d = a - k within kKernelStdDevs, and each source node is
+    // spread over its target rows (independent updates, which vectorise).
+    const double delta = source.anchor - target.anchor - drift;
+    const double reach = kKernelStdDevs * s;
+    const long dMin = static_cast<long>(std::ceil((-reach - delta) / h));
+    const long dMax = static_cast<long>(std::floor((reach - delta) / h));
+    kernel.assign(dMax >= dMin ? static_cast<std::size_t>(dMax - dMin + 1) : 0,
+                  0.0);
+    kernelSlopes.assign(kernel.size(), 0.0);
+    for (std::size_t j = 0; j < kernel.size(); ++j) {
+      const double d = static_cast<double>(dMin + static_cast<long>(j));
+      const double u = (delta + d * h) / s;
+      kernel[j] = normalPdf(u) / s;
+      kernelSlopes[j] = kernel[j] * densitySlope(u, s) * sqrtDt;
+    }
+    for (std::size_t a = 0; a < target.nodes; ++a) {
+      const double y = target.anchor - static_cast<double>(a) * h;
+      const Moments tail =
+          expectation(schedule.pieces[i], y + drift, s, sqrtDt);
+      next[a] = tail.value;
+      nextSlopes[a] = tail.dv;
+    }
+    const long targetNodes = static_cast<long>(target.nodes);
+    for (std::size_t k = 0; k < source.nodes; ++k) {
+      const long column = static_cast<long>(k);
+      const long aBegin = std::max(0L, column + dMin);
+      const long aEnd = std::min(targetNodes, column + dMax + 1);
+      const double w = weighted[k];
+      const double ws = weightedSlopes[k];
+      const double *row = kernel.data() - (column + dMin);
+      const double *rowSlope = kernelSlopes.data() - (column + dMin);
+      for (long a = aBegin; a < aEnd; ++a) {
+        next[a] += w * row[a];
+        nextSlopes[a] += ws * row[a] + w * rowSlope[a];
+      }
+    }
+    values.swap(next);
+    slopes.swap(nextSlopes);
+  }
+  return {};
+}
+
+// The trapezoid error is O(h^2) (the value is cut at the barrier node):
+// Richardson extrapolation of the grids of step h and 2h.
+Moments extrapolated(const Schedule &schedule, const Layout &layout,
+                     double logSpot, double sigma) {
+  const Moments fine = inducted(schedule, layout, logSpot, sigma);
+  Layout coarse = layout;
+  coarse.h = 2.0 * layout.h;
+  bool gridded = false;
+  for (DateGrid &grid : coarse.grids) {
+    gridded = gridded || grid.nodes > 0;
+    grid.nodes = grid.nodes > 0 ? grid.nodes / 2 + 1 : 0;
+  }
+  if (!gridded) {
+    return fine; // Closed form throughout.
+  }
+  const Moments rough = inducted(schedule, coarse, logSpot, sigma);
+  auto combine = [](double f, double c) { return (4.0 * f - c) / 3.0; };
+  return {combine(fine.value, rough.value), combine(fine.dm, rough.dm),
+          combine(fine.dmm, rough.dmm), combine(fine.dv, rough.dv)};
+}
+} // namespace
+
+AutocallQuadrature::AutocallQuadrature(double sigma) : sigma_(sigma) {
+  if (!(sigma > 0.0)) {
+    throw std::runtime_error("AutocallQuadrature: the vol must be positive");
+  }
+}
+
+bool AutocallQuadrature::supports(const AutocallBase &product) {
+  if (product.needsBridge() || product.barrierSmoothing() > 0.0) {
+    return false;
+  }
+  const auto &times = product.observationTimes();
+  if (times.empty()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    if (times[i] <= (i > 0 ? times[i - 1] : 0.0)) {
+      return false;
+    }
+    // A coupon tested below the autocall barrier would need a second
+    // discontinuity in the grid (and the memory state).
+    const auto rule = product.observationRule(i);
+    if (rule.couponAmount != 0.0 && rule.couponBarrier < rule.callBarrier) {
+      return false;
+    }
+  }
+  return true;
+}
+
+AutocallQuadrature::Result
+AutocallQuadrature::price(const AutocallBase &product, double spot,
+                          const DiscountCurve &curve, double elapsed) const {
+  if (!supports(product)) {
+    throw std::runtime_error("AutocallQuadrature: unsupported autocall (use "
+                             "the PDE or Monte Carlo)");
+  }
+  if (!(spot > 0.0)) {
+    throw std::runtime_error("AutocallQuadrature: the spot must be positive");
+  }
+  std::vector<double> times = product.observationTimes();
+  for (double &t : times) {
+    t -= elapsed;
+  }
+  if (!(times.front() > 0.0)) {
+    throw std::runtime_error("AutocallQuadrature: the first date is past");
+  }
+  const TimeGrid grid(times, curve);
+  const std::size_t dates = times.size();
+
+  // Amounts in time-0 money. With the coupon barrier at or above the
+  // autocall barrier a note alive at date i has missed every coupon so far.
+  Schedule schedule;
+  schedule.sqrtDt = grid.sqrtDt;
+  schedule.logGrowth = grid.logGrowth;
+  std::vector<double> logCall(dates);
+  double accrued = 0.0;
+  for (std::size_t i = 0; i < dates; ++i) {
+    const auto rule = product.observationRule(i);
+    const double df = grid.discountFactors[i];
+    accrued = (rule.memory ? accrued : 0.0) + rule.couponAmount;
+    const double couponValue = df * accrued;
+    auto paid = [&](double s) {
+      return s >= rule.couponBarrier ? couponValue : 0.0;
+    };
+    std::vector<double> points{rule.callBarrier, rule.couponBarrier};
+    logCall[i] = logLevel(rule.callBarrier);
+    if (i + 1 < dates) {
+      schedule.pieces.push_back(piecesOf(
+          [&](double s) { return paid(s) + df * rule.callAmount; }, points,
+          rule.callBarrier));
+      continue;
+    }
+    const auto breakpoints = product.redemptionBreakpoints();
+    points.insert(points.end(), breakpoints.begin(), breakpoints.end());
+    schedule.pieces.push_back(piecesOf(
+        [&](double s) {
+          return paid(s) + df * (s >= rule.callBarrier
+                                     ? rule.callAmount
+                                     : product.terminalRedemption(s));
+        },
+        points, 0.0));
+  }
+
+  const double logSpot = std::log(spot);
+  const Layout layout = layoutOf(schedule, logCall, logSpot, sigma_);
+  const Moments base = extrapolated(schedule, layout, logSpot, sigma_);
+  Result result;
+  result.price = base.value;
+  result.delta = base.dm / spot;
+  result.gamma = (base.dmm - base.dm) / (spot * spot);
+  result.vega = base.dv;
+  return result;
+}
@@ -1,37 +1,42 @@
 #include "BlackScholesMC.hpp"
-#include "MarketData.hpp"
 #include <cmath>
-#include <random>
 
-BlackScholesMC::BlackScholesMC(double sigma) : sigma_(sigma) {}
-
-std::vector<double>
-BlackScholesMC::simulatePath(double spot0, const std::vector<double> &times,
-                             const MarketData &data, std::mt19937 &rng) const {
-  std::vector<double> path;
-  path.reserve(times.size());
+namespace {
+// Intervals shorter than this do not move the spot and draw no normal.
+constexpr double kMinInterval = 1e-8;
+} // namespace
 
-  double currentSpot = spot0;
-  double currentTime = 0.0;
-  double r = data.riskFreeRate();
+BlackScholesMC::BlackScholesMC(double sigma) : sigma_(sigma) {}
 
-  std::normal_distribution<double> d(0.0, 1.0);
+std::size_t BlackScholesMC::normalCount(const TimeGrid &grid) const {
+  std::size_t count = 0;
+  for (double dt : grid.dt) {
+    count += dt > kMinInterval ? 1 : 0;
+  }
+  return count;
+}
 
-  for (double t : times) {
-    double dt = t - currentTime;
-    if (dt < 0.0)
-      dt = 0.0;
+void BlackScholesMC::buildPath(double spot0, const TimeGrid &grid,
+                               const double *normals, std::vector<double> &path,
+                               double *intervalVariance) const {
+  const std::size_t n = grid.times.size();
+  path.resize(n);
 
-    if (dt > 1e-8) {
-      double z = d(rng);
-      double drift = (r - 0.5 * sigma_ * sigma_) * dt;
-      double diffusion = sigma_ * std::sqrt(dt) * z;
-      currentSpot *= std::exp(drift + diffusion);
+  double currentSpot = spot0;
+  const double halfVariance = 0.5 * sigma_ * sigma_;
+
+  for (std::size_t i = 0; i < n; ++i) {
+    const double dt = grid.dt[i];
+    if (dt > kMinInterval) {
+      const double z = *normals++;
+      const double drift = grid.logGrowth[i] - halfVariance * dt;
+      const double vol = sigma_ * grid.sqrtDt[i];
+      currentSpot *= std::exp(drift + vol * z);
+    }
+    if (intervalVariance) {
+      intervalVariance[i] = dt > kMinInterval ? sigma_ * sigma_ * dt : 0.0;
     }
 
-    path.push_back(currentSpot);
-    currentTime = t;
+    path[i] = currentSpot;
   }
-
-  return path;
-}
\ No newline at end of file
+}
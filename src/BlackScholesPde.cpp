@@ -0,0 +1,195 @@
+#include "BlackScholesPde.hpp"
+#include "FiniteDifference.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Tridiagonal representation of the BS operator
+// L V = 0.5 sigma^2 S^2 V_SS + r S V_S - r V on the spot grid.
+struct Operator {
+  std::vector<double> lower;
+  std::vector<double> diag;
+  std::vector<double> upper;
+};
+
+Operator makeOperator(const std::vector<double> &grid, double sigma,
+                      double rate) {
+  const std::size_t n = grid.size();
+  const std::vector<Stencil> stencils = makeStencils(grid);
+  Operator op{std::vector<double>(n, 0.0), std::vector<double>(n, 0.0),
+              std::vector<double>(n, 0.0)};
+
+  // S = 0: the spot stays at 0 and the value only earns the rate.
+  op.diag[0] = -rate;
+  for (std::size_t j = 1; j + 1 < n; ++j) {
+    const double a = 0.5 * sigma * sigma * grid[j] * grid[j];
+    const double b = rate * grid[j];
+    const Stencil &s = stencils[j];
+    op.lower[j] = a * s.d2[0] + b * s.d1[0];
+    op.diag[j] = a * s.d2[1] + b * s.d1[1] - rate;
+    op.upper[j] = a * s.d2[2] + b * s.d1[2];
+  }
+  // S = Smax: linear value (V_SS = 0), one-sided first derivative.
+  const double h = grid[n - 1] - grid[n - 2];
+  const double b = rate * grid[n - 1];
+  op.lower[n - 1] = -b / h;
+  op.diag[n - 1] = b / h - rate;
+  return op;
+}
+
+// Implicit side of one theta-scheme step of size k:
+// (I - theta k L) V_new = (I + (1 - theta) k L) V_old.
+struct StepSystem {
+  std::vector<double> lower;
+  std::vector<double> diag;
+  std::vector<double> upper;
+  double explicitWeight;
+};
+
+StepSystem makeStepSystem(const Operator &op, double theta, double k) {
+  const std::size_t n = op.diag.size();
+  StepSystem system{std::vector<double>(n), std::vector<double>(n),
+                    std::vector<double>(n), (1.0 - theta) * k};
+  for (std::size_t j = 0; j < n; ++j) {
+    system.lower[j] = -theta * k * op.lower[j];
+    system.diag[j] = 1.0 - theta * k * op.diag[j];
+    system.upper[j] = -theta * k * op.upper[j];
+  }
+  return system;
+}
+
+// Advances every active layer by one step.
+void advance(const Operator &op, const StepSystem &system,
+             std::vector<std::vector<double>> &layers, std::size_t active,
+             std::vector<double> &rhs, std::vector<double> &scratch) {
+  const std::size_t n = op.diag.size();
+  for (std::size_t m = 0; m < active; ++m) {
+    std::vector<double> &v = layers[m];
+    for (std::size_t j = 0; j < n; ++j) {
+      double lv = op.diag[j] * v[j];
+      if (j > 0) {
+        lv += op.lower[j] * v[j - 1];
+      }
+      if (j + 1 < n) {
+        lv += op.upper[j] * v[j + 1];
+      }
+      rhs[j] = v[j] + system.explicitWeight * lv;
+    }
+    solveTridiagonal(system.lower, system.diag, system.upper, rhs, scratch);
+    v.swap(rhs);
+  }
+}
+} // namespace
+
+BlackScholesPde::BlackScholesPde(double sigma, PdeSettings settings)
+    : sigma_(sigma), settings_(settings) {}
+
+BlackScholesPde::Result BlackScholesPde::price(const AutocallBase &product,
+                                               double spot,
+                                               double rate) const {
+  const auto &obs = product.observationTimes();
+  const std::size_t dates = obs.size();
+  if (dates == 0) {
+    throw std::runtime_error("PDE: product has no observation dates");
+  }
+  const double maturity = std::max(obs.back(), 1e-8);
+
+  std::vector<AutocallBase::ObservationRule> rules;
+  rules.reserve(dates);
+  bool memory = false;
+  // Nodes cluster at the spot, at the kinks and jumps of the redemption
+  // (protection barrier, airbag floor, term-sheet strikes) and at the
+  // observation barriers.
+  std::vector<double> critical{spot};
+  double highest = spot;
+  for (double breakpoint : product.redemptionBreakpoints()) {
+    if (std::isfinite(breakpoint) && breakpoint > 0.0) {
+      critical.push_back(breakpoint);
+      highest = std::max(highest, breakpoint);
+    }
+  }
+  for (std::size_t i = 0; i < dates; ++i) {
+    rules.push_back(product.observationRule(i));
+    const auto &rule = rules.back();
+    memory = memory || rule.memory;
+    for (double barrier : {rule.callBarrier, rule.couponBarrier}) {
+      if (std::isfinite(barrier)) {
+        critical.push_back(barrier);
+        highest = std::max(highest, barrier);
+      }
+    }
+  }
+
+  const double spread = std::max(6.0 * sigma_ * std::sqrt(maturity), 0.7);
+  const double sMax = highest * std::exp(spread);
+  const std::vector<double> grid = makeConcentratedGrid(
+      0.0, sMax, settings_.spotNodes, critical, 0.05 * spot);
+  const std::size_t n = grid.size();
+  const Operator op = makeOperator(grid, sigma_, rate);
+
+  // layers[m] is the value with m unpaid coupons carried into the next
+  // observation (a single layer without memory).
+  const std::size_t layerCount = memory ? dates : 1;
+  std::vector<std::vector<double>> layers(layerCount, std::vector<double>(n));
+  std::vector<std::vector<double>> jumped = layers;
+  std::vector<double> rhs(n), scratch(n);
+
+  for (std::size_t step = dates; step-- > 0;) {
+    const auto &rule = rules[step];
+    const bool last = step + 1 == dates;
+    const std::size_t states = memory ? step + 1 : 1;
+
+    // Jump condition at the observation date.
+    for (std::size_t m = 0; m < states; ++m) {
+      const double due =
+          rule.couponAmount * (rule.memory ? static_cast<double>(m + 1) : 1.0);
+      for (std::size_t j = 0; j < n; ++j) {
+        const double s = grid[j];
+        const bool couponPaid = s >= rule.couponBarrier;
+        const double coupon = couponPaid ? due : 0.0;
+        double value;
+        if (s >= rule.callBarrier) {
+          value = coupon + rule.callAmount;
+        } else if (last) {
+          value = coupon + product.terminalRedemption(s);
+        } else if (rule.memory && !couponPaid) {
+          value = layers[m + 1][j];
+        } else {
+          value = coupon + layers[0][j];
+        }
+        jumped[m][j] = value;
+      }
+    }
+    layers.swap(jumped);
+
+    // Backward time stepping to the previous observation (or today).
+    const double start = step == 0 ? 0.0 : obs[step - 1];
+    const double period = obs[step] - start;
+    if (period <= 1e-12) {
+      continue;
+    }
+    const std::size_t steps = std::max(
+        settings_.minStepsPerPeriod,
+        static_cast<std::size_t>(std::ceil(
+            period * static_cast<double>(settings_.stepsPerYear))));
+    const double k = period / static_cast<double>(steps);
+    const std::size_t smoothing = std::min(settings_.rannacherSteps, steps);
+    const StepSystem implicitHalf = makeStepSystem(op, 1.0, 0.5 * k);
+    const StepSystem crankNicolson = makeStepSystem(op, 0.5, k);
+    for (std::size_t s = 0; s < smoothing; ++s) {
+      advance(op, implicitHalf, layers, states, rhs, scratch);
+      advance(op, implicitHalf, layers, states, rhs, scratch);
+    }
+    for (std::size_t s = smoothing; s < steps; ++s) {
+      advance(op, crankNicolson, layers, states, rhs, scratch);
+    }
+  }
+
+  Result result;
+  interpolateQuadratic(grid, layers[0].data(), spot, result.price,
+                       result.delta, result.gamma);
+  return result;
+}
@@ -0,0 +1,276 @@
+#include "CliquetAnalytic.hpp"
+
+#include "CliquetCappedCoupons.hpp"
+#include "CliquetMaxReturn.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr double kInvSqrt2Pi = 0.39894228040143267794;
+// Grid step of the MaxReturn recursion, in units of the smallest period
+// log-vol, and its extent in standard deviations of the sum of the periods.
+constexpr double kStepsPerVol = 16.0;
+constexpr double kGridStdDevs = 8.0;
+// Parallel vol shift of the MaxReturn vega.
+constexpr double kVegaBump = 1e-4;
+
+double normalPdf(double x) { return kInvSqrt2Pi * std::exp(-0.5 * x * x); }
+
+double normalCdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+// Undiscounted call on a lognormal variable of forward F and log-vol s, with
+// its derivatives in F (two) and in s.
+struct CallValue {
+  double value{};
+  double dF{};
+  double dFF{};
+  double ds{};
+};
+
+CallValue lognormalCall(double forward, double strike, double s) {
+  if (strike <= 0.0) {
+    return {forward - strike, 1.0, 0.0, 0.0};
+  }
+  if (s <= 0.0 || forward <= 0.0) {
+    const bool inTheMoney = forward > strike;
+    return {inTheMoney ? forward - strike : 0.0, inTheMoney ? 1.0 : 0.0, 0.0,
+            0.0};
+  }
+  const double d1 = (std::log(forward / strike) + 0.5 * s * s) / s;
+  const double d2 = d1 - s;
+  const double density = normalPdf(d1);
+  return {forward * normalCdf(d1) - strike * normalCdf(d2), normalCdf(d1),
+          density / (forward * s), forward * density};
+}
+
+// Period k of the cliquet: forward of its return and log-vol.
+struct Period {
+  double forward;
+  double logVol;
+  double sqrtDt;
+};
+
+std::vector<Period> periodsOf(const TimeGrid &grid,
+                              const std::vector<double> &vols) {
+  std::vector<Period> periods;
+  for (std::size_t k = 0; k < grid.times.size(); ++k) {
+    const double vol = vols.size() == 1 ? vols.front() : vols.at(k);
+    periods.push_back(
+        {std::exp(grid.logGrowth[k]), vol * grid.sqrtDt[k], grid.sqrtDt[k]});
+  }
+  return periods;
+}
+
+CliquetAnalytic::Result cappedCoupons(const CliquetCappedCoupons &product,
+                                      const std::vector<Period> &periods,
+                                      double moneyness, double discount) {
+  const double p = product.participation();
+  const double cap = product.cap();
+  const double scale = discount * product.notional();
+  CliquetAnalytic::Result result;
+  result.price = scale;
+  if (p <= 0.0 || cap <= 0.0) {
+    return result;
+  }
+  const double upperStrike = 1.0 + cap / p;
+  for (std::size_t k = 0; k < periods.size(); ++k) {
+    const Period &period = periods[k];
+    const double m = k == 0 ? moneyness : 1.0;
+    const CallValue low = lognormalCall(m * period.forward, 1.0, period.logVol);
+    const CallValue high =
+        lognormalCall(m * period.forward, upperStrike, period.logVol);
+    result.price += scale * p * (low.value - high.value);
+    result.vega += scale * p * (low.ds - high.ds) * period.sqrtDt;
+    if (k == 0) {
+      // Only the first return depends on the spot: d(mF)/dS = F / S_0.
+      const double dForward = period.forward / product.spot0();
+      result.delta = scale * p * (low.dF - high.dF) * dForward;
+      result.gamma = scale * p * (low.dFF - high.dFF) * dForward * dForward;
+    }
+  }
+  return result;
+}
+
+// Uniform grid x_j = j h, j < points, carrying the law of V_2.
+struct LindleyGrid {
+  double h{};
+  std::size_t points{};
+};
+
+LindleyGrid lindleyGrid(const std::vector<Period> &periods) {
+  double smallestVol = periods[1].logVol;
+  double variance = 0.0;
+  double drift = 0.0;
+  for (std::size_t k = 1; k < periods.size(); ++k) {
+    const double s = periods[k].logVol;
+    if (!(s > 0.0)) {
+      throw std::runtime_error("CliquetAnalytic: every period after the "
+                               "first needs a positive variance");
+    }
+    smallestVol = std::min(smallestVol, s);
+    variance += s * s;
+    drift += std::max(std::log(periods[k].forward) - 0.5 * s * s, 0.0);
+  }
+  // An even number of intervals, so that every other node is the grid of
+  // step 2h used by the extrapolation.
+  const double extent = drift + kGridStdDevs * std::sqrt(variance);
+  const std::size_t maxIntervals = (CliquetAnalytic::kMaxGridPoints - 1) / 2;
+  std::size_t intervals = static_cast<std::size_t>(
+      std::ceil(0.5 * extent * kStepsPerVol / smallestVol));
+  intervals = std::max<std::size_t>(1, std::min(intervals, maxIntervals));
+  LindleyGrid grid;
+  grid.points = 2 * intervals + 1;
+  grid.h = extent / static_cast<double>(2 * intervals);
+  return grid;
+}
+
+// E[(m F_1 e^{V_2} - 1)^+] and its first two derivatives in m F_1, with
+// V_2 carried by the Lindley recursion over periods 2..n.
+CallValue maxReturnCall(const std::vector<Period> &periods, double moneyness,
+                        const LindleyGrid &grid) {
+  const Period &first = periods.front();
+  const double forward = moneyness * first.forward;
+  if (periods.size() == 1) {
+    return lognormalCall(forward, 1.0, first.logVol);
+  }
+  const double h = grid.h;
+  const std::size_t points = grid.points;
+
+  // Law of V: an atom at 0 and a density on x_j = j h (trapezoid weights
+  // folded into weighted[j] = w_j h g_j).
+  double atom = 1.0;
+  std::vector<double> density(points, 0.0);
+  std::vector<double> weighted(points, 0.0);
+  std::vector<double> kernel(2 * points - 1);
+  for (std::size_t k = periods.size() - 1; k >= 1; --k) {
+    const double s = periods[k].logVol;
+    const double mu = std::log(periods[k].forward) - 0.5 * s * s;
+    for (std::size_t j = 0; j < points; ++j) {
+      const double w = (j == 0 || j + 1 == points) ? 0.5 : 1.0;
+      weighted[j] = w * h * density[j];
+    }
+    // kernel[q] = phi_Y(x_i - x_j) for q = j - i + points - 1, so that the
+    // sum over j for a fixed i reads the kernel forwards.
+    for (std::size_t q = 0; q < kernel.size(); ++q) {
+      const double x =
+          (static_cast<double>(points - 1) - static_cast<double>(q)) * h;
+      kernel[q] = normalPdf((x - mu) / s) / s;
+    }
+    double nextAtom = atom * normalCdf(-mu / s);
+    for (std::size_t j = 0; j < points; ++j) {
+      const double x = static_cast<double>(j) * h;
+      nextAtom += weighted[j] * normalCdf((-x - mu) / s);
+    }
+    for (std::size_t i = 0; i < points; ++i) {
+      const double *row = kernel.data() + (points - 1 - i);
+      double sum = atom * row[0];
+      for (std::size_t j = 0; j < points; ++j) {
+        sum += weighted[j] * row[j];
+      }
+      density[i] = sum;
+    }
+    atom = nextAtom;
+  }
+
+  CallValue result = lognormalCall(forward, 1.0, first.logVol);
+  result.value *= atom;
+  result.dF *= atom;
+  result.dFF *= atom;
+  for (std::size_t j = 0; j < points; ++j) {
+    const double w = (j == 0 || j + 1 == points) ? 0.5 : 1.0;
+    const double mass = w * h * density[j];
+    const double growth = std::exp(static_cast<double>(j) * h);
+    const CallValue call = lognormalCall(forward * growth, 1.0, first.logVol);
+    result.value += mass * call.value;
+    // d/dF of C(F e^x) = e^x C'(F e^x).
+    result.dF += mass * growth * call.dF;
+    result.dFF += mass * growth * growth * call.dFF;
+  }
+  return result;
+}
+// The trapezoid error of the recursion is O(h^2) (the density has a kink at
+// the atom): Richardson extrapolation of the grids of step h and 2h.
+CallValue extrapolatedCall(const std::vector<Period> &periods,
+                           double moneyness, const LindleyGrid &grid) {
+  if (periods.size() == 1) {
+    return maxReturnCall(periods, moneyness, grid);
+  }
+  const CallValue fine = maxReturnCall(periods, moneyness, grid);
+  const CallValue coarse = maxReturnCall(
+      periods, moneyness, LindleyGrid{2.0 * grid.h, grid.points / 2 + 1});
+  auto combine = [](double f, double c) { return (4.0 * f - c) / 3.0; };
+  return {combine(fine.value, coarse.value), combine(fine.dF, coarse.dF),
+          combine(fine.dFF, coarse.dFF), 0.0};
+}
+} // namespace
+
+CliquetAnalytic::CliquetAnalytic(std::vector<double> periodVols)
+    : periodVols_(std::move(periodVols)) {
+  if (periodVols_.empty()) {
+    throw std::runtime_error("CliquetAnalytic: no vol");
+  }
+}
+
+CliquetAnalytic::Result CliquetAnalytic::price(const CliquetBase &product,
+                                               double spot,
+                                               const DiscountCurve &curve,
+                                               double elapsed) const {
+  if (!(product.spot0() > 0.0)) {
+    throw std::runtime_error("CliquetAnalytic: the fixing must be positive");
+  }
+  std::vector<double> times = product.observationTimes();
+  for (double &t : times) {
+    t = std::max(t - elapsed, 0.0);
+  }
+  const double moneyness = spot / product.spot0();
+
+  std::vector<Period> periods;
+  double discount = 1.0;
+  if (times.empty()) {
+    // Paid now on the spot alone (one period of zero length).
+    periods.push_back({1.0, 0.0, 0.0});
+  } else {
+    const TimeGrid grid(times, curve);
+    if (periodVols_.size() != 1 && periodVols_.size() != times.size()) {
+      throw std::runtime_error("CliquetAnalytic: one vol per period expected");
+    }
+    periods = periodsOf(grid, periodVols_);
+    discount = grid.discountFactors.back();
+  }
+
+  if (const auto *capped =
+          dynamic_cast<const CliquetCappedCoupons *>(&product)) {
+    return cappedCoupons(*capped, periods, moneyness, discount);
+  }
+  if (!dynamic_cast<const CliquetMaxReturn *>(&product)) {
+    throw std::runtime_error("CliquetAnalytic: unsupported cliquet");
+  }
+
+  const double scale = discount * product.notional();
+  const double dForward = periods.front().forward / product.spot0();
+  // One grid for the three solves, so that the vega difference is smooth.
+  const LindleyGrid grid =
+      periods.size() > 1 ? lindleyGrid(periods) : LindleyGrid{};
+  const CallValue call = extrapolatedCall(periods, moneyness, grid);
+  Result result;
+  result.price = scale * call.value;
+  result.delta = scale * call.dF * dForward;
+  result.gamma = scale * call.dFF * dForward * dForward;
+
+  auto shiftedVols = [&](double shift) {
+    std::vector<Period> bumped = periods;
+    for (Period &period : bumped) {
+      period.logVol += shift * period.sqrtDt;
+    }
+    return bumped;
+  };
+  const double up =
+      extrapolatedCall(shiftedVols(kVegaBump), moneyness, grid).value;
+  const double down =
+      extrapolatedCall(shiftedVols(-kVegaBump), moneyness, grid).value;
+  result.vega = scale * (up - down) / (2.0 * kVegaBump);
+  return result;
+}
@@ -7,10 +7,11 @@ CliquetBase::CliquetBase(std::string underlying,
     : StructuredProduct(std::move(underlying), std::move(observationTimes)),
       spot0_(spot0), notional_(notional) {}
 
-double CliquetBase::discountedPayoff(const std::vector<double> &path,
-                                     double riskFreeRate) const {
+double CliquetBase::discountedPayoff(PathView path,
+                                     const double *discountFactors) const {
   double amount = payoffImpl(path); // Appelle MaxReturn ou CappedCoupons
   const auto &times = observationTimes();
-  double payTime = times.empty() ? 0.0 : times.back();
-  return amount * std::exp(-riskFreeRate * payTime);
+  // Paid at the last observation date (t = 0 without dates).
+  double discount = times.empty() ? 1.0 : discountFactors[times.size() - 1];
+  return amount * discount;
 }
\ No newline at end of file
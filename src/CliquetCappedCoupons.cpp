@@ -18,8 +18,7 @@ CliquetCappedCoupons::CliquetCappedCoupons(
       participation_(participation),
       cap_(cap) {}
 
-double CliquetCappedCoupons::payoffImpl(
-    const std::vector<double>& path) const {
+double CliquetCappedCoupons::payoffImpl(PathView path) const {
     if (path.empty()) {
         throw std::runtime_error("Cliquet path is empty");
     }
@@ -13,7 +13,7 @@ CliquetMaxReturn::CliquetMaxReturn(std::string underlying,
                   spot0,
                   notional) {}
 
-double CliquetMaxReturn::payoffImpl(const std::vector<double>& path) const {
+double CliquetMaxReturn::payoffImpl(PathView path) const {
     if (path.empty()) {
         throw std::runtime_error("Cliquet path is empty");
     }
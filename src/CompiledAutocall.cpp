@@ -0,0 +1,347 @@
+#include "CompiledAutocall.hpp"
+#include "Json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr double kNone = std::numeric_limits<double>::infinity();
+
+[[noreturn]] void fail(const std::string &what) {
+  throw std::runtime_error("TermSheet: " + what);
+}
+
+// Rejects misspelt members instead of silently pricing the default terms.
+void checkMembers(const JsonValue &section, const std::string &name,
+                  std::initializer_list<const char *> allowed) {
+  if (!section.isObject()) {
+    fail(name + " must be an object");
+  }
+  for (const auto &member : section.asObject()) {
+    const bool known =
+        std::any_of(allowed.begin(), allowed.end(),
+                    [&](const char *key) { return member.first == key; });
+    if (!known) {
+      fail("unknown member " + name + "." + member.first);
+    }
+  }
+}
+
+double number(const JsonValue *value, const std::string &name,
+              double fallback) {
+  if (!value) {
+    return fallback;
+  }
+  if (!value->isNumber()) {
+    fail(name + " must be a number");
+  }
+  return value->asNumber();
+}
+
+// One value per date: a number (or null) for every date, or an array of
+// numbers and nulls. Null ("none at that date") is returned as NaN.
+std::vector<double> schedule(const JsonValue *value, std::size_t dates,
+                             const std::string &name, double fallback) {
+  const double none = std::numeric_limits<double>::quiet_NaN();
+  auto entry = [&](const JsonValue &v) {
+    if (v.isNull()) {
+      return none;
+    }
+    if (!v.isNumber()) {
+      fail(name + " entries must be numbers or null");
+    }
+    return v.asNumber();
+  };
+  if (!value) {
+    return std::vector<double>(dates, fallback);
+  }
+  if (!value->isArray()) {
+    return std::vector<double>(dates, entry(*value));
+  }
+  const auto &items = value->asArray();
+  if (items.size() != dates) {
+    fail(name + " has " + std::to_string(items.size()) + " values for " +
+         std::to_string(dates) + " dates");
+  }
+  std::vector<double> values;
+  values.reserve(dates);
+  for (const auto &item : items) {
+    values.push_back(entry(item));
+  }
+  return values;
+}
+
+BarrierMonitoring monitoring(const JsonValue *value,
+                             BarrierMonitoring fallback) {
+  if (!value) {
+    return fallback;
+  }
+  if (value->type() != JsonValue::Type::String) {
+    fail("protection.monitoring must be a string");
+  }
+  const std::string &text = value->asString();
+  if (text == "maturity") {
+    return BarrierMonitoring::AtMaturity;
+  }
+  if (text == "daily") {
+    return BarrierMonitoring::Daily;
+  }
+  if (text == "continuous") {
+    return BarrierMonitoring::Continuous;
+  }
+  fail("unknown protection.monitoring \"" + text + "\"");
+}
+} // namespace
+
+std::unique_ptr<CompiledAutocall>
+CompiledAutocall::fromTermSheet(const std::string &text,
+                                const TermSheetDefaults &defaults) {
+  JsonValue sheet;
+  try {
+    sheet = JsonValue::parse(text);
+  } catch (const std::runtime_error &ex) {
+    fail(ex.what());
+  }
+  checkMembers(sheet, "term sheet",
+               {"name", "underlying", "initialFixing", "notional",
+                "observationTimes", "autocall", "coupon", "protection"});
+
+  std::string underlying = defaults.underlying;
+  if (const JsonValue *value = sheet.find("underlying")) {
+    if (value->type() != JsonValue::Type::String) {
+      fail("underlying must be a string");
+    }
+    underlying = value->asString();
+  }
+  const double spot0 =
+      number(sheet.find("initialFixing"), "initialFixing",
+             defaults.initialFixing);
+  const double notional =
+      number(sheet.find("notional"), "notional", defaults.notional);
+  if (!(spot0 > 0.0)) {
+    fail("initialFixing must be positive");
+  }
+
+  std::vector<double> times = defaults.observationTimes;
+  if (const JsonValue *value = sheet.find("observationTimes")) {
+    if (!value->isArray()) {
+      fail("observationTimes must be an array");
+    }
+    times.clear();
+    for (const auto &item : value->asArray()) {
+      if (!item.isNumber()) {
+        fail("observationTimes entries must be numbers");
+      }
+      times.push_back(item.asNumber());
+    }
+  }
+  if (times.empty()) {
+    fail("no observation dates");
+  }
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    if (!(times[i] >= 0.0) || (i > 0 && times[i] <= times[i - 1])) {
+      fail("observationTimes must be increasing and non-negative");
+    }
+  }
+  const std::size_t dates = times.size();
+
+  Schedule terms;
+  terms.callBarrier.assign(dates, kNone);
+  terms.callAmount.assign(dates, 0.0);
+  terms.couponBarrier.assign(dates, kNone);
+  terms.couponAmount.assign(dates, 0.0);
+
+  if (const JsonValue *autocall = sheet.find("autocall")) {
+    checkMembers(*autocall, "autocall", {"barrier", "redemption", "coupon"});
+    const auto barriers =
+        schedule(autocall->find("barrier"), dates, "autocall.barrier", 1.0);
+    const auto coupons =
+        schedule(autocall->find("coupon"), dates, "autocall.coupon", 0.0);
+    const double redemption =
+        number(autocall->find("redemption"), "autocall.redemption", 1.0);
+    for (std::size_t i = 0; i < dates; ++i) {
+      if (!std::isnan(barriers[i])) {
+        terms.callBarrier[i] = barriers[i] * spot0;
+        terms.callAmount[i] =
+            notional *
+            (redemption + (std::isnan(coupons[i]) ? 0.0 : coupons[i]));
+      }
+    }
+  }
+
+  if (const JsonValue *coupon = sheet.find("coupon")) {
+    checkMembers(*coupon, "coupon", {"rate", "barrier", "memory"});
+    const auto rates = schedule(coupon->find("rate"), dates, "coupon.rate", 0.0);
+    const auto barriers =
+        schedule(coupon->find("barrier"), dates, "coupon.barrier", 0.0);
+    if (const JsonValue *memory = coupon->find("memory")) {
+      if (memory->type() != JsonValue::Type::Bool) {
+        fail("coupon.memory must be true or false");
+      }
+      terms.memory = memory->asBool();
+    }
+    for (std::size_t i = 0; i < dates; ++i) {
+      if (!std::isnan(barriers[i]) && !std::isnan(rates[i])) {
+        terms.couponBarrier[i] = barriers[i] * spot0;
+        terms.couponAmount[i] = notional * rates[i];
+      }
+    }
+    if (terms.memory) {
+      // PDE layers and the LSM state count unpaid coupons.
+      for (std::size_t i = 1; i < dates; ++i) {
+        if (terms.couponAmount[i] != terms.couponAmount[0]) {
+          fail("memory coupons need the same amount at every date");
+        }
+      }
+    }
+  }
+
+  double protectionBarrier = 0.0; // No protection member: capital protected.
+  double floor = 0.0;
+  BarrierMonitoring protectionMonitoring = defaults.monitoring;
+  if (const JsonValue *protection = sheet.find("protection")) {
+    checkMembers(*protection, "protection", {"barrier", "floor", "monitoring"});
+    protectionBarrier =
+        spot0 * number(protection->find("barrier"), "protection.barrier", 0.0);
+    floor = number(protection->find("floor"), "protection.floor", 0.0);
+    protectionMonitoring =
+        monitoring(protection->find("monitoring"), defaults.monitoring);
+  }
+
+  std::unique_ptr<CompiledAutocall> product(new CompiledAutocall(
+      std::move(underlying), std::move(times), spot0, notional,
+      protectionBarrier, floor, std::move(terms)));
+  product->setProtectionMonitoring(protectionMonitoring);
+  return product;
+}
+
+CompiledAutocall::CompiledAutocall(std::string underlying,
+                                   std::vector<double> observationTimes,
+                                   double spot0, double notional,
+                                   double protectionBarrier, double floor,
+                                   Schedule schedule)
+    : AutocallBase(std::move(underlying), std::move(observationTimes), spot0,
+                   notional,
+                   notional != 0.0 ? schedule.couponAmount.front() / notional
+                                   : 0.0,
+                   schedule.callBarrier.front(), protectionBarrier),
+      floor_(floor), schedule_(std::move(schedule)) {}
+
+double CompiledAutocall::payoff(PathView path, const double *discountFactors,
+                                LifeEvents *events) const {
+  const Schedule &terms = schedule_;
+  const std::size_t dates = times().size();
+  const std::size_t steps = std::min(path.size(), dates);
+  const double carry = terms.memory ? 1.0 : 0.0;
+
+  double totalValue = 0.0;
+  double accrued = 0.0; // Coupon due at the next payment.
+  for (std::size_t i = 0; i < steps; ++i) {
+    const double spot = path[i];
+    accrued = carry * accrued + terms.couponAmount[i];
+    if (spot >= terms.couponBarrier[i]) {
+      totalValue += accrued * discountFactors[i];
+      accrued = 0.0;
+      if (events) {
+        events->couponPaid(i);
+      }
+    }
+    if (spot >= terms.callBarrier[i]) {
+      if (events) {
+        events->called(i);
+      }
+      return totalValue + terms.callAmount[i] * discountFactors[i];
+    }
+  }
+  if (events) {
+    events->matured();
+  }
+  return totalValue + maturityRedemption(path) * discountFactors[dates - 1];
+}
+
+void CompiledAutocall::discountedPayoffs(const double *spots,
+                                         std::size_t count,
+                                         const double *discountFactors,
+                                         double *out) const {
+  if (!hasBatchKernel()) {
+    StructuredProduct::discountedPayoffs(spots, count, discountFactors, out);
+    return;
+  }
+  const Schedule &terms = schedule_;
+  const std::size_t dates = times().size();
+  const double carry = terms.memory ? 1.0 : 0.0;
+  const double barrier = protectionBarrier();
+  const double n = notional();
+  const double floorAmount = n * floor_;
+  const double s0 = spot0();
+  const double finalDf = discountFactors[dates - 1];
+
+  // Masks replace the early exit: a called path keeps running with a zero
+  // alive weight. The barrier tests run in their own loop and the update
+  // loop is plain arithmetic over fixed-size local lanes (no aliasing, no
+  // remainder), so both vectorise across paths even at -O2.
+  constexpr std::size_t kLanes = 64;
+  for (std::size_t first = 0; first < count; first += kLanes) {
+    const std::size_t lanes = std::min(kLanes, count - first);
+    std::array<double, kLanes> spot{}, value{}, accrued{}, paid, hit;
+    std::array<double, kLanes> alive;
+    alive.fill(1.0);
+    for (std::size_t i = 0; i < dates; ++i) {
+      std::copy_n(spots + i * count + first, lanes, spot.begin());
+      const double couponBarrier = terms.couponBarrier[i];
+      const double callBarrier = terms.callBarrier[i];
+      for (std::size_t p = 0; p < kLanes; ++p) {
+        paid[p] = spot[p] >= couponBarrier ? 1.0 : 0.0;
+        hit[p] = spot[p] >= callBarrier ? 1.0 : 0.0;
+      }
+
+      const double couponAmount = terms.couponAmount[i];
+      const double callValue = terms.callAmount[i] * discountFactors[i];
+      const double df = discountFactors[i];
+      for (std::size_t p = 0; p < kLanes; ++p) {
+        const double due = carry * accrued[p] + couponAmount;
+        const double called = alive[p] * hit[p];
+        value[p] += alive[p] * paid[p] * due * df;
+        value[p] += called * callValue;
+        accrued[p] = (1.0 - paid[p]) * due;
+        alive[p] -= called;
+      }
+    }
+
+    // spot now holds the final fixings.
+    for (std::size_t p = 0; p < lanes; ++p) {
+      const double s = spot[p];
+      const double redemption =
+          s >= barrier ? n : std::max(n * (s / s0), floorAmount);
+      out[first + p] = value[p] + alive[p] * redemption * finalDf;
+    }
+  }
+}
+
+AutocallBase::ObservationRule
+CompiledAutocall::observationRule(std::size_t i) const {
+  return {schedule_.callBarrier[i], schedule_.callAmount[i],
+          schedule_.couponBarrier[i], schedule_.couponAmount[i],
+          schedule_.memory};
+}
+
+std::vector<double> CompiledAutocall::redemptionBreakpoints() const {
+  return {protectionBarrier(), spot0() * floor_};
+}
+
+double CompiledAutocall::terminalRedemption(double finalSpot) const {
+  if (finalSpot >= protectionBarrier()) {
+    return notional();
+  }
+  return std::max(notional() * (finalSpot / spot0()), notional() * floor_);
+}
+
+double CompiledAutocall::knockedInRedemption(double finalSpot) const {
+  return std::max(AutocallBase::knockedInRedemption(finalSpot),
+                  notional() * floor_);
+}
@@ -0,0 +1,87 @@
+#include "DiscountCurve.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+DiscountCurve::DiscountCurve(double flatRate)
+    : DiscountCurve(std::vector<double>{1.0}, std::vector<double>{flatRate}) {}
+
+DiscountCurve::DiscountCurve(std::vector<double> pillarTimes,
+                             std::vector<double> zeroRates)
+    : pillarTimes_(std::move(pillarTimes)), zeroRates_(std::move(zeroRates)) {
+  if (pillarTimes_.empty() || pillarTimes_.size() != zeroRates_.size()) {
+    throw std::runtime_error("DiscountCurve: one zero rate per pillar needed");
+  }
+  for (std::size_t k = 0; k < pillarTimes_.size(); ++k) {
+    if (pillarTimes_[k] <= 0.0 ||
+        (k > 0 && pillarTimes_[k] <= pillarTimes_[k - 1])) {
+      throw std::runtime_error(
+          "DiscountCurve: pillars must be positive and increasing");
+    }
+    logDiscounts_.push_back(-zeroRates_[k] * pillarTimes_[k]);
+  }
+}
+
+double DiscountCurve::logDiscount(double t) const {
+  if (t <= pillarTimes_.front()) {
+    return -zeroRates_.front() * t;
+  }
+  const std::size_t last = pillarTimes_.size() - 1;
+  std::size_t k;
+  if (t >= pillarTimes_[last]) {
+    if (last == 0) {
+      return -zeroRates_.front() * t;
+    }
+    k = last; // Extrapolate the last segment (flat forward).
+  } else {
+    k = static_cast<std::size_t>(
+        std::upper_bound(pillarTimes_.begin(), pillarTimes_.end(), t) -
+        pillarTimes_.begin());
+  }
+  const double t0 = pillarTimes_[k - 1];
+  const double t1 = pillarTimes_[k];
+  const double w = (t - t0) / (t1 - t0);
+  return logDiscounts_[k - 1] + w * (logDiscounts_[k] - logDiscounts_[k - 1]);
+}
+
+double DiscountCurve::discountFactor(double t) const {
+  return std::exp(logDiscount(t));
+}
+
+double DiscountCurve::zeroRate(double t) const {
+  return t > 0.0 ? -logDiscount(t) / t : zeroRates_.front();
+}
+
+DiscountCurve DiscountCurve::shifted(double shift) const {
+  std::vector<double> rates = zeroRates_;
+  for (double &rate : rates) {
+    rate += shift;
+  }
+  return DiscountCurve(pillarTimes_, std::move(rates));
+}
+
+TimeGrid::TimeGrid(std::vector<double> observationTimes,
+                   const DiscountCurve &curve)
+    : times(std::move(observationTimes)) {
+  const std::size_t n = times.size();
+  dt.resize(n);
+  sqrtDt.resize(n);
+  logGrowth.resize(n);
+  forwardRates.resize(n);
+  discountFactors.resize(n);
+
+  double prevTime = 0.0;
+  double prevLogDf = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const double logDf = curve.logDiscount(times[i]);
+    dt[i] = std::max(times[i] - prevTime, 0.0);
+    sqrtDt[i] = std::sqrt(dt[i]);
+    logGrowth[i] = dt[i] > 0.0 ? prevLogDf - logDf : 0.0;
+    forwardRates[i] = dt[i] > 0.0 ? logGrowth[i] / dt[i] : 0.0;
+    discountFactors[i] = std::exp(logDf);
+    prevTime = times[i];
+    prevLogDf = logDf;
+  }
+}
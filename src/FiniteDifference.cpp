@@ -0,0 +1,143 @@
+#include "FiniteDifference.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+std::vector<double> makeConcentratedGrid(double lo, double hi,
+                                         std::size_t nodes,
+                                         const std::vector<double> &points,
+                                         double width, double intensity) {
+  if (nodes < 3 || !(hi > lo)) {
+    throw std::runtime_error("Finite difference grid: invalid bounds");
+  }
+  std::vector<double> critical;
+  for (double c : points) {
+    if (c > lo && c < hi) {
+      critical.push_back(c);
+    }
+  }
+  std::sort(critical.begin(), critical.end());
+
+  auto density = [&](double x) {
+    double d = 1.0;
+    for (double c : critical) {
+      d += intensity * width / std::sqrt(width * width + (x - c) * (x - c));
+    }
+    return d;
+  };
+
+  // Cumulative node density on a fine uniform sampling, then inverted.
+  const std::size_t fine = 50 * nodes;
+  const double step = (hi - lo) / static_cast<double>(fine);
+  std::vector<double> cumulative(fine + 1, 0.0);
+  double previous = density(lo);
+  for (std::size_t k = 1; k <= fine; ++k) {
+    const double current = density(lo + step * static_cast<double>(k));
+    cumulative[k] = cumulative[k - 1] + 0.5 * (previous + current) * step;
+    previous = current;
+  }
+
+  std::vector<double> grid(nodes);
+  grid.front() = lo;
+  grid.back() = hi;
+  std::size_t k = 0;
+  for (std::size_t j = 1; j + 1 < nodes; ++j) {
+    const double target = cumulative.back() * static_cast<double>(j) /
+                          static_cast<double>(nodes - 1);
+    while (cumulative[k + 1] < target) {
+      ++k;
+    }
+    const double w =
+        (target - cumulative[k]) / (cumulative[k + 1] - cumulative[k]);
+    grid[j] = lo + step * (static_cast<double>(k) + w);
+  }
+
+  // Centre each critical point in its cell.
+  for (double c : critical) {
+    const auto it = std::upper_bound(grid.begin(), grid.end(), c);
+    const std::size_t j = static_cast<std::size_t>(it - grid.begin()) - 1;
+    if (j == 0 || j + 2 >= nodes) {
+      continue;
+    }
+    const double h = grid[j + 1] - grid[j];
+    const double left = c - 0.5 * h;
+    const double right = c + 0.5 * h;
+    if (left > grid[j - 1] && right < grid[j + 2]) {
+      grid[j] = left;
+      grid[j + 1] = right;
+    }
+  }
+  return grid;
+}
+
+std::vector<Stencil> makeStencils(const std::vector<double> &grid) {
+  const std::size_t n = grid.size();
+  std::vector<Stencil> stencils(n, Stencil{{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}});
+  for (std::size_t j = 1; j + 1 < n; ++j) {
+    const double hm = grid[j] - grid[j - 1];
+    const double hp = grid[j + 1] - grid[j];
+    Stencil &s = stencils[j];
+    s.d1[0] = -hp / (hm * (hm + hp));
+    s.d1[1] = (hp - hm) / (hm * hp);
+    s.d1[2] = hm / (hp * (hm + hp));
+    s.d2[0] = 2.0 / (hm * (hm + hp));
+    s.d2[1] = -2.0 / (hm * hp);
+    s.d2[2] = 2.0 / (hp * (hm + hp));
+  }
+  return stencils;
+}
+
+void solveTridiagonal(const std::vector<double> &lower,
+                      const std::vector<double> &diag,
+                      const std::vector<double> &upper,
+                      std::vector<double> &rhs, std::vector<double> &scratch) {
+  const std::size_t n = rhs.size();
+  if (n == 0) {
+    return;
+  }
+  double beta = diag[0];
+  rhs[0] /= beta;
+  for (std::size_t j = 1; j < n; ++j) {
+    scratch[j] = upper[j - 1] / beta;
+    beta = diag[j] - lower[j] * scratch[j];
+    rhs[j] = (rhs[j] - lower[j] * rhs[j - 1]) / beta;
+  }
+  for (std::size_t j = n - 1; j > 0; --j) {
+    rhs[j - 1] -= scratch[j] * rhs[j];
+  }
+}
+
+void interpolateQuadratic(const std::vector<double> &grid,
+                          const double *values, double x, double &value,
+                          double &first, double &second) {
+  const std::size_t n = grid.size();
+  const auto it = std::lower_bound(grid.begin(), grid.end(), x);
+  std::size_t j = static_cast<std::size_t>(it - grid.begin());
+  // Centre node of the three-point stencil, kept inside the grid.
+  if (j == 0) {
+    j = 1;
+  } else if (j >= n - 1) {
+    j = n - 2;
+  } else if (x - grid[j - 1] < grid[j] - x) {
+    j = j - 1 == 0 ? 1 : j - 1;
+  }
+  const double x0 = grid[j - 1];
+  const double x1 = grid[j];
+  const double x2 = grid[j + 1];
+  const double f0 = values[j - 1];
+  const double f1 = values[j];
+  const double f2 = values[j + 1];
+
+  // Lagrange basis and its derivatives at x.
+  const double l0 = (x - x1) * (x - x2) / ((x0 - x1) * (x0 - x2));
+  const double l1 = (x - x0) * (x - x2) / ((x1 - x0) * (x1 - x2));
+  const double l2 = (x - x0) * (x - x1) / ((x2 - x0) * (x2 - x1));
+  const double d0 = ((x - x1) + (x - x2)) / ((x0 - x1) * (x0 - x2));
+  const double d1 = ((x - x0) + (x - x2)) / ((x1 - x0) * (x1 - x2));
+  const double d2 = ((x - x0) + (x - x1)) / ((x2 - x0) * (x2 - x1));
+  value = l0 * f0 + l1 * f1 + l2 * f2;
+  first = d0 * f0 + d1 * f1 + d2 * f2;
+  second = 2.0 * (f0 / ((x0 - x1) * (x0 - x2)) + f1 / ((x1 - x0) * (x1 - x2)) +
+                  f2 / ((x2 - x0) * (x2 - x1)));
+}
@@ -0,0 +1,471 @@
+#include "GreeksEngine.hpp"
+
+#include "KahanSum.hpp"
+#include "Parallel.hpp"
+#include "PayoffDistribution.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+enum Scenario : std::size_t {
+  kBase,
+  kSpotUp,
+  kSpotDown,
+  kVolUp,
+  kVolDown,
+  kSpotUpVolUp,
+  kSpotUpVolDown,
+  kSpotDownVolUp,
+  kSpotDownVolDown,
+  kRateUp,
+  kRateDown,
+  kTimeShift,
+  kScenarioCount
+};
+
+struct BlockSums {
+  std::array<KahanSum, kScenarioCount> scenario;
+  KahanSum control; // Control variate C.
+  // Centred moments of the base payoff V (x) and of C (y) over the block.
+  CentredMoments moments;
+};
+
+// Flat layout of one BlockSums: the scenario sums, then the centred moments
+// of the block (about the block means, which follow from the sums of V and
+// C and the block's path count).
+enum SumValue : std::size_t {
+  kBaseM2 = kScenarioCount, // sum (V - mean V)^2
+  kControl,                 // sum C
+  kControlM2,               // sum (C - mean C)^2
+  kCrossM2,                 // sum (V - mean V)(C - mean C)
+  kSumValues
+};
+static_assert(kSumValues == GreeksEngine::kBlockSumValues,
+              "GreeksEngine::kBlockSumValues is the flat BlockSums size");
+
+// Normals and paths of one thread, kept from one block (and one pricing) to
+// the next: the pool threads simulate without allocating once warm.
+struct PathBuffers {
+  std::vector<double> normals;
+  std::vector<double> basePath, volUpPath, volDownPath, thetaPath, scratch;
+  std::vector<double> controlPath;
+  std::vector<double> baseVar, volUpVar, volDownVar, thetaVar;
+};
+
+void scalePath(const std::vector<double> &path, double factor,
+               std::vector<double> &out) {
+  out.resize(path.size());
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    out[i] = path[i] * factor;
+  }
+}
+
+void scalePath(const std::vector<double> &path,
+               const std::vector<double> &factors, std::vector<double> &out) {
+  out.resize(path.size());
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    out[i] = path[i] * factors[i];
+  }
+}
+
+std::vector<double> curveScales(const TimeGrid &base, const TimeGrid &bumped) {
+  std::vector<double> scales(base.times.size());
+  for (std::size_t i = 0; i < scales.size(); ++i) {
+    scales[i] = base.discountFactors[i] / bumped.discountFactors[i];
+  }
+  return scales;
+}
+
+// Estimates of product k from the flat per-block sums (block b of product k
+// at (b * count + k) * kSumValues).
+GreeksEstimate estimate(const std::vector<double> &sums, std::size_t k,
+                        std::size_t count, std::size_t paths, double h,
+                        const GreeksBumps &bumps,
+                        const ControlVariate *control) {
+  GreeksEstimate result;
+  // Merged in block order: results do not depend on the number of threads
+  // (or processes) that computed the blocks.
+  std::array<KahanSum, kScenarioCount> totals;
+  CentredMoments moments;
+  for (std::size_t b = 0, at = k * kSumValues; at < sums.size();
+       ++b, at += count * kSumValues) {
+    const double *block = sums.data() + at;
+    for (std::size_t s = 0; s < kScenarioCount; ++s) {
+      totals[s].add(block[s]);
+    }
+    CentredMoments blockMoments;
+    blockMoments.count =
+        static_cast<double>(pathBlockEnd(b, paths) - b * kPathsPerBlock);
+    blockMoments.meanX = block[kBase] / blockMoments.count;
+    blockMoments.meanY = block[kControl] / blockMoments.count;
+    blockMoments.m2X = block[kBaseM2];
+    blockMoments.m2Y = block[kControlM2];
+    blockMoments.cXY = block[kCrossM2];
+    moments.merge(blockMoments);
+  }
+  if (paths == 0) {
+    return result;
+  }
+  const double n = static_cast<double>(paths);
+  std::array<double, kScenarioCount> mean;
+  for (std::size_t s = 0; s < kScenarioCount; ++s) {
+    mean[s] = totals[s].sum / n;
+  }
+
+  result.price = mean[kBase];
+  result.payoffMean = result.price;
+  const double baseVariance = moments.varianceX();
+  result.stdError = std::sqrt(baseVariance / n);
+  if (control && n > 1) {
+    const double controlMean = moments.meanY;
+    const double controlVariance = moments.varianceY();
+    const double covariance = moments.covariance();
+    if (controlVariance > 0.0) {
+      const double beta = covariance / controlVariance;
+      result.price -= beta * (controlMean - control->mean);
+      const double residual = std::max(
+          baseVariance - covariance * covariance / controlVariance, 0.0);
+      result.stdError = std::sqrt(residual / n);
+    }
+  }
+
+  if (h > 0.0) {
+    result.delta = (mean[kSpotUp] - mean[kSpotDown]) / (2.0 * h);
+    result.gamma =
+        (mean[kSpotUp] - 2.0 * mean[kBase] + mean[kSpotDown]) / (h * h);
+  }
+  // Up and down vol shifts may differ (one-sided near zero vol).
+  const double dv = bumps.vol + bumps.volDown;
+  if (dv > 0.0) {
+    result.vega = (mean[kVolUp] - mean[kVolDown]) / dv;
+  }
+  if (h > 0.0 && dv > 0.0) {
+    result.vanna = (mean[kSpotUpVolUp] - mean[kSpotUpVolDown] -
+                    mean[kSpotDownVolUp] + mean[kSpotDownVolDown]) /
+                   (2.0 * h * dv);
+  }
+  if (bumps.rate > 0.0) {
+    result.rho = (mean[kRateUp] - mean[kRateDown]) / (2.0 * bumps.rate);
+  }
+  if (bumps.timeShift > 0.0) {
+    result.theta = (mean[kTimeShift] - mean[kBase]) / bumps.timeShift;
+  }
+  return result;
+}
+} // namespace
+
+GreeksEngine::GreeksEngine(const PathModelBase &model,
+                           const PathModelBase &volUp,
+                           const PathModelBase &volDown, GreeksBumps bumps)
+    : model_(model), volUp_(volUp), volDown_(volDown), bumps_(bumps) {}
+
+GreeksEstimate GreeksEngine::run(const StructuredProduct &product, double spot,
+                                 const DiscountCurve &curve, std::size_t paths,
+                                 unsigned int seed,
+                                 const ControlVariate *control,
+                                 PathStatistics statistics) const {
+  return simulate({&product}, spot, curve, paths, seed, {control},
+                  {statistics})
+      .front();
+}
+
+std::vector<GreeksEstimate>
+GreeksEngine::runBatch(const std::vector<const StructuredProduct *> &products,
+                       double spot, const DiscountCurve &curve,
+                       std::size_t paths, unsigned int seed,
+                       const std::vector<PathStatistics> &statistics) const {
+  for (const StructuredProduct *product : products) {
+    if (product->observationTimes() != products.front()->observationTimes()) {
+      throw std::runtime_error(
+          "GreeksEngine: a batch needs a single observation schedule");
+    }
+  }
+  if (!statistics.empty() && statistics.size() != products.size()) {
+    throw std::runtime_error(
+        "GreeksEngine: one set of path statistics per product expected");
+  }
+  return simulate(products, spot, curve, paths, seed,
+                  std::vector<const ControlVariate *>(products.size()),
+                  statistics.empty()
+                      ? std::vector<PathStatistics>(products.size())
+                      : statistics);
+}
+
+std::vector<double>
+GreeksEngine::blockSums(const StructuredProduct &product, double spot,
+                        const DiscountCurve &curve, std::size_t paths,
+                        unsigned int seed, std::size_t firstBlock,
+                        std::size_t lastBlock,
+                        const ControlVariate *control,
+                        PathStatistics statistics) const {
+  if (product.observationTimes().empty()) {
+    throw std::runtime_error("GreeksEngine: no block sums without dates");
+  }
+  if (firstBlock > lastBlock || lastBlock > pathBlockCount(paths)) {
+    throw std::runtime_error("GreeksEngine: block range out of the run");
+  }
+  return sumBlocks({&product}, spot, curve, paths, seed, {control},
+                   {statistics}, firstBlock, lastBlock);
+}
+
+GreeksEstimate GreeksEngine::fromBlockSums(const StructuredProduct &product,
+                                           const std::vector<double> &sums,
+                                           double spot, std::size_t paths,
+                                           const ControlVariate *control) const {
+  if (product.observationTimes().empty()) {
+    throw std::runtime_error("GreeksEngine: no block sums without dates");
+  }
+  if (sums.size() != pathBlockCount(paths) * kBlockSumValues) {
+    throw std::runtime_error("GreeksEngine: block sums do not cover the run");
+  }
+  return estimate(sums, 0, 1, paths, spot * bumps_.spotFraction, bumps_,
+                  control);
+}
+
+std::vector<GreeksEstimate> GreeksEngine::simulate(
+    const std::vector<const StructuredProduct *> &products, double spot,
+    const DiscountCurve &curve, std::size_t paths, unsigned int seed,
+    const std::vector<const ControlVariate *> &controls,
+    const std::vector<PathStatistics> &statistics) const {
+  const double up = 1.0 + bumps_.spotFraction;
+  const double down = 1.0 - bumps_.spotFraction;
+  const double h = spot * bumps_.spotFraction;
+  const std::size_t count = products.size();
+  std::vector<GreeksEstimate> results(count);
+  if (count == 0) {
+    return results;
+  }
+  const auto &times = products.front()->observationTimes();
+
+  if (times.empty()) {
+    // Immediate payoff: only the spot moves it.
+    const double noDiscount = 1.0;
+    const std::vector<double> base{spot}, spotUp{spot * up},
+        spotDown{spot * down};
+    for (std::size_t k = 0; k < count; ++k) {
+      const StructuredProduct &product = *products[k];
+      GreeksEstimate &result = results[k];
+      result.price = product.discountedPayoff(base, &noDiscount);
+      result.payoffMean = result.price;
+      if (PayoffDistribution *distribution = statistics[k].distribution) {
+        // Every path pays the same.
+        PayoffDistribution block = distribution->emptyCopy();
+        for (std::size_t p = 0; p < paths; ++p) {
+          block.add(result.price);
+        }
+        distribution->merge(block);
+      }
+      if (LifeEvents *events = statistics[k].events) {
+        events->matured(static_cast<double>(paths));
+      }
+      if (h > 0.0) {
+        const double vUp = product.discountedPayoff(spotUp, &noDiscount);
+        const double vDown = product.discountedPayoff(spotDown, &noDiscount);
+        result.delta = (vUp - vDown) / (2.0 * h);
+        result.gamma = (vUp - 2.0 * result.price + vDown) / (h * h);
+      }
+    }
+    return results;
+  }
+
+  const std::vector<double> sums =
+      sumBlocks(products, spot, curve, paths, seed, controls, statistics, 0,
+                pathBlockCount(paths));
+  for (std::size_t k = 0; k < count; ++k) {
+    results[k] = estimate(sums, k, count, paths, h, bumps_, controls[k]);
+  }
+  return results;
+}
+
+std::vector<double> GreeksEngine::sumBlocks(
+    const std::vector<const StructuredProduct *> &products, double spot,
+    const DiscountCurve &curve, std::size_t paths, unsigned int seed,
+    const std::vector<const ControlVariate *> &controls,
+    const std::vector<PathStatistics> &statistics,
+    std::size_t firstBlock, std::size_t lastBlock) const {
+  const double up = 1.0 + bumps_.spotFraction;
+  const double down = 1.0 - bumps_.spotFraction;
+  const std::size_t count = products.size();
+  const auto &times = products.front()->observationTimes();
+
+  const TimeGrid grid(times, curve);
+  const TimeGrid rateUpGrid(times, curve.shifted(bumps_.rate));
+  const TimeGrid rateDownGrid(times, curve.shifted(-bumps_.rate));
+  const std::vector<double> rateUpScales = curveScales(grid, rateUpGrid);
+  const std::vector<double> rateDownScales = curveScales(grid, rateDownGrid);
+
+  std::vector<double> shiftedTimes(times.size());
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    shiftedTimes[i] = std::max(times[i] - bumps_.timeShift, 0.0);
+  }
+  const TimeGrid thetaGrid(shiftedTimes, curve);
+
+  const std::size_t baseCount = model_.normalCount(grid);
+  const std::size_t thetaCount = model_.normalCount(thetaGrid);
+  const std::size_t thetaOffset =
+      baseCount > thetaCount ? baseCount - thetaCount : 0;
+  const bool bridge =
+      std::any_of(products.begin(), products.end(),
+                  [](const StructuredProduct *p) { return p->needsBridge(); });
+
+  // blocks[(b - firstBlock) * count + k]: sums of product k over block b,
+  // and its statistics when they were asked for. The sums reuse the
+  // storage of the thread's previous call (sumBlocks does not nest); the
+  // workers reach them through the reference, not their own thread_local.
+  thread_local std::vector<BlockSums> callerBlocks;
+  std::vector<BlockSums> &blocks = callerBlocks;
+  blocks.assign((lastBlock - firstBlock) * count, BlockSums{});
+  std::vector<std::unique_ptr<PayoffDistribution>> blockDistributions(
+      blocks.size());
+  std::vector<std::unique_ptr<LifeEvents>> blockEvents(blocks.size());
+  parallelFor(lastBlock - firstBlock, [&](std::size_t i) {
+    const std::size_t b = firstBlock + i;
+    for (std::size_t k = 0; k < count; ++k) {
+      if (statistics[k].distribution) {
+        blockDistributions[i * count + k] =
+            std::make_unique<PayoffDistribution>(
+                statistics[k].distribution->emptyCopy());
+      }
+      if (statistics[k].events) {
+        blockEvents[i * count + k] = std::make_unique<LifeEvents>(times.size());
+      }
+    }
+    std::mt19937 rng = pathBlockRng(seed, b);
+    thread_local PathBuffers buffers;
+    std::vector<double> &normals = buffers.normals;
+    std::vector<double> &basePath = buffers.basePath;
+    std::vector<double> &volUpPath = buffers.volUpPath;
+    std::vector<double> &volDownPath = buffers.volDownPath;
+    std::vector<double> &thetaPath = buffers.thetaPath;
+    std::vector<double> &scratch = buffers.scratch;
+    std::vector<double> &controlPath = buffers.controlPath;
+    std::vector<double> &baseVar = buffers.baseVar;
+    std::vector<double> &volUpVar = buffers.volUpVar;
+    std::vector<double> &volDownVar = buffers.volDownVar;
+    std::vector<double> &thetaVar = buffers.thetaVar;
+    if (bridge) {
+      baseVar.resize(times.size());
+      volUpVar.resize(times.size());
+      volDownVar.resize(times.size());
+      thetaVar.resize(times.size());
+    }
+    double *const baseVarData = bridge ? baseVar.data() : nullptr;
+    double *const volUpVarData = bridge ? volUpVar.data() : nullptr;
+    double *const volDownVarData = bridge ? volDownVar.data() : nullptr;
+    double *const thetaVarData = bridge ? thetaVar.data() : nullptr;
+
+    for (std::size_t p = b * kPathsPerBlock; p < pathBlockEnd(b, paths); ++p) {
+      drawNormals(rng, baseCount, normals);
+      normals.resize(std::max(baseCount, thetaCount));
+      model_.buildPath(spot, grid, normals.data(), basePath, baseVarData);
+      volUp_.buildPath(spot, grid, normals.data(), volUpPath, volUpVarData);
+      volDown_.buildPath(spot, grid, normals.data(), volDownPath,
+                         volDownVarData);
+      model_.buildPath(spot, thetaGrid, normals.data() + thetaOffset,
+                       thetaPath, thetaVarData);
+
+      // The four paths are built once and shared by every product.
+      for (std::size_t k = 0; k < count; ++k) {
+        const StructuredProduct &product = *products[k];
+        BlockSums &sums = blocks[i * count + k];
+
+        // Payoff of a path started at start with the interval variances var,
+        // recording its life in events when given (base scenario only).
+        auto value = [&](const std::vector<double> &path, double start,
+                         const double *var, const double *discountFactors,
+                         LifeEvents *events = nullptr) {
+          PathView view(path);
+          if (var) {
+            view = view.withBridge(start, var);
+          }
+          return events ? product.discountedPayoff(view, discountFactors,
+                                                   *events)
+                        : product.discountedPayoff(view, discountFactors);
+        };
+        // Spot-bumped copy of a path (scales the bridge start too).
+        auto scaled = [&](const std::vector<double> &path, double factor,
+                          const double *var) {
+          scalePath(path, factor, scratch);
+          return value(scratch, spot * factor, var,
+                       grid.discountFactors.data());
+        };
+
+        const double *df = grid.discountFactors.data();
+        std::array<double, kScenarioCount> v;
+        v[kBase] = value(basePath, spot, baseVarData, df,
+                         blockEvents[i * count + k].get());
+        v[kSpotUp] = scaled(basePath, up, baseVarData);
+        v[kSpotDown] = scaled(basePath, down, baseVarData);
+        v[kVolUp] = value(volUpPath, spot, volUpVarData, df);
+        v[kVolDown] = value(volDownPath, spot, volDownVarData, df);
+        v[kSpotUpVolUp] = scaled(volUpPath, up, volUpVarData);
+        v[kSpotUpVolDown] = scaled(volDownPath, up, volDownVarData);
+        v[kSpotDownVolUp] = scaled(volUpPath, down, volUpVarData);
+        v[kSpotDownVolDown] = scaled(volDownPath, down, volDownVarData);
+        // The curve only shifts log(S): interval variances are unchanged.
+        scalePath(basePath, rateUpScales, scratch);
+        v[kRateUp] = value(scratch, spot, baseVarData,
+                           rateUpGrid.discountFactors.data());
+        scalePath(basePath, rateDownScales, scratch);
+        v[kRateDown] = value(scratch, spot, baseVarData,
+                             rateDownGrid.discountFactors.data());
+        v[kTimeShift] = value(thetaPath, spot, thetaVarData,
+                              thetaGrid.discountFactors.data());
+
+        for (std::size_t s = 0; s < kScenarioCount; ++s) {
+          sums.scenario[s].add(v[s]);
+        }
+        if (PayoffDistribution *distribution =
+                blockDistributions[i * count + k].get()) {
+          distribution->add(v[kBase]);
+        }
+
+        if (const ControlVariate *control = controls[k]) {
+          control->model->buildPath(spot, grid, normals.data(), controlPath,
+                                    nullptr);
+          const double c = product.discountedPayoff(controlPath, df);
+          sums.control.add(c);
+          sums.moments.add(v[kBase], c);
+        } else {
+          sums.moments.add(v[kBase]);
+        }
+      }
+    }
+    for (std::size_t k = 0; k < count; ++k) {
+      if (PayoffDistribution *distribution =
+              blockDistributions[i * count + k].get()) {
+        distribution->digest().compress(); // Drop the block's buffer.
+      }
+    }
+  });
+
+  // Merged in block order, like the sums.
+  for (std::size_t j = 0; j < blocks.size(); ++j) {
+    if (blockDistributions[j]) {
+      statistics[j % count].distribution->merge(*blockDistributions[j]);
+      blockDistributions[j].reset();
+    }
+    if (blockEvents[j]) {
+      statistics[j % count].events->merge(*blockEvents[j]);
+    }
+  }
+
+  std::vector<double> flat(blocks.size() * kSumValues);
+  for (std::size_t j = 0; j < blocks.size(); ++j) {
+    double *out = flat.data() + j * kSumValues;
+    for (std::size_t s = 0; s < kScenarioCount; ++s) {
+      out[s] = blocks[j].scenario[s].sum;
+    }
+    out[kBaseM2] = blocks[j].moments.m2X;
+    out[kControl] = blocks[j].control.sum;
+    out[kControlM2] = blocks[j].moments.m2Y;
+    out[kCrossM2] = blocks[j].moments.cXY;
+  }
+  return flat;
+}
@@ -2,42 +2,71 @@
 
 #include <algorithm>
 #include <cmath>
-#include <random>
+#include <stdexcept>
+
+namespace {
+// Use a finer time step for simulation accuracy (sub-stepping)
+// to avoid discretization errors with the stochastic volatility.
+constexpr double kMaxStep = 0.01;
+} // namespace
 
 HestonMC::HestonMC(double v0, double kappa, double theta, double xi, double rho)
     : v0_(v0), kappa_(kappa), theta_(theta), xi_(xi), rho_(rho) {}
 
-std::vector<double> HestonMC::simulatePath(double spot0,
-                                           const std::vector<double>& times,
-                                           const MarketData& data,
-                                           std::mt19937& rng) const {
-    std::vector<double> path(times.size());
-    const double r = data.riskFreeRate();
+std::size_t HestonMC::normalCount(const TimeGrid& grid) const {
+    // Same sub-step walk as buildPath().
+    std::size_t count = 0;
+    double prevTime = 0.0;
+    for (const double targetTime : grid.times) {
+        double currentTime = prevTime;
+        while (currentTime < targetTime) {
+            const double dt = std::min(kMaxStep, targetTime - currentTime);
+            if (dt <= 1e-8) break;
+            count += 2;
+            currentTime += dt;
+        }
+        prevTime = targetTime;
+    }
+    return count;
+}
+
+void HestonMC::buildPath(double spot0,
+                         const TimeGrid& grid,
+                         const double* normals,
+                         std::vector<double>& path,
+                         double* intervalVariance) const {
+    const std::vector<double>& times = grid.times;
+    path.resize(times.size());
 
-    std::normal_distribution<double> dist(0.0, 1.0);
+    const double kappa = kappa_;
+    const double theta = theta_;
+    const double xi = xi_;
+    const double rho = rho_;
+    const double rhoBar = std::sqrt(1.0 - rho * rho);
 
     double spot = spot0;
     double v = v0_; // Current variance state
     double prevTime = 0.0;
 
-    // Use a finer time step for simulation accuracy (sub-stepping)
-    // to avoid discretization errors with the stochastic volatility.
-    const double dtStep = 0.01; // Max time step size
-
     for (std::size_t i = 0; i < times.size(); ++i) {
         double currentTime = prevTime;
         const double targetTime = times[i];
+        // Forward rate of the interval, constant over its sub-steps.
+        const double r = grid.forwardRates[i];
+        double integratedVariance = 0.0;
 
         while (currentTime < targetTime) {
             // Calculate actual time step for this iteration
-            const double dt = std::min(dtStep, targetTime - currentTime);
+            const double dt = std::min(kMaxStep, targetTime - currentTime);
             if (dt <= 1e-8) break;
+            const double h = dt;
+            const double sqrtH = std::sqrt(dt);
 
             // Generate correlated Brownian motions
-            const double z1 = dist(rng); // For spot
-            const double z2 = dist(rng); // Uncorrelated
+            const double z1 = *normals++; // For spot
+            const double z2 = *normals++; // Uncorrelated
             // Correlated noise for variance:
-            const double zv = rho_ * z1 + std::sqrt(1.0 - rho_ * rho_) * z2;
+            const double zv = rho * z1 + rhoBar * z2;
 
             // Update Variance (using Reflection or Truncation to keep v >= 0)
             // Here we use a simple full truncation scheme for stability:
@@ -45,18 +74,85 @@ std::vector<double> HestonMC::simulatePath(double spot0,
             const double sqrt_v = std::sqrt(v_plus);
 
             // dv = kappa * (theta - v) * dt + xi * sqrt(v) * dW_v
-            v += kappa_ * (theta_ - v_plus) * dt + xi_ * sqrt_v * std::sqrt(dt) * zv;
+            v += kappa * (theta - v_plus) * h + xi * sqrt_v * sqrtH * zv;
 
             // Update Spot
             // dS = S * r * dt + S * sqrt(v) * dW_s
-            spot *= std::exp((r - 0.5 * v_plus) * dt + sqrt_v * std::sqrt(dt) * z1);
+            spot *= std::exp((r - 0.5 * v_plus) * h +
+                             sqrt_v * sqrtH * z1);
+            integratedVariance += v_plus * dt;
 
             currentTime += dt;
         }
 
         path[i] = spot;
+        if (intervalVariance) {
+            intervalVariance[i] = integratedVariance;
+        }
         prevTime = targetTime;
     }
+}
 
-    return path;
-}
\ No newline at end of file
+HestonControlMC::HestonControlMC(double v0, double kappa, double theta,
+                                 const TimeGrid& grid)
+    : v0_(v0), kappa_(kappa), theta_(theta), vols_(grid.times.size(), 0.0) {
+    double prevTime = 0.0;
+    for (std::size_t i = 0; i < vols_.size(); ++i) {
+        const double a = prevTime;
+        const double b = std::max(grid.times[i], a);
+        prevTime = b;
+        if (b - a <= 0.0) {
+            continue;
+        }
+        // E[v_t] = theta + (v0 - theta) e^{-kappa t}, integrated over (a, b].
+        const double decay =
+            kappa_ > 0.0 ? (std::exp(-kappa_ * a) - std::exp(-kappa_ * b)) /
+                               kappa_
+                         : b - a;
+        const double variance = theta_ * (b - a) + (v0_ - theta_) * decay;
+        vols_[i] = std::sqrt(std::max(variance, 0.0) / (b - a));
+    }
+}
+
+std::size_t HestonControlMC::normalCount(const TimeGrid& grid) const {
+    return HestonMC(v0_, kappa_, theta_, 0.0, 0.0).normalCount(grid);
+}
+
+void HestonControlMC::buildPath(double spot0,
+                                const TimeGrid& grid,
+                                const double* normals,
+                                std::vector<double>& path,
+                                double* intervalVariance) const {
+    const std::vector<double>& times = grid.times;
+    if (times.size() != vols_.size()) {
+        throw std::runtime_error(
+            "HestonControlMC: grid differs from the construction grid");
+    }
+    path.resize(times.size());
+
+    double logSpot = std::log(spot0);
+    double prevTime = 0.0;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        // Brownian increment of the interval from the spot normals of the
+        // Heston sub-steps (the variance normals are skipped).
+        double currentTime = prevTime;
+        double increment = 0.0;
+        double elapsed = 0.0;
+        while (currentTime < times[i]) {
+            const double dt = std::min(kMaxStep, times[i] - currentTime);
+            if (dt <= 1e-8) break;
+            increment += std::sqrt(dt) * normals[0];
+            normals += 2;
+            elapsed += dt;
+            currentTime += dt;
+        }
+        const double vol = vols_[i];
+        logSpot += grid.logGrowth[i] - 0.5 * vol * vol * elapsed +
+                   vol * increment;
+        path[i] = std::exp(logSpot);
+        if (intervalVariance) {
+            intervalVariance[i] = vol * vol * elapsed;
+        }
+        prevTime = times[i];
+    }
+}
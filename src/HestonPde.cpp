@@ -0,0 +1,401 @@
+#include "HestonPde.hpp"
+#include "FiniteDifference.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Node (i, j) of the (spot, variance) grid is stored at j * nS + i, so spot
+// lines are contiguous and variance lines have stride nS.
+struct Layout {
+  std::size_t nS;
+  std::size_t nV;
+  std::size_t at(std::size_t i, std::size_t j) const { return j * nS + i; }
+  std::size_t size() const { return nS * nV; }
+};
+
+// Three-point operator along one direction, one row per grid node.
+struct LineOperator {
+  std::vector<double> lo;
+  std::vector<double> mid;
+  std::vector<double> up;
+};
+
+// Heston generator split as A = A0 (mixed) + A1 (spot) + A2 (variance);
+// the -rV term is shared equally between A1 and A2.
+struct Operators {
+  Layout layout;
+  LineOperator spot;
+  LineOperator variance;
+  std::vector<double> mixed; // rho * xi * v * S at interior nodes.
+  std::vector<Stencil> sStencil;
+  std::vector<Stencil> vStencil;
+};
+
+Operators makeOperators(const std::vector<double> &sGrid,
+                        const std::vector<double> &vGrid, double kappa,
+                        double theta, double xi, double rho, double rate) {
+  const Layout layout{sGrid.size(), vGrid.size()};
+  const std::size_t nS = layout.nS;
+  const std::size_t nV = layout.nV;
+  Operators ops{layout,
+                {std::vector<double>(layout.size(), 0.0),
+                 std::vector<double>(layout.size(), 0.0),
+                 std::vector<double>(layout.size(), 0.0)},
+                {std::vector<double>(layout.size(), 0.0),
+                 std::vector<double>(layout.size(), 0.0),
+                 std::vector<double>(layout.size(), 0.0)},
+                std::vector<double>(layout.size(), 0.0),
+                makeStencils(sGrid),
+                makeStencils(vGrid)};
+
+  const double hS = sGrid[nS - 1] - sGrid[nS - 2];
+  for (std::size_t j = 0; j < nV; ++j) {
+    const double v = vGrid[j];
+    for (std::size_t i = 0; i < nS; ++i) {
+      const std::size_t k = layout.at(i, j);
+      const double s = sGrid[i];
+
+      // Spot direction.
+      if (i == 0) {
+        ops.spot.mid[k] = -0.5 * rate; // S = 0 only earns the rate.
+      } else if (i + 1 == nS) {
+        ops.spot.lo[k] = -rate * s / hS; // Linear value at Smax.
+        ops.spot.mid[k] = rate * s / hS - 0.5 * rate;
+      } else {
+        const Stencil &st = ops.sStencil[i];
+        const double a = 0.5 * v * s * s;
+        const double b = rate * s;
+        ops.spot.lo[k] = a * st.d2[0] + b * st.d1[0];
+        ops.spot.mid[k] = a * st.d2[1] + b * st.d1[1] - 0.5 * rate;
+        ops.spot.up[k] = a * st.d2[2] + b * st.d1[2];
+      }
+
+      // Variance direction.
+      if (i == 0) {
+        ops.variance.mid[k] = -0.5 * rate;
+      } else if (j == 0) {
+        // v = 0: diffusion vanishes, upwind drift kappa * theta >= 0.
+        const double h = vGrid[1] - vGrid[0];
+        ops.variance.mid[k] = -kappa * theta / h - 0.5 * rate;
+        ops.variance.up[k] = kappa * theta / h;
+      } else if (j + 1 == nV) {
+        // v = vmax: V_v = 0 (reflected ghost node).
+        const double h = vGrid[j] - vGrid[j - 1];
+        ops.variance.lo[k] = xi * xi * v / (h * h);
+        ops.variance.mid[k] = -xi * xi * v / (h * h) - 0.5 * rate;
+      } else {
+        const Stencil &st = ops.vStencil[j];
+        const double a = 0.5 * xi * xi * v;
+        const double b = kappa * (theta - v);
+        ops.variance.lo[k] = a * st.d2[0] + b * st.d1[0];
+        ops.variance.mid[k] = a * st.d2[1] + b * st.d1[1] - 0.5 * rate;
+        ops.variance.up[k] = a * st.d2[2] + b * st.d1[2];
+      }
+
+      if (i > 0 && i + 1 < nS && j > 0 && j + 1 < nV) {
+        ops.mixed[k] = rho * xi * v * s;
+      }
+    }
+  }
+  return ops;
+}
+
+// out = A1 U (spot lines).
+void applySpot(const Operators &ops, const std::vector<double> &u,
+               std::vector<double> &out) {
+  const Layout &l = ops.layout;
+  for (std::size_t j = 0; j < l.nV; ++j) {
+    for (std::size_t i = 0; i < l.nS; ++i) {
+      const std::size_t k = l.at(i, j);
+      double value = ops.spot.mid[k] * u[k];
+      if (i > 0) {
+        value += ops.spot.lo[k] * u[k - 1];
+      }
+      if (i + 1 < l.nS) {
+        value += ops.spot.up[k] * u[k + 1];
+      }
+      out[k] = value;
+    }
+  }
+}
+
+// out = A2 U (variance lines).
+void applyVariance(const Operators &ops, const std::vector<double> &u,
+                   std::vector<double> &out) {
+  const Layout &l = ops.layout;
+  for (std::size_t j = 0; j < l.nV; ++j) {
+    for (std::size_t i = 0; i < l.nS; ++i) {
+      const std::size_t k = l.at(i, j);
+      double value = ops.variance.mid[k] * u[k];
+      if (j > 0) {
+        value += ops.variance.lo[k] * u[k - l.nS];
+      }
+      if (j + 1 < l.nV) {
+        value += ops.variance.up[k] * u[k + l.nS];
+      }
+      out[k] = value;
+    }
+  }
+}
+
+// out = A0 U (mixed derivative, nine-point stencil).
+void applyMixed(const Operators &ops, const std::vector<double> &u,
+                std::vector<double> &out) {
+  const Layout &l = ops.layout;
+  std::fill(out.begin(), out.end(), 0.0);
+  for (std::size_t j = 1; j + 1 < l.nV; ++j) {
+    const Stencil &sv = ops.vStencil[j];
+    for (std::size_t i = 1; i + 1 < l.nS; ++i) {
+      const std::size_t k = l.at(i, j);
+      if (ops.mixed[k] == 0.0) {
+        continue;
+      }
+      const Stencil &ss = ops.sStencil[i];
+      double cross = 0.0;
+      for (int b = 0; b < 3; ++b) {
+        const std::size_t row = k - l.nS + static_cast<std::size_t>(b) * l.nS;
+        cross += sv.d1[b] * (ss.d1[0] * u[row - 1] + ss.d1[1] * u[row] +
+                             ss.d1[2] * u[row + 1]);
+      }
+      out[k] = ops.mixed[k] * cross;
+    }
+  }
+}
+
+// Implicit systems (I - c A1) and (I - c A2) for a given c = theta * k.
+struct ImplicitSystems {
+  double c;
+  LineOperator spot;
+  LineOperator variance;
+};
+
+ImplicitSystems makeSystems(const Operators &ops, double c) {
+  const std::size_t n = ops.layout.size();
+  ImplicitSystems sys{c,
+                      {std::vector<double>(n), std::vector<double>(n),
+                       std::vector<double>(n)},
+                      {std::vector<double>(n), std::vector<double>(n),
+                       std::vector<double>(n)}};
+  for (std::size_t k = 0; k < n; ++k) {
+    sys.spot.lo[k] = -c * ops.spot.lo[k];
+    sys.spot.mid[k] = 1.0 - c * ops.spot.mid[k];
+    sys.spot.up[k] = -c * ops.spot.up[k];
+    sys.variance.lo[k] = -c * ops.variance.lo[k];
+    sys.variance.mid[k] = 1.0 - c * ops.variance.mid[k];
+    sys.variance.up[k] = -c * ops.variance.up[k];
+  }
+  return sys;
+}
+
+// Scratch buffers reused across all steps.
+struct Workspace {
+  std::vector<double> a0, a1, a2, y0, y, b0, b1, b2;
+  std::vector<double> lineLo, lineMid, lineUp, lineRhs, lineScratch;
+};
+
+// Solves (I - c A) X = rhs along every line of one direction, in place.
+void solveLines(const LineOperator &sys, const Layout &l, bool spotDirection,
+                std::vector<double> &rhs, Workspace &w) {
+  const std::size_t lines = spotDirection ? l.nV : l.nS;
+  const std::size_t length = spotDirection ? l.nS : l.nV;
+  const std::size_t stride = spotDirection ? 1 : l.nS;
+  w.lineLo.resize(length);
+  w.lineMid.resize(length);
+  w.lineUp.resize(length);
+  w.lineRhs.resize(length);
+  w.lineScratch.resize(length);
+  for (std::size_t line = 0; line < lines; ++line) {
+    const std::size_t first = spotDirection ? l.at(0, line) : l.at(line, 0);
+    for (std::size_t p = 0; p < length; ++p) {
+      const std::size_t k = first + p * stride;
+      w.lineLo[p] = sys.lo[k];
+      w.lineMid[p] = sys.mid[k];
+      w.lineUp[p] = sys.up[k];
+      w.lineRhs[p] = rhs[k];
+    }
+    solveTridiagonal(w.lineLo, w.lineMid, w.lineUp, w.lineRhs, w.lineScratch);
+    for (std::size_t p = 0; p < length; ++p) {
+      rhs[first + p * stride] = w.lineRhs[p];
+    }
+  }
+}
+
+// One ADI step of size k. Douglas when corrector is false (damping),
+// Hundsdorfer-Verwer otherwise.
+void adiStep(const Operators &ops, const ImplicitSystems &sys, double k,
+             bool corrector, std::vector<double> &u, Workspace &w) {
+  const std::size_t n = u.size();
+  const double c = sys.c;
+  applyMixed(ops, u, w.a0);
+  applySpot(ops, u, w.a1);
+  applyVariance(ops, u, w.a2);
+
+  for (std::size_t p = 0; p < n; ++p) {
+    w.y0[p] = u[p] + k * (w.a0[p] + w.a1[p] + w.a2[p]);
+    w.y[p] = w.y0[p] - c * w.a1[p];
+  }
+  solveLines(sys.spot, ops.layout, true, w.y, w);
+  for (std::size_t p = 0; p < n; ++p) {
+    w.y[p] -= c * w.a2[p];
+  }
+  solveLines(sys.variance, ops.layout, false, w.y, w);
+  if (!corrector) {
+    u.swap(w.y);
+    return;
+  }
+
+  applyMixed(ops, w.y, w.b0);
+  applySpot(ops, w.y, w.b1);
+  applyVariance(ops, w.y, w.b2);
+  for (std::size_t p = 0; p < n; ++p) {
+    const double delta = (w.b0[p] + w.b1[p] + w.b2[p]) -
+                         (w.a0[p] + w.a1[p] + w.a2[p]);
+    u[p] = w.y0[p] + 0.5 * k * delta - c * w.b1[p];
+  }
+  solveLines(sys.spot, ops.layout, true, u, w);
+  for (std::size_t p = 0; p < n; ++p) {
+    u[p] -= c * w.b2[p];
+  }
+  solveLines(sys.variance, ops.layout, false, u, w);
+}
+} // namespace
+
+HestonPde::HestonPde(double v0, double kappa, double theta, double xi,
+                     double rho, HestonPdeSettings settings)
+    : v0_(v0), kappa_(kappa), theta_(theta), xi_(xi), rho_(rho),
+      settings_(settings) {}
+
+HestonPde::Result HestonPde::price(const AutocallBase &product, double spot,
+                                   double rate) const {
+  const auto &obs = product.observationTimes();
+  const std::size_t dates = obs.size();
+  if (dates == 0) {
+    throw std::runtime_error("PDE: product has no observation dates");
+  }
+  const double maturity = std::max(obs.back(), 1e-8);
+
+  std::vector<AutocallBase::ObservationRule> rules;
+  rules.reserve(dates);
+  bool memory = false;
+  // Nodes cluster at the spot, at the kinks and jumps of the redemption
+  // (protection barrier, airbag floor, term-sheet strikes) and at the
+  // observation barriers.
+  std::vector<double> critical{spot};
+  double highest = spot;
+  for (double breakpoint : product.redemptionBreakpoints()) {
+    if (std::isfinite(breakpoint) && breakpoint > 0.0) {
+      critical.push_back(breakpoint);
+      highest = std::max(highest, breakpoint);
+    }
+  }
+  for (std::size_t i = 0; i < dates; ++i) {
+    rules.push_back(product.observationRule(i));
+    const auto &rule = rules.back();
+    memory = memory || rule.memory;
+    for (double barrier : {rule.callBarrier, rule.couponBarrier}) {
+      if (std::isfinite(barrier)) {
+        critical.push_back(barrier);
+        highest = std::max(highest, barrier);
+      }
+    }
+  }
+
+  const double volScale = std::sqrt(std::max({v0_, theta_, 1e-4}));
+  const double spread = std::max(5.0 * volScale * std::sqrt(maturity), 0.7);
+  const std::vector<double> sGrid =
+      makeConcentratedGrid(0.0, highest * std::exp(spread),
+                           settings_.spotNodes, critical, 0.05 * spot);
+  const double vMax = std::max(1.0, 5.0 * std::max(v0_, theta_));
+  const std::vector<double> vGrid = makeConcentratedGrid(
+      0.0, vMax, settings_.varianceNodes, {v0_}, 0.05 * vMax, 8.0);
+  const Operators ops =
+      makeOperators(sGrid, vGrid, kappa_, theta_, xi_, rho_, rate);
+  const Layout &layout = ops.layout;
+  const std::size_t n = layout.size();
+
+  const std::size_t layerCount = memory ? dates : 1;
+  std::vector<std::vector<double>> layers(layerCount, std::vector<double>(n));
+  std::vector<std::vector<double>> jumped = layers;
+  Workspace w;
+  for (auto *buffer : {&w.a0, &w.a1, &w.a2, &w.y0, &w.y, &w.b0, &w.b1, &w.b2}) {
+    buffer->resize(n);
+  }
+
+  const double hvTheta = 0.5 + std::sqrt(3.0) / 6.0;
+  for (std::size_t step = dates; step-- > 0;) {
+    const auto &rule = rules[step];
+    const bool last = step + 1 == dates;
+    const std::size_t states = memory ? step + 1 : 1;
+
+    // Jump condition: depends on the spot only, applied on every variance.
+    for (std::size_t m = 0; m < states; ++m) {
+      const double due =
+          rule.couponAmount * (rule.memory ? static_cast<double>(m + 1) : 1.0);
+      for (std::size_t i = 0; i < layout.nS; ++i) {
+        const double s = sGrid[i];
+        const bool couponPaid = s >= rule.couponBarrier;
+        const double coupon = couponPaid ? due : 0.0;
+        const bool called = s >= rule.callBarrier;
+        const double fixed = called ? coupon + rule.callAmount
+                             : last ? coupon + product.terminalRedemption(s)
+                                    : 0.0;
+        for (std::size_t j = 0; j < layout.nV; ++j) {
+          const std::size_t k = layout.at(i, j);
+          if (called || last) {
+            jumped[m][k] = fixed;
+          } else if (rule.memory && !couponPaid) {
+            jumped[m][k] = layers[m + 1][k];
+          } else {
+            jumped[m][k] = coupon + layers[0][k];
+          }
+        }
+      }
+    }
+    layers.swap(jumped);
+
+    const double start = step == 0 ? 0.0 : obs[step - 1];
+    const double period = obs[step] - start;
+    if (period <= 1e-12) {
+      continue;
+    }
+    const std::size_t steps = std::max(
+        settings_.minStepsPerPeriod,
+        static_cast<std::size_t>(std::ceil(
+            period * static_cast<double>(settings_.stepsPerYear))));
+    const double k = period / static_cast<double>(steps);
+    const std::size_t damping = std::min(settings_.dampingSteps, steps);
+    const ImplicitSystems douglas = makeSystems(ops, 0.5 * k);
+    const ImplicitSystems hv = makeSystems(ops, hvTheta * k);
+    for (std::size_t m = 0; m < states; ++m) {
+      for (std::size_t s = 0; s < damping; ++s) {
+        adiStep(ops, douglas, 0.5 * k, false, layers[m], w);
+        adiStep(ops, douglas, 0.5 * k, false, layers[m], w);
+      }
+      for (std::size_t s = damping; s < steps; ++s) {
+        adiStep(ops, hv, k, true, layers[m], w);
+      }
+    }
+  }
+
+  // Interpolate in variance at v0 for every spot node, then in spot.
+  std::vector<double> column(layout.nV);
+  std::vector<double> atV0(layout.nS);
+  std::vector<double> dV0(layout.nS);
+  for (std::size_t i = 0; i < layout.nS; ++i) {
+    for (std::size_t j = 0; j < layout.nV; ++j) {
+      column[j] = layers[0][layout.at(i, j)];
+    }
+    double second = 0.0;
+    interpolateQuadratic(vGrid, column.data(), v0_, atV0[i], dV0[i], second);
+  }
+
+  Result result;
+  interpolateQuadratic(sGrid, atV0.data(), spot, result.price, result.delta,
+                       result.gamma);
+  double ignore = 0.0;
+  interpolateQuadratic(sGrid, dV0.data(), spot, result.vega, ignore, ignore);
+  return result;
+}
@@ -0,0 +1,162 @@
+#include "IncrementalBook.hpp"
+
+#include "KahanSum.hpp"
+#include "Parallel.hpp"
+#include "PathModel.hpp"
+#include "StructuredProduct.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+// Same relative spot bump as priceAutocall. revalue takes a forward
+// difference (one bumped payoff per path, not two), so its delta differs from
+// the central one of priceAutocall by about gamma * bump / 2.
+constexpr double kSpotBumpFraction = 0.005;
+} // namespace
+
+IncrementalBook::Group &IncrementalBook::groupFor(const PricingInputs &inputs) {
+  for (auto &group : groups_) {
+    if (sharesPaths(group.key, inputs)) {
+      return group;
+    }
+  }
+  auto model = makePathModel(inputs);
+  Group group;
+  group.key = inputs;
+  group.underlyingId = internSymbol(inputs.underlying);
+  group.cache = std::make_shared<PathCache>(
+      *model, inputs.observationTimes, inputs.spot, makeDiscountCurve(inputs),
+      inputs.paths, inputs.seed);
+  groups_.push_back(std::move(group));
+  return groups_.back();
+}
+
+std::size_t IncrementalBook::addTrade(const PricingInputs &inputs) {
+  return addTrades({inputs});
+}
+
+std::size_t
+IncrementalBook::addTrades(const std::vector<PricingInputs> &requested) {
+  // revalue() replays Monte Carlo paths, so the full pricing runs Monte Carlo
+  // too (Auto would price Black-Scholes trades by quadrature or in closed
+  // form, and the two prices would disagree by the Monte Carlo error).
+  std::vector<PricingInputs> trades = requested;
+  for (PricingInputs &inputs : trades) {
+    inputs.engineType = EngineType::MonteCarlo;
+  }
+  std::vector<std::unique_ptr<StructuredProduct>> products;
+  for (const PricingInputs &inputs : trades) {
+    if (!inputs.basket.empty()) {
+      throw std::runtime_error(
+          "IncrementalBook: worst-of trades are not cached");
+    }
+    if (inputs.issuerCallable) {
+      throw std::runtime_error(
+          "IncrementalBook: issuer-callable trades are not cached");
+    }
+    auto product = makeProduct(inputs);
+    if (!product) {
+      throw std::runtime_error("IncrementalBook: unsupported product");
+    }
+    if (product->needsBridge()) {
+      // Cached shapes do not keep the interval variances.
+      throw std::runtime_error(
+          "IncrementalBook: knock-in monitored trades are not cached");
+    }
+    products.push_back(std::move(product));
+  }
+  const std::vector<PricingResults> full = priceAutocallPortfolio(trades);
+
+  const std::size_t first = trades_.size();
+  for (std::size_t k = 0; k < trades.size(); ++k) {
+    Group &group = groupFor(trades[k]);
+    group.trades.push_back(trades_.size());
+    trades_.push_back(
+        Trade{trades[k], std::move(products[k]), full[k].vega});
+  }
+  return first;
+}
+
+std::vector<PricingResults>
+IncrementalBook::revalue(const MarketData &market) const {
+  std::vector<PricingResults> results(trades_.size());
+  const DiscountCurve &curve = market.discountCurve();
+
+  for (const auto &group : groups_) {
+    const PathCache &cache = *group.cache;
+    const double spot = market.getQuote(group.underlyingId).spot;
+    const double spotBump = spot * kSpotBumpFraction;
+    const std::size_t count = group.trades.size();
+
+    if (cache.times().empty() || cache.pathCount() == 0) {
+      // Nothing to rescale: the payoff is evaluated on the spot itself.
+      for (std::size_t k : group.trades) {
+        const Trade &trade = trades_[k];
+        double ignore = 0.0;
+        const double price = cache.price(*trade.product, spot, curve, ignore);
+        const double spread =
+            trade.inputs.notional * trade.inputs.spreadFraction;
+        results[k] = {price, 0.0, 0.0, trade.vega, price - spread,
+                      price + spread};
+      }
+      continue;
+    }
+
+    const std::vector<double> scales = cache.dateScales(spot, curve);
+    const std::vector<double> bumpedScales =
+        cache.dateScales(spot + spotBump, curve);
+    const TimeGrid grid(cache.times(), curve);
+    const double *discountFactors = grid.discountFactors.data();
+
+    // Per block, per trade: base sums and bumped payoff sum. Blocks are
+    // merged in block order, so results do not depend on the thread count.
+    struct Sums {
+      PayoffSums base;
+      KahanSum bumped;
+    };
+    const std::size_t paths = cache.pathCount();
+    std::vector<Sums> blocks(pathBlockCount(paths) * count);
+    // Path-outer loop: each rescaled path is built once for the whole group.
+    parallelFor(pathBlockCount(paths), [&](std::size_t b) {
+      std::vector<double> path;
+      std::vector<double> bumpedPath;
+      Sums *sums = blocks.data() + b * count;
+      for (std::size_t p = b * kPathsPerBlock; p < pathBlockEnd(b, paths);
+           ++p) {
+        cache.fillPath(p, scales, path);
+        cache.fillPath(p, bumpedScales, bumpedPath);
+        for (std::size_t j = 0; j < count; ++j) {
+          const StructuredProduct &product =
+              *trades_[group.trades[j]].product;
+          sums[j].base.add(product.discountedPayoff(path, discountFactors));
+          sums[j].bumped.add(
+              product.discountedPayoff(bumpedPath, discountFactors));
+        }
+      }
+    });
+
+    const double n = static_cast<double>(paths);
+    for (std::size_t j = 0; j < count; ++j) {
+      Sums total;
+      for (std::size_t at = j; at < blocks.size(); at += count) {
+        total.base.merge(blocks[at].base);
+        total.bumped.add(blocks[at].bumped.sum);
+      }
+      const Trade &trade = trades_[group.trades[j]];
+      const double mean = total.base.mean();
+      const double spread = trade.inputs.notional * trade.inputs.spreadFraction;
+
+      PricingResults &res = results[group.trades[j]];
+      res.price = mean;
+      res.stdError = total.base.stdError();
+      res.delta =
+          spotBump > 0.0 ? (total.bumped.sum / n - mean) / spotBump : 0.0;
+      res.vega = trade.vega;
+      res.bid = mean - spread;
+      res.ask = mean + spread;
+    }
+  }
+  return results;
+}
@@ -0,0 +1,448 @@
+#include "Json.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+// Recursive-descent parser over the input text.
+class JsonParser {
+public:
+  explicit JsonParser(const std::string &text) : text_(text) {}
+
+  JsonValue document() {
+    JsonValue value = parseValue(0);
+    skipWhitespace();
+    if (pos_ != text_.size()) {
+      fail("trailing characters");
+    }
+    return value;
+  }
+
+private:
+  // Deep enough for any term sheet, shallow enough for the call stack.
+  static constexpr int kMaxDepth = 64;
+
+  [[noreturn]] void fail(const std::string &what) const {
+    throw std::runtime_error("Json: " + what + " at offset " +
+                             std::to_string(pos_));
+  }
+
+  void skipWhitespace() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  bool consume(char c) {
+    skipWhitespace();
+    if (pos_ < text_.size() && text_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c)) {
+      fail(std::string("expected '") + c + "'");
+    }
+  }
+
+  void expectWord(const char *word) {
+    for (const char *c = word; *c; ++c, ++pos_) {
+      if (pos_ >= text_.size() || text_[pos_] != *c) {
+        fail("invalid literal");
+      }
+    }
+  }
+
+  JsonValue parseValue(int depth) {
+    if (depth > kMaxDepth) {
+      fail("nesting too deep");
+    }
+    skipWhitespace();
+    if (pos_ >= text_.size()) {
+      fail("unexpected end of input");
+    }
+    JsonValue value;
+    const char c = text_[pos_];
+    if (c == '{') {
+      ++pos_;
+      value.type_ = JsonValue::Type::Object;
+      if (consume('}')) {
+        return value;
+      }
+      do {
+        skipWhitespace();
+        if (pos_ >= text_.size() || text_[pos_] != '"') {
+          fail("expected a member name");
+        }
+        std::string key = parseString();
+        expect(':');
+        value.object_.emplace_back(std::move(key), parseValue(depth + 1));
+      } while (consume(','));
+      expect('}');
+    } else if (c == '[') {
+      ++pos_;
+      value.type_ = JsonValue::Type::Array;
+      if (consume(']')) {
+        return value;
+      }
+      do {
+        value.array_.push_back(parseValue(depth + 1));
+      } while (consume(','));
+      expect(']');
+    } else if (c == '"') {
+      value.type_ = JsonValue::Type::String;
+      value.string_ = parseString();
+    } else if (c == 't') {
+      expectWord("true");
+      value.type_ = JsonValue::Type::Bool;
+      value.bool_ = true;
+    } else if (c == 'f') {
+      expectWord("false");
+      value.type_ = JsonValue::Type::Bool;
+    } else if (c == 'n') {
+      expectWord("null");
+    } else {
+      value.type_ = JsonValue::Type::Number;
+      value.number_ = parseNumber();
+    }
+    return value;
+  }
+
+  double parseNumber() {
+    // Validate the JSON number grammar, then convert with strtod.
+    const std::size_t start = pos_;
+    auto digits = [&] {
+      const std::size_t first = pos_;
+      while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+        ++pos_;
+      }
+      return pos_ > first;
+    };
+    if (pos_ < text_.size() && text_[pos_] == '-') {
+      ++pos_;
+    }
+    const std::size_t integer = pos_;
+    if (!digits() || (text_[integer] == '0' && pos_ - integer > 1)) {
+      fail("invalid number");
+    }
+    if (pos_ < text_.size() && text_[pos_] == '.') {
+      ++pos_;
+      if (!digits()) {
+        fail("invalid number");
+      }
+    }
+    if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+      ++pos_;
+      if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+        ++pos_;
+      }
+      if (!digits()) {
+        fail("invalid number");
+      }
+    }
+    const double number =
+        std::strtod(text_.substr(start, pos_ - start).c_str(), nullptr);
+    if (!std::isfinite(number)) {
+      fail("number out of range");
+    }
+    return number;
+  }
+
+  unsigned hexQuad() {
+    if (pos_ + 4 > text_.size()) {
+      fail("truncated escape");
+    }
+    unsigned code = 0;
+    for (int k = 0; k < 4; ++k) {
+      const char h = text_[pos_++];
+      code <<= 4;
+      if (h >= '0' && h <= '9') {
+        code |= static_cast<unsigned>(h - '0');
+      } else if (h >= 'a' && h <= 'f') {
+        code |= static_cast<unsigned>(h - 'a' + 10);
+      } else if (h >= 'A' && h <= 'F') {
+        code |= static_cast<unsigned>(h - 'A' + 10);
+      } else {
+        fail("invalid escape");
+      }
+    }
+    return code;
+  }
+
+  void appendUtf8(std::string &out, unsigned code) {
+    if (code < 0x80) {
+      out += static_cast<char>(code);
+    } else if (code < 0x800) {
+      out += static_cast<char>(0xC0 | (code >> 6));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      out += static_cast<char>(0xE0 | (code >> 12));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (code >> 18));
+      out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+  }
+
+  std::string parseString() {
+    ++pos_; // Opening quote.
+    std::string out;
+    while (true) {
+      if (pos_ >= text_.size()) {
+        fail("unterminated string");
+      }
+      const char c = text_[pos_++];
+      if (c == '"') {
+        return out;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        fail("control character in string");
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        fail("truncated escape");
+      }
+      const char e = text_[pos_++];
+      switch (e) {
+      case '"':
+      case '\\':
+      case '/':
+        out += e;
+        break;
+      case 'b':
+        out += '\b';
+        break;
+      case 'f':
+        out += '\f';
+        break;
+      case 'n':
+        out += '\n';
+        break;
+      case 'r':
+        out += '\r';
+        break;
+      case 't':
+        out += '\t';
+        break;
+      case 'u': {
+        unsigned code = hexQuad();
+        if (code >= 0xDC00 && code < 0xE000) {
+          fail("lone surrogate");
+        }
+        if (code >= 0xD800 && code < 0xDC00) {
+          // A high surrogate must be followed by an escaped low one.
+          if (pos_ + 1 >= text_.size() || text_[pos_] != '\\' ||
+              text_[pos_ + 1] != 'u') {
+            fail("lone surrogate");
+          }
+          pos_ += 2;
+          const unsigned low = hexQuad();
+          if (low < 0xDC00 || low >= 0xE000) {
+            fail("lone surrogate");
+          }
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(out, code);
+        break;
+      }
+      default:
+        fail("invalid escape");
+      }
+    }
+  }
+
+  const std::string &text_;
+  std::size_t pos_{0};
+};
+
+JsonValue JsonValue::parse(const std::string &text) {
+  return JsonParser(text).document();
+}
+
+bool JsonValue::asBool() const {
+  if (type_ != Type::Bool) {
+    throw std::runtime_error("Json: expected a boolean");
+  }
+  return bool_;
+}
+
+double JsonValue::asNumber() const {
+  if (type_ != Type::Number) {
+    throw std::runtime_error("Json: expected a number");
+  }
+  return number_;
+}
+
+const std::string &JsonValue::asString() const {
+  if (type_ != Type::String) {
+    throw std::runtime_error("Json: expected a string");
+  }
+  return string_;
+}
+
+const std::vector<JsonValue> &JsonValue::asArray() const {
+  if (type_ != Type::Array) {
+    throw std::runtime_error("Json: expected an array");
+  }
+  return array_;
+}
+
+const std::vector<JsonValue::Member> &JsonValue::asObject() const {
+  if (type_ != Type::Object) {
+    throw std::runtime_error("Json: expected an object");
+  }
+  return object_;
+}
+
+const JsonValue *JsonValue::find(const std::string &key) const {
+  if (type_ != Type::Object) {
+    return nullptr;
+  }
+  for (const auto &member : object_) {
+    if (member.first == key) {
+      return &member.second;
+    }
+  }
+  return nullptr;
+}
+
+JsonValue JsonValue::boolean(bool value) {
+  JsonValue out;
+  out.type_ = Type::Bool;
+  out.bool_ = value;
+  return out;
+}
+
+JsonValue JsonValue::number(double value) {
+  JsonValue out;
+  out.type_ = Type::Number;
+  out.number_ = value;
+  return out;
+}
+
+JsonValue JsonValue::string(std::string value) {
+  JsonValue out;
+  out.type_ = Type::String;
+  out.string_ = std::move(value);
+  return out;
+}
+
+JsonValue JsonValue::array(std::vector<JsonValue> items) {
+  JsonValue out;
+  out.type_ = Type::Array;
+  out.array_ = std::move(items);
+  return out;
+}
+
+JsonValue JsonValue::object(std::vector<Member> members) {
+  JsonValue out;
+  out.type_ = Type::Object;
+  out.object_ = std::move(members);
+  return out;
+}
+
+namespace {
+void dumpString(const std::string &text, std::string &out) {
+  out += '"';
+  for (const char c : text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escape[8];
+        std::snprintf(escape, sizeof escape, "\\u%04x",
+                      static_cast<unsigned>(c));
+        out += escape;
+      } else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
+
+void dumpValue(const JsonValue &value, std::string &out) {
+  switch (value.type()) {
+  case JsonValue::Type::Null:
+    out += "null";
+    break;
+  case JsonValue::Type::Bool:
+    out += value.asBool() ? "true" : "false";
+    break;
+  case JsonValue::Type::Number: {
+    const double x = value.asNumber();
+    if (!std::isfinite(x)) {
+      out += "null";
+      break;
+    }
+    char digits[32];
+    std::snprintf(digits, sizeof digits, "%.17g", x);
+    out += digits;
+    break;
+  }
+  case JsonValue::Type::String:
+    dumpString(value.asString(), out);
+    break;
+  case JsonValue::Type::Array: {
+    out += '[';
+    bool first = true;
+    for (const auto &item : value.asArray()) {
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      dumpValue(item, out);
+    }
+    out += ']';
+    break;
+  }
+  case JsonValue::Type::Object: {
+    out += '{';
+    bool first = true;
+    for (const auto &member : value.asObject()) {
+      if (!first) {
+        out += ',';
+      }
+      first = false;
+      dumpString(member.first, out);
+      out += ':';
+      dumpValue(member.second, out);
+    }
+    out += '}';
+    break;
+  }
+  }
+}
+} // namespace
+
+std::string JsonValue::dump() const {
+  std::string out;
+  dumpValue(*this, out);
+  return out;
+}
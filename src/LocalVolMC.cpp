@@ -0,0 +1,245 @@
+#include "LocalVolMC.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// Local variance is clamped to [1%^2, 200%^2]: the Dupire ratio blows up
+// where the surface is sparse or slightly arbitrageable.
+constexpr double kMinLocalVariance = 1e-4;
+constexpr double kMaxLocalVariance = 4.0;
+constexpr double kMinDenominator = 1e-4;
+// Shortest maturity at which the surface is differentiated (t -> 0 limit).
+constexpr double kMinTime = 1e-4;
+
+void checkIncreasing(const std::vector<double> &values, const char *what) {
+  for (std::size_t k = 1; k < values.size(); ++k) {
+    if (values[k] <= values[k - 1]) {
+      throw std::runtime_error(std::string("LocalVol: ") + what +
+                               " must be strictly increasing");
+    }
+  }
+}
+
+// Dupire local variance from total implied variance w(y, T), y = log(K/F).
+double dupireVariance(const ImpliedVolSurface &surface, double y, double t) {
+  const double h = std::min(kMinTime, 0.5 * t);
+  const double wUp = surface.totalVariance(y, t + h);
+  const double wDown = surface.totalVariance(y, t - h);
+  const double dwdt = (wUp - wDown) / (2.0 * h);
+
+  double dy = 0.0;
+  double dyy = 0.0;
+  const double w = surface.totalVariance(y, t, &dy, &dyy);
+  if (w <= 0.0) {
+    return kMinLocalVariance;
+  }
+  const double den = 1.0 - y / w * dy +
+                     0.25 * (-0.25 - 1.0 / w + y * y / (w * w)) * dy * dy +
+                     0.5 * dyy;
+  const double variance = dwdt / std::max(den, kMinDenominator);
+  return std::clamp(variance, kMinLocalVariance, kMaxLocalVariance);
+}
+} // namespace
+
+ImpliedVolSurface::ImpliedVolSurface(std::vector<double> expiries,
+                                     std::vector<double> moneyness,
+                                     std::vector<double> vols)
+    : expiries_(std::move(expiries)), vols_(std::move(vols)) {
+  if (expiries_.empty() || moneyness.empty() ||
+      vols_.size() != expiries_.size() * moneyness.size()) {
+    throw std::runtime_error("LocalVol: surface needs one vol per node");
+  }
+  if (expiries_.front() <= 0.0) {
+    throw std::runtime_error("LocalVol: expiries must be positive");
+  }
+  checkIncreasing(expiries_, "expiries");
+  checkIncreasing(moneyness, "moneyness");
+  for (double m : moneyness) {
+    if (m <= 0.0) {
+      throw std::runtime_error("LocalVol: moneyness must be positive");
+    }
+    logMoneyness_.push_back(std::log(m));
+  }
+
+  const std::size_t n = logMoneyness_.size();
+  variances_.resize(vols_.size());
+  secondDerivs_.assign(vols_.size(), 0.0);
+  for (std::size_t j = 0; j < expiries_.size(); ++j) {
+    for (std::size_t i = 0; i < n; ++i) {
+      const double vol = vols_[j * n + i];
+      if (vol <= 0.0) {
+        throw std::runtime_error("LocalVol: implied vols must be positive");
+      }
+      variances_[j * n + i] = vol * vol * expiries_[j];
+    }
+    if (n < 3) {
+      continue; // Linear (or constant): zero second derivatives.
+    }
+    // Natural cubic spline: tridiagonal system for the second derivatives.
+    const double *w = variances_.data() + j * n;
+    const std::vector<double> &y = logMoneyness_;
+    std::vector<double> diag(n, 1.0), upper(n, 0.0), rhs(n, 0.0);
+    std::vector<double> lower(n, 0.0);
+    for (std::size_t i = 1; i + 1 < n; ++i) {
+      const double h0 = y[i] - y[i - 1];
+      const double h1 = y[i + 1] - y[i];
+      lower[i] = h0;
+      diag[i] = 2.0 * (h0 + h1);
+      upper[i] = h1;
+      rhs[i] = 6.0 * ((w[i + 1] - w[i]) / h1 - (w[i] - w[i - 1]) / h0);
+    }
+    // Thomas algorithm.
+    for (std::size_t i = 1; i < n; ++i) {
+      const double m = lower[i] / diag[i - 1];
+      diag[i] -= m * upper[i - 1];
+      rhs[i] -= m * rhs[i - 1];
+    }
+    double *second = secondDerivs_.data() + j * n;
+    second[n - 1] = rhs[n - 1] / diag[n - 1];
+    for (std::size_t i = n - 1; i-- > 0;) {
+      second[i] = (rhs[i] - upper[i] * second[i + 1]) / diag[i];
+    }
+  }
+}
+
+ImpliedVolSurface ImpliedVolSurface::flat(double sigma) {
+  return ImpliedVolSurface({1.0}, {1.0}, {sigma});
+}
+
+double ImpliedVolSurface::maxVol() const {
+  return *std::max_element(vols_.begin(), vols_.end());
+}
+
+ImpliedVolSurface ImpliedVolSurface::shifted(double volShift) const {
+  std::vector<double> moneyness;
+  for (double y : logMoneyness_) {
+    moneyness.push_back(std::exp(y));
+  }
+  std::vector<double> vols = vols_;
+  for (double &vol : vols) {
+    vol += volShift;
+  }
+  return ImpliedVolSurface(expiries_, std::move(moneyness), std::move(vols));
+}
+
+double ImpliedVolSurface::expiryVariance(std::size_t j, double y, double *dy,
+                                         double *dyy) const {
+  const std::size_t n = logMoneyness_.size();
+  const double *w = variances_.data() + j * n;
+  const double *second = secondDerivs_.data() + j * n;
+  const std::vector<double> &ys = logMoneyness_;
+
+  if (n == 1 || y <= ys.front() || y >= ys.back()) {
+    // Flat extrapolation of the smile.
+    if (dy) *dy = 0.0;
+    if (dyy) *dyy = 0.0;
+    return n == 1 || y <= ys.front() ? w[0] : w[n - 1];
+  }
+  const std::size_t i = static_cast<std::size_t>(
+      std::upper_bound(ys.begin(), ys.end(), y) - ys.begin() - 1);
+  const double h = ys[i + 1] - ys[i];
+  const double a = (ys[i + 1] - y) / h;
+  const double b = 1.0 - a;
+  if (dy) {
+    *dy = (w[i + 1] - w[i]) / h - (3.0 * a * a - 1.0) / 6.0 * h * second[i] +
+          (3.0 * b * b - 1.0) / 6.0 * h * second[i + 1];
+  }
+  if (dyy) {
+    *dyy = a * second[i] + b * second[i + 1];
+  }
+  return a * w[i] + b * w[i + 1] +
+         ((a * a * a - a) * second[i] + (b * b * b - b) * second[i + 1]) * h *
+             h / 6.0;
+}
+
+double ImpliedVolSurface::totalVariance(double y, double t, double *dy,
+                                        double *dyy) const {
+  const std::size_t last = expiries_.size() - 1;
+  if (t <= expiries_.front() || t >= expiries_[last]) {
+    // Constant implied vol outside the quoted expiries.
+    const std::size_t j = t <= expiries_.front() ? 0 : last;
+    const double scale = t / expiries_[j];
+    const double w = expiryVariance(j, y, dy, dyy);
+    if (dy) *dy *= scale;
+    if (dyy) *dyy *= scale;
+    return w * scale;
+  }
+  const std::size_t j = static_cast<std::size_t>(
+      std::upper_bound(expiries_.begin(), expiries_.end(), t) -
+      expiries_.begin() - 1);
+  const double weight = (t - expiries_[j]) / (expiries_[j + 1] - expiries_[j]);
+  double dy0 = 0.0, dyy0 = 0.0, dy1 = 0.0, dyy1 = 0.0;
+  const double w0 = expiryVariance(j, y, &dy0, &dyy0);
+  const double w1 = expiryVariance(j + 1, y, &dy1, &dyy1);
+  if (dy) *dy = dy0 + weight * (dy1 - dy0);
+  if (dyy) *dyy = dyy0 + weight * (dyy1 - dyy0);
+  return w0 + weight * (w1 - w0);
+}
+
+LocalVolTable::LocalVolTable(const ImpliedVolSurface &surface,
+                             const LocalVolSettings &settings) {
+  const double horizon = surface.lastExpiry();
+  const std::size_t rows = std::max<std::size_t>(
+      2, static_cast<std::size_t>(
+             std::ceil(horizon * settings.tableStepsPerYear)) + 1);
+  const std::size_t cols = std::max<std::size_t>(3, settings.logSpotNodes);
+  const double xHalf =
+      std::max(4.0 * surface.maxVol() * std::sqrt(horizon), 0.5);
+  table_ = UniformTable(horizon, rows, -xHalf, xHalf, cols);
+
+  for (std::size_t r = 0; r < rows; ++r) {
+    // Row 0 stands for the t -> 0 limit of the Dupire ratio.
+    const double t = std::max(table_.rowTime(r), kMinTime);
+    for (std::size_t c = 0; c < cols; ++c) {
+      table_.at(r, c) = std::sqrt(dupireVariance(surface, table_.colX(c), t));
+    }
+  }
+}
+
+LocalVolMC::LocalVolMC(const ImpliedVolSurface &surface,
+                       LocalVolSettings settings)
+    : settings_(settings), table_(surface, settings) {}
+
+std::size_t LocalVolMC::normalCount(const TimeGrid &grid) const {
+  std::size_t count = 0;
+  for (double dt : grid.dt) {
+    count += subStepCount(dt, settings_.stepsPerYear);
+  }
+  return count;
+}
+
+void LocalVolMC::buildPath(double spot0, const TimeGrid &grid,
+                           const double *normals, std::vector<double> &path,
+                           double *intervalVariance) const {
+  const std::size_t n = grid.times.size();
+  path.resize(n);
+
+  double x = 0.0;          // log(S_t / F(t))
+  double logForward = 0.0; // log(F(t) / S_0)
+  double t = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const double dt = grid.dt[i];
+    const std::size_t steps = subStepCount(dt, settings_.stepsPerYear);
+    double integratedVariance = 0.0;
+    if (steps > 0) {
+      const double h = dt / static_cast<double>(steps);
+      const double sqrtH = std::sqrt(h);
+      for (std::size_t s = 0; s < steps; ++s) {
+        const double sigma = table_.volatility(t, x);
+        x += -0.5 * sigma * sigma * h + sigma * sqrtH * *normals++;
+        integratedVariance += sigma * sigma * h;
+        t += h;
+      }
+    }
+    if (intervalVariance) {
+      intervalVariance[i] = integratedVariance;
+    }
+    t = grid.times[i]; // Sub-steps end exactly on the observation date.
+    logForward += grid.logGrowth[i];
+    path[i] = spot0 * std::exp(logForward + x);
+  }
+}
@@ -0,0 +1,406 @@
+#include "LongstaffSchwartz.hpp"
+
+#include "AutocallBase.hpp"
+#include "CliquetBase.hpp"
+#include "KahanSum.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+
+// Contractual terms of the product, replayed date by date with the state
+// the regression needs.
+class LongstaffSchwartz::Terms {
+public:
+  struct Observation {
+    double paid{};      // Contractual flow at the date (undiscounted).
+    double state{};     // Carried to the next date; regression variable y.
+    bool redeemed{};    // Autocall or maturity: no later flow.
+  };
+
+  virtual ~Terms() = default;
+
+  // Whether the state varies (otherwise y is left out of the basis).
+  virtual bool hasState() const = 0;
+
+  // Flows at date i given the state carried from date i - 1 (0 at i = 0).
+  virtual Observation observe(PathView path, std::size_t i,
+                              double carried) const = 0;
+
+  // Amount paid by the issuer to call at date i (undiscounted).
+  virtual double callAmount(std::size_t i, double state) const = 0;
+};
+
+namespace {
+// Paths per regression batch: the partial normal equations of a batch are
+// summed in batch order, whatever the number of threads.
+constexpr std::size_t kRegressionBatch = 4096;
+// Fewer live paths per basis function than this: the date is not called.
+constexpr std::size_t kMinPathsPerBasis = 8;
+constexpr std::size_t kMaxBasis = 6;
+
+// Same flows as the product payoffs, through the ObservationRule used by the
+// grid engines. The state is the number of unpaid memory coupons.
+class AutocallTerms : public LongstaffSchwartz::Terms {
+public:
+  explicit AutocallTerms(const AutocallBase &product) : product_(product) {
+    const std::size_t dates = product.observationTimes().size();
+    for (std::size_t i = 0; i < dates; ++i) {
+      rules_.push_back(product.observationRule(i));
+      memory_ = memory_ || rules_.back().memory;
+    }
+  }
+
+  bool hasState() const override { return memory_; }
+
+  Observation observe(PathView path, std::size_t i,
+                      double carried) const override {
+    const AutocallBase::ObservationRule &rule = rules_[i];
+    const double spot = path[i];
+    const bool couponPaid = spot >= rule.couponBarrier;
+    Observation obs;
+    if (couponPaid) {
+      obs.paid = rule.couponAmount * (rule.memory ? carried + 1.0 : 1.0);
+    }
+    obs.state = rule.memory && !couponPaid ? carried + 1.0 : 0.0;
+    if (spot >= rule.callBarrier) {
+      obs.paid += rule.callAmount;
+      obs.redeemed = true;
+    } else if (i + 1 == rules_.size()) {
+      obs.paid += product_.maturityRedemption(path);
+      obs.redeemed = true;
+    }
+    return obs;
+  }
+
+  double callAmount(std::size_t i, double /*state*/) const override {
+    return rules_[i].callAmount;
+  }
+
+private:
+  const AutocallBase &product_;
+  std::vector<AutocallBase::ObservationRule> rules_;
+  bool memory_{false};
+};
+
+// A cliquet pays its whole payoff at maturity; a call pays the payoff
+// accrued on the dates observed so far, which is also the state.
+class CliquetTerms : public LongstaffSchwartz::Terms {
+public:
+  explicit CliquetTerms(const CliquetBase &product) : product_(product) {}
+
+  bool hasState() const override { return true; }
+
+  Observation observe(PathView path, std::size_t i,
+                      double /*carried*/) const override {
+    Observation obs;
+    obs.state = product_.accruedPayoff(PathView(path.data(), i + 1));
+    if (i + 1 == product_.observationTimes().size()) {
+      obs.paid = obs.state;
+      obs.redeemed = true;
+    }
+    return obs;
+  }
+
+  double callAmount(std::size_t /*i*/, double state) const override {
+    return state;
+  }
+
+private:
+  const CliquetBase &product_;
+};
+
+// Path with the bridge data the product needs (knock-in monitoring).
+PathView simulateView(const PathModelBase &model, bool bridge, double spot,
+                      const TimeGrid &grid, std::mt19937 &rng,
+                      std::vector<double> &path,
+                      std::vector<double> &intervalVariance) {
+  if (!bridge) {
+    path = model.simulatePath(spot, grid, rng);
+    return PathView(path);
+  }
+  path = model.simulatePath(spot, grid, rng, intervalVariance);
+  return PathView(path).withBridge(spot, intervalVariance.data());
+}
+
+std::size_t fillBasis(double x, double y, bool withState, double *out) {
+  out[0] = 1.0;
+  out[1] = x;
+  out[2] = x * x;
+  out[3] = out[2] * x;
+  if (!withState) {
+    return 4;
+  }
+  out[4] = y;
+  out[5] = x * y;
+  return 6;
+}
+
+// Solves the k x k normal equations G beta = b by Cholesky after scaling
+// the columns to a unit diagonal (x^3 and y live on very different scales).
+// Columns that are identically zero get a zero coefficient.
+bool solveNormalEquations(std::vector<double> gram, std::vector<double> rhs,
+                          std::size_t k, double *beta) {
+  std::vector<double> scale(k, 1.0);
+  for (std::size_t i = 0; i < k; ++i) {
+    if (gram[i * k + i] > 0.0) {
+      scale[i] = std::sqrt(gram[i * k + i]);
+    }
+  }
+  for (std::size_t i = 0; i < k; ++i) {
+    for (std::size_t j = 0; j < k; ++j) {
+      gram[i * k + j] /= scale[i] * scale[j];
+    }
+    gram[i * k + i] += 1e-10; // Keeps nearly collinear bases solvable.
+    rhs[i] /= scale[i];
+  }
+
+  for (std::size_t j = 0; j < k; ++j) {
+    double pivot = gram[j * k + j];
+    for (std::size_t m = 0; m < j; ++m) {
+      pivot -= gram[j * k + m] * gram[j * k + m];
+    }
+    if (!(pivot > 0.0)) {
+      return false;
+    }
+    const double diag = std::sqrt(pivot);
+    gram[j * k + j] = diag;
+    for (std::size_t i = j + 1; i < k; ++i) {
+      double value = gram[i * k + j];
+      for (std::size_t m = 0; m < j; ++m) {
+        value -= gram[i * k + m] * gram[j * k + m];
+      }
+      gram[i * k + j] = value / diag;
+    }
+  }
+  for (std::size_t i = 0; i < k; ++i) { // L z = b
+    double value = rhs[i];
+    for (std::size_t m = 0; m < i; ++m) {
+      value -= gram[i * k + m] * rhs[m];
+    }
+    rhs[i] = value / gram[i * k + i];
+  }
+  for (std::size_t i = k; i-- > 0;) { // L^T beta = z
+    double value = rhs[i];
+    for (std::size_t m = i + 1; m < k; ++m) {
+      value -= gram[m * k + i] * rhs[m];
+    }
+    rhs[i] = value / gram[i * k + i];
+  }
+  for (std::size_t i = 0; i < k; ++i) {
+    beta[i] = rhs[i] / scale[i];
+  }
+  return true;
+}
+} // namespace
+
+LongstaffSchwartz::LongstaffSchwartz(const StructuredProduct &product,
+                                     LsmSettings settings)
+    : settings_(settings) {
+  if (product.observationTimes().empty()) {
+    throw std::runtime_error("LSM: product has no observation dates");
+  }
+  if (const auto *autocall = dynamic_cast<const AutocallBase *>(&product)) {
+    terms_ = std::make_unique<AutocallTerms>(*autocall);
+  } else if (const auto *cliquet =
+                 dynamic_cast<const CliquetBase *>(&product)) {
+    terms_ = std::make_unique<CliquetTerms>(*cliquet);
+  } else {
+    throw std::runtime_error("LSM: only single-asset autocalls and cliquets "
+                             "can be issuer-callable");
+  }
+  times_ = product.observationTimes();
+  bridge_ = product.needsBridge();
+  basisSize_ = terms_->hasState() ? 6 : 4;
+}
+
+LongstaffSchwartz::~LongstaffSchwartz() = default;
+
+double LongstaffSchwartz::continuation(std::size_t date, double x,
+                                       double y) const {
+  double basis[kMaxBasis];
+  fillBasis(x, y, basisSize_ == 6, basis);
+  const double *beta = coefficients_.data() + date * basisSize_;
+  double value = 0.0;
+  for (std::size_t k = 0; k < basisSize_; ++k) {
+    value += beta[k] * basis[k];
+  }
+  return value;
+}
+
+void LongstaffSchwartz::fit(const PathModelBase &model, double spot,
+                            const DiscountCurve &curve, unsigned int seed) {
+  const std::size_t dates = times_.size();
+  const std::size_t paths = settings_.regressionPaths;
+  const std::size_t k = basisSize_;
+  if (paths == 0 || spot <= 0.0) {
+    throw std::runtime_error("LSM: regression needs paths and a positive spot");
+  }
+  referenceSpot_ = spot;
+  const TimeGrid grid(times_, curve);
+  const double *discountFactors = grid.discountFactors.data();
+
+  // Date-major SoA buffers: date i of every path is contiguous, which is the
+  // access pattern of the backward induction. flows are discounted to today.
+  std::vector<float> spots(dates * paths);
+  std::vector<float> states(dates * paths);
+  std::vector<float> flows(dates * paths);
+  std::vector<std::uint32_t> redemptionDate(paths);
+
+  parallelFor(pathBlockCount(paths), [&](std::size_t b) {
+    std::mt19937 rng = pathBlockRng(seed, b);
+    std::vector<double> pathBuffer;
+    std::vector<double> varianceBuffer;
+    for (std::size_t p = b * kPathsPerBlock; p < pathBlockEnd(b, paths); ++p) {
+      const PathView path = simulateView(model, bridge_, spot, grid, rng,
+                                         pathBuffer, varianceBuffer);
+      double carried = 0.0;
+      for (std::size_t i = 0; i < dates; ++i) {
+        const Terms::Observation obs = terms_->observe(path, i, carried);
+        spots[i * paths + p] = static_cast<float>(path[i] / spot);
+        states[i * paths + p] = static_cast<float>(obs.state);
+        flows[i * paths + p] = static_cast<float>(obs.paid * discountFactors[i]);
+        carried = obs.state;
+        if (obs.redeemed) {
+          redemptionDate[p] = static_cast<std::uint32_t>(i);
+          break;
+        }
+      }
+    }
+  });
+
+  // value[p]: discounted flows of path p after the current date under the
+  // rule fitted so far.
+  std::vector<double> value(paths, 0.0);
+  coefficients_.assign(dates * k, 0.0);
+  callable_.assign(dates, 0);
+  const std::size_t batches = (paths + kRegressionBatch - 1) / kRegressionBatch;
+  std::vector<double> partialGram(batches * k * k);
+  std::vector<double> partialRhs(batches * k);
+  std::vector<std::size_t> partialLive(batches);
+
+  for (std::size_t i = dates; i-- > 0;) {
+    const float *x = spots.data() + i * paths;
+    const float *y = states.data() + i * paths;
+    const float *flow = flows.data() + i * paths;
+
+    if (i + 1 < dates && i >= settings_.firstCallDate) {
+      std::fill(partialGram.begin(), partialGram.end(), 0.0);
+      std::fill(partialRhs.begin(), partialRhs.end(), 0.0);
+      parallelFor(batches, [&](std::size_t batch) {
+        double *gram = partialGram.data() + batch * k * k;
+        double *rhs = partialRhs.data() + batch * k;
+        std::size_t live = 0;
+        double basis[kMaxBasis];
+        const std::size_t end = std::min(paths, (batch + 1) * kRegressionBatch);
+        for (std::size_t p = batch * kRegressionBatch; p < end; ++p) {
+          if (redemptionDate[p] <= i) {
+            continue;
+          }
+          ++live;
+          fillBasis(x[p], y[p], k == 6, basis);
+          for (std::size_t r = 0; r < k; ++r) {
+            rhs[r] += basis[r] * value[p];
+            for (std::size_t c = 0; c <= r; ++c) {
+              gram[r * k + c] += basis[r] * basis[c];
+            }
+          }
+        }
+        partialLive[batch] = live;
+      });
+
+      std::vector<double> gram(k * k, 0.0);
+      std::vector<double> rhs(k, 0.0);
+      std::size_t live = 0;
+      for (std::size_t batch = 0; batch < batches; ++batch) {
+        live += partialLive[batch];
+        for (std::size_t e = 0; e < k * k; ++e) {
+          gram[e] += partialGram[batch * k * k + e];
+        }
+        for (std::size_t r = 0; r < k; ++r) {
+          rhs[r] += partialRhs[batch * k + r];
+        }
+      }
+      for (std::size_t r = 0; r < k; ++r) {
+        for (std::size_t c = r + 1; c < k; ++c) {
+          gram[r * k + c] = gram[c * k + r];
+        }
+      }
+
+      if (live >= kMinPathsPerBasis * k &&
+          solveNormalEquations(gram, rhs, k, coefficients_.data() + i * k)) {
+        callable_[i] = 1;
+        for (std::size_t p = 0; p < paths; ++p) {
+          if (redemptionDate[p] <= i) {
+            continue;
+          }
+          const double call = terms_->callAmount(i, y[p]) * discountFactors[i];
+          if (continuation(i, x[p], y[p]) > call) {
+            value[p] = call;
+          }
+        }
+      }
+    }
+
+    for (std::size_t p = 0; p < paths; ++p) {
+      if (redemptionDate[p] == i) {
+        value[p] = flow[p];
+      } else if (redemptionDate[p] > i) {
+        value[p] += flow[p];
+      }
+    }
+  }
+}
+
+double LongstaffSchwartz::price(const PathModelBase &model, double spot,
+                                const DiscountCurve &curve, std::size_t paths,
+                                unsigned int seed,
+                                double &standardError) const {
+  if (!fitted()) {
+    throw std::runtime_error("LSM: price() called before fit()");
+  }
+  const std::size_t dates = times_.size();
+  const TimeGrid grid(times_, curve);
+  const double *discountFactors = grid.discountFactors.data();
+
+  std::vector<PayoffSums> blocks(pathBlockCount(paths));
+  parallelFor(blocks.size(), [&](std::size_t b) {
+    std::mt19937 rng = pathBlockRng(seed, b);
+    PayoffSums &sums = blocks[b];
+    std::vector<double> pathBuffer;
+    std::vector<double> varianceBuffer;
+    for (std::size_t p = b * kPathsPerBlock; p < pathBlockEnd(b, paths); ++p) {
+      const PathView path = simulateView(model, bridge_, spot, grid, rng,
+                                         pathBuffer, varianceBuffer);
+      double pathValue = 0.0;
+      double carried = 0.0;
+      for (std::size_t i = 0; i < dates; ++i) {
+        const Terms::Observation obs = terms_->observe(path, i, carried);
+        pathValue += obs.paid * discountFactors[i];
+        if (obs.redeemed) {
+          break;
+        }
+        if (callable_[i]) {
+          const double call =
+              terms_->callAmount(i, obs.state) * discountFactors[i];
+          if (continuation(i, path[i] / referenceSpot_, obs.state) > call) {
+            pathValue += call;
+            break;
+          }
+        }
+        carried = obs.state;
+      }
+      sums.add(pathValue);
+    }
+  });
+
+  PayoffSums total;
+  for (const auto &block : blocks) {
+    total.merge(block);
+  }
+  standardError = total.stdError();
+  return total.mean();
+}
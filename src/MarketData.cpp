@@ -1,22 +1,84 @@
 #include "MarketData.hpp"
+#include <algorithm>
 #include <stdexcept>
 
+namespace {
+// Past this many overridden quotes the overlay is folded into a new
+// snapshot, so lookups never degrade into long linear scans.
+constexpr std::size_t kMaxOverrides = 16;
+} // namespace
+
+MarketSnapshot::MarketSnapshot(const std::vector<std::pair<SymbolId, MarketQuote>>& quotes)
+{
+    auto sorted = quotes;
+    // Stable, so the pairs of one ID keep their order and the last one wins.
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    quotes_.reserve(sorted.size());
+    for (const auto& entry : sorted) {
+        if (!quotes_.empty() && quotes_.back().first == entry.first) {
+            quotes_.back() = entry;
+        } else {
+            quotes_.push_back(entry);
+        }
+    }
+}
+
+const MarketQuote* MarketSnapshot::find(SymbolId id) const {
+    const auto it = std::lower_bound(
+        quotes_.begin(), quotes_.end(), id,
+        [](const std::pair<SymbolId, MarketQuote>& entry, SymbolId key) { return entry.first < key; });
+    return it != quotes_.end() && it->first == id ? &it->second : nullptr;
+}
+
+MarketData::MarketData(std::shared_ptr<const MarketSnapshot> snapshot)
+    : base_(std::move(snapshot)) {}
+
 void MarketData::setRiskFreeRate(double r) {
-    riskFreeRate_ = r;
+    curve_ = std::make_shared<const DiscountCurve>(r);
 }
 
 double MarketData::riskFreeRate() const {
-    return riskFreeRate_;
+    return curve_->zeroRate(0.0);
+}
+
+void MarketData::setDiscountCurve(DiscountCurve curve) {
+    curve_ = std::make_shared<const DiscountCurve>(std::move(curve));
+}
+
+void MarketData::setQuote(SymbolId underlying, const Quote& quote) {
+    for (auto& entry : overrides_) {
+        if (entry.first == underlying) {
+            entry.second = quote;
+            return;
+        }
+    }
+    overrides_.emplace_back(underlying, quote);
+    if (overrides_.size() > kMaxOverrides) {
+        freeze();
+    }
 }
 
-void MarketData::setQuote(const std::string& underlying, const Quote& quote) {
-    quotes_[underlying] = quote;
+MarketData::Quote MarketData::getQuote(SymbolId underlying) const {
+    for (const auto& entry : overrides_) {
+        if (entry.first == underlying) {
+            return entry.second;
+        }
+    }
+    if (base_) {
+        if (const Quote* quote = base_->find(underlying)) {
+            return *quote;
+        }
+    }
+    throw std::runtime_error("MarketData: Underlying not found: " + symbolName(underlying));
 }
 
-const MarketData::Quote& MarketData::getQuote(const std::string& underlying) const {
-    auto it = quotes_.find(underlying);
-    if (it == quotes_.end()) {
-        throw std::runtime_error("MarketData: Underlying not found: " + underlying);
+void MarketData::freeze() {
+    if (overrides_.empty()) {
+        return;
     }
-    return it->second;
-}
\ No newline at end of file
+    auto entries = base_ ? base_->entries() : std::vector<std::pair<SymbolId, Quote>>{};
+    entries.insert(entries.end(), overrides_.begin(), overrides_.end());
+    base_ = std::make_shared<const MarketSnapshot>(entries);
+    overrides_.clear();
+}
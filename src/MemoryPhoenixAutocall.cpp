@@ -9,8 +9,9 @@ MemoryPhoenixAutocall::MemoryPhoenixAutocall(
                    notional, couponRate, callBarrier, protectionBarrier),
       couponBarrier_(couponBarrier) {}
 
-double MemoryPhoenixAutocall::discountedPayoff(const std::vector<double> &path,
-                                               double riskFreeRate) const {
+double MemoryPhoenixAutocall::payoff(PathView path,
+                                     const double *discountFactors,
+                                     LifeEvents *events) const {
   double totalValue = 0.0;
   const auto &obs = times();
   const std::size_t steps = std::min(path.size(), obs.size());
@@ -22,18 +23,32 @@ double MemoryPhoenixAutocall::discountedPayoff(const std::vector<double> &path,
     accruedCoupons += periodicCoupon;
 
     if (path[i] >= couponBarrier_) {
-      totalValue += accruedCoupons * std::exp(-riskFreeRate * obs[i]);
+      totalValue += accruedCoupons * discountFactors[i];
       accruedCoupons = 0.0;
+      if (events) {
+        events->couponPaid(i);
+      }
     }
 
     if (path[i] >= callBarrier()) {
-      totalValue += notional() * std::exp(-riskFreeRate * obs[i]);
+      totalValue += notional() * discountFactors[i];
+      if (events) {
+        events->called(i);
+      }
       return totalValue;
     }
   }
 
-  const double finalSpot = (steps > 0) ? path[steps - 1] : spot0();
+  if (events) {
+    events->matured();
+  }
   totalValue +=
-      terminalRedemption(finalSpot) * std::exp(-riskFreeRate * obs.back());
+      maturityRedemption(path) * discountFactors[obs.size() - 1];
   return totalValue;
-}
\ No newline at end of file
+}
+
+AutocallBase::ObservationRule
+MemoryPhoenixAutocall::observationRule(std::size_t /*i*/) const {
+  return {callBarrier(), notional(), couponBarrier_, notional() * couponRate(),
+          true};
+}
@@ -0,0 +1,152 @@
+#include "MultiAssetModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+std::vector<double> identity(std::size_t n) {
+  std::vector<double> m(n * n, 0.0);
+  for (std::size_t a = 0; a < n; ++a) {
+    m[a * n + a] = 1.0;
+  }
+  return m;
+}
+
+// Fills normals with n independent draws, then correlates them in place:
+// correlated = L * normals (L lower triangular, row-major).
+void drawCorrelated(const std::vector<double> &cholesky, std::size_t n,
+                    std::normal_distribution<double> &dist, std::mt19937 &rng,
+                    double *normals, double *correlated) {
+  for (std::size_t a = 0; a < n; ++a) {
+    normals[a] = dist(rng);
+  }
+  for (std::size_t a = 0; a < n; ++a) {
+    const double *row = cholesky.data() + a * n;
+    double z = 0.0;
+    for (std::size_t b = 0; b <= a; ++b) {
+      z += row[b] * normals[b];
+    }
+    correlated[a] = z;
+  }
+}
+} // namespace
+
+std::vector<double> choleskyFactor(const std::vector<double> &correlation,
+                                   std::size_t n) {
+  if (correlation.empty()) {
+    return identity(n);
+  }
+  if (correlation.size() != n * n) {
+    throw std::runtime_error("Correlation matrix has the wrong size");
+  }
+  std::vector<double> l(n * n, 0.0);
+  for (std::size_t a = 0; a < n; ++a) {
+    for (std::size_t b = 0; b <= a; ++b) {
+      double sum = correlation[a * n + b];
+      for (std::size_t k = 0; k < b; ++k) {
+        sum -= l[a * n + k] * l[b * n + k];
+      }
+      if (a == b) {
+        if (sum <= 0.0) {
+          throw std::runtime_error(
+              "Correlation matrix is not positive definite");
+        }
+        l[a * n + a] = std::sqrt(sum);
+      } else {
+        l[a * n + b] = sum / l[b * n + b];
+      }
+    }
+  }
+  return l;
+}
+
+CorrelatedBlackScholesMC::CorrelatedBlackScholesMC(
+    std::vector<double> sigmas, const std::vector<double> &correlation)
+    : sigmas_(std::move(sigmas)),
+      cholesky_(choleskyFactor(correlation, sigmas_.size())) {}
+
+void CorrelatedBlackScholesMC::simulatePaths(const std::vector<double> &spots0,
+                                             const TimeGrid &grid,
+                                             std::mt19937 &rng,
+                                             std::vector<double> &out) const {
+  const std::size_t n = sigmas_.size();
+  const std::size_t dates = grid.times.size();
+  out.resize(dates * n);
+
+  // Small per-call buffers: n values each, reused for every date.
+  std::vector<double> normals(2 * n);
+  std::vector<double> logSpot(n);
+  for (std::size_t a = 0; a < n; ++a) {
+    logSpot[a] = std::log(spots0[a]);
+  }
+
+  std::normal_distribution<double> dist(0.0, 1.0);
+  for (std::size_t i = 0; i < dates; ++i) {
+    const double dt = grid.dt[i];
+    double *spots = out.data() + i * n;
+    if (dt > 1e-8) {
+      drawCorrelated(cholesky_, n, dist, rng, normals.data(),
+                     normals.data() + n);
+      const double sqrtDt = grid.sqrtDt[i];
+      const double growth = grid.logGrowth[i];
+      for (std::size_t a = 0; a < n; ++a) {
+        const double sigma = sigmas_[a];
+        logSpot[a] += growth - 0.5 * sigma * sigma * dt +
+                      sigma * sqrtDt * normals[n + a];
+      }
+    }
+    for (std::size_t a = 0; a < n; ++a) {
+      spots[a] = std::exp(logSpot[a]);
+    }
+  }
+}
+
+CorrelatedHestonMC::CorrelatedHestonMC(std::vector<double> v0s, double kappa,
+                                       double theta, double xi, double rho,
+                                       const std::vector<double> &correlation)
+    : v0s_(std::move(v0s)), kappa_(kappa), theta_(theta), xi_(xi), rho_(rho),
+      cholesky_(choleskyFactor(correlation, v0s_.size())) {}
+
+void CorrelatedHestonMC::simulatePaths(const std::vector<double> &spots0,
+                                       const TimeGrid &grid, std::mt19937 &rng,
+                                       std::vector<double> &out) const {
+  const std::vector<double> &times = grid.times;
+  const std::size_t n = v0s_.size();
+  const double rhoBar = std::sqrt(1.0 - rho_ * rho_);
+  const double dtStep = 0.01; // Same sub-step as HestonMC.
+  out.resize(times.size() * n);
+
+  std::vector<double> normals(2 * n);
+  std::vector<double> spot(spots0.begin(), spots0.end());
+  std::vector<double> v(v0s_.begin(), v0s_.end());
+
+  std::normal_distribution<double> dist(0.0, 1.0);
+  double prevTime = 0.0;
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    double currentTime = prevTime;
+    const double targetTime = times[i];
+    const double r = grid.forwardRates[i];
+    while (currentTime < targetTime) {
+      const double dt = std::min(dtStep, targetTime - currentTime);
+      if (dt <= 1e-8)
+        break;
+      const double sqrtDt = std::sqrt(dt);
+
+      drawCorrelated(cholesky_, n, dist, rng, normals.data(),
+                     normals.data() + n);
+      for (std::size_t a = 0; a < n; ++a) {
+        const double zs = normals[n + a];
+        const double zv = rho_ * zs + rhoBar * dist(rng);
+        const double vPlus = std::max(v[a], 0.0);
+        const double sqrtV = std::sqrt(vPlus);
+        v[a] += kappa_ * (theta_ - vPlus) * dt + xi_ * sqrtV * sqrtDt * zv;
+        spot[a] *= std::exp((r - 0.5 * vPlus) * dt + sqrtV * sqrtDt * zs);
+      }
+      currentTime += dt;
+    }
+    std::copy(spot.begin(), spot.end(), out.begin() + i * n);
+    prevTime = targetTime;
+  }
+}
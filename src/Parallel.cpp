@@ -0,0 +1,67 @@
+#include "Parallel.hpp"
+
+namespace detail {
+
+WorkerPool &WorkerPool::instance() {
+  static WorkerPool pool(workerCount() - 1);
+  return pool;
+}
+
+WorkerPool::WorkerPool(std::size_t threads) {
+  threads_.reserve(threads);
+  for (std::size_t t = 0; t < threads; ++t) {
+    threads_.emplace_back(&WorkerPool::loop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  ready_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::run(ParallelJob &job, std::size_t helpers) {
+  helpers = std::min(helpers, threads_.size());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tickets_.insert(tickets_.end(), helpers, &job);
+  }
+  for (std::size_t h = 0; h < helpers; ++h) {
+    ready_.notify_one();
+  }
+  job.work();
+
+  // The tickets still queued are withdrawn under the lock, so no helper can
+  // join the job once it is left here.
+  std::unique_lock<std::mutex> lock(mutex_);
+  tickets_.erase(std::remove(tickets_.begin(), tickets_.end(), &job),
+                 tickets_.end());
+  left_.wait(lock, [&] { return job.active == 0; });
+}
+
+void WorkerPool::loop() {
+  insideParallelWorker() = true;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    ready_.wait(lock, [&] { return stopping_ || !tickets_.empty(); });
+    if (tickets_.empty()) {
+      return;
+    }
+    ParallelJob *job = tickets_.front();
+    tickets_.pop_front();
+    ++job->active;
+    lock.unlock();
+    job->work();
+    lock.lock();
+    if (--job->active == 0) {
+      left_.notify_all();
+    }
+  }
+}
+
+} // namespace detail
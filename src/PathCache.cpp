@@ -0,0 +1,114 @@
+#include "PathCache.hpp"
+#include "KahanSum.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+PathCache::PathCache(const PathModelBase &model, std::vector<double> times,
+                     double spot, const DiscountCurve &curve, std::size_t paths,
+                     unsigned int seed, bool keepBridge)
+    : times_(std::move(times)), paths_(paths) {
+  const std::size_t dates = times_.size();
+  if (dates == 0) {
+    return;
+  }
+  shapes_.resize(paths_ * dates);
+  if (keepBridge) {
+    variances_.resize(paths_ * dates);
+  }
+
+  const TimeGrid grid(times_, curve);
+  const std::vector<double> scales = dateScales(spot, curve);
+
+  // Same block streams as GreeksEngine; blocks write disjoint shapes.
+  parallelFor(pathBlockCount(paths_), [&](std::size_t b) {
+    std::mt19937 rng = pathBlockRng(seed, b);
+    std::vector<double> variance;
+    for (std::size_t p = b * kPathsPerBlock; p < pathBlockEnd(b, paths_);
+         ++p) {
+      // Both overloads draw the same normals.
+      const std::vector<double> path =
+          keepBridge ? model.simulatePath(spot, grid, rng, variance)
+                     : model.simulatePath(spot, grid, rng);
+      if (keepBridge) {
+        std::copy(variance.begin(), variance.end(),
+                  variances_.begin() + p * dates);
+      }
+      double *shape = shapes_.data() + p * dates;
+      for (std::size_t i = 0; i < dates; ++i) {
+        shape[i] = scales[i] > 0.0 ? path[i] / scales[i] : 0.0;
+      }
+    }
+  });
+}
+
+std::vector<double> PathCache::dateScales(double spot,
+                                          const DiscountCurve &curve) const {
+  std::vector<double> scales(times_.size());
+  for (std::size_t i = 0; i < times_.size(); ++i) {
+    scales[i] = spot * std::exp(-curve.logDiscount(times_[i]));
+  }
+  return scales;
+}
+
+void PathCache::fillPath(std::size_t p, const std::vector<double> &scales,
+                         std::vector<double> &out) const {
+  const std::size_t dates = times_.size();
+  out.resize(dates);
+  const double *shape = shapes_.data() + p * dates;
+  for (std::size_t i = 0; i < dates; ++i) {
+    out[i] = shape[i] * scales[i];
+  }
+}
+
+void PathCache::fillBatch(std::size_t first, std::size_t count,
+                          const std::vector<double> &scales,
+                          std::vector<double> &out) const {
+  const std::size_t dates = times_.size();
+  out.resize(dates * count);
+  for (std::size_t k = 0; k < count; ++k) {
+    const double *shape = shapes_.data() + (first + k) * dates;
+    for (std::size_t i = 0; i < dates; ++i) {
+      out[i * count + k] = shape[i] * scales[i];
+    }
+  }
+}
+
+double PathCache::price(const StructuredProduct &product, double spot,
+                        const DiscountCurve &curve,
+                        double &standardError) const {
+  if (times_.empty() || paths_ == 0) {
+    standardError = 0.0;
+    const double noDiscount = 1.0;
+    return product.discountedPayoff(std::vector<double>{spot}, &noDiscount);
+  }
+
+  const std::vector<double> scales = dateScales(spot, curve);
+  const TimeGrid grid(times_, curve);
+  const double *discountFactors = grid.discountFactors.data();
+  PayoffSums sums;
+  auto add = [&](double pathValue) { sums.add(pathValue); };
+  if (product.hasBatchKernel()) {
+    std::vector<double> batch;
+    std::vector<double> values(kBatchPaths);
+    for (std::size_t first = 0; first < paths_; first += kBatchPaths) {
+      const std::size_t count = std::min(kBatchPaths, paths_ - first);
+      fillBatch(first, count, scales, batch);
+      product.discountedPayoffs(batch.data(), count, discountFactors,
+                                values.data());
+      std::for_each(values.begin(), values.begin() + count, add);
+    }
+  } else {
+    std::vector<double> path;
+    for (std::size_t p = 0; p < paths_; ++p) {
+      fillPath(p, scales, path);
+      add(product.discountedPayoff(path, discountFactors));
+    }
+  }
+
+  standardError = sums.stdError();
+  return sums.mean();
+}
@@ -0,0 +1,337 @@
+#include "PathStore.hpp"
+#include "DiscountCurve.hpp"
+#include "KahanSum.hpp"
+#include "Parallel.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr char kMagic[8] = {'P', 'S', 'T', 'O', 'R', 'E', '\0', '\1'};
+constexpr std::uint32_t kVersion = 2;
+constexpr std::size_t kMaxParams = 5;
+
+// On-disk header. All fields are fixed-width and the struct size is a
+// multiple of 8, so the date grid and the payload stay 8-byte aligned.
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t modelType;
+  std::uint32_t precision;
+  std::uint32_t seed;
+  std::uint64_t pathCount;
+  std::uint64_t dateCount;
+  double spot;
+  double rate;
+  std::uint32_t paramCount;
+  std::uint32_t tilePaths;
+  double modelParams[kMaxParams];
+};
+static_assert(sizeof(FileHeader) % 8 == 0, "header must keep 8-byte alignment");
+
+std::size_t valueSize(PathPrecision precision) {
+  return precision == PathPrecision::Float32 ? sizeof(float) : sizeof(double);
+}
+
+FileHeader makeHeader(const PathStoreInfo &info) {
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.modelType = static_cast<std::uint32_t>(info.modelType);
+  header.precision = static_cast<std::uint32_t>(info.precision);
+  header.seed = info.seed;
+  header.pathCount = info.pathCount;
+  header.dateCount = info.times.size();
+  header.spot = info.spot;
+  header.rate = info.rate;
+  header.tilePaths = static_cast<std::uint32_t>(kPathsPerBlock);
+  header.paramCount = static_cast<std::uint32_t>(
+      std::min(info.modelParams.size(), kMaxParams));
+  for (std::size_t k = 0; k < header.paramCount; ++k) {
+    header.modelParams[k] = info.modelParams[k];
+  }
+  return header;
+}
+
+// pwrite until done; false on error.
+bool writeAt(int fd, const void *data, std::size_t size, std::size_t offset) {
+  const auto *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    const ssize_t written =
+        ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+    offset += static_cast<std::size_t>(written);
+  }
+  return true;
+}
+} // namespace
+
+PathStoreInfo makePathStoreInfo(const PricingInputs &inputs,
+                                PathPrecision precision) {
+  if (!inputs.basket.empty()) {
+    throw std::runtime_error("PathStore: only single-asset paths are stored");
+  }
+  if (!inputs.curveTimes.empty()) {
+    throw std::runtime_error("PathStore: only flat-rate paths are stored");
+  }
+  PathStoreInfo info;
+  info.modelType = inputs.modelType;
+  if (inputs.modelType == ModelType::Heston) {
+    info.modelParams = {inputs.hestonV0, inputs.hestonKappa, inputs.hestonTheta,
+                        inputs.hestonXi, inputs.hestonRho};
+  } else if (inputs.modelType == ModelType::LocalVol ||
+             inputs.modelType == ModelType::Slv) {
+    // The surface does not fit the fixed-size header; the model type alone
+    // tags the store.
+    info.modelParams.clear();
+  } else {
+    info.modelParams = {inputs.sigma};
+  }
+  info.spot = inputs.spot;
+  info.rate = inputs.rate;
+  info.seed = inputs.seed;
+  info.times = inputs.observationTimes;
+  info.precision = precision;
+  return info;
+}
+
+PathStoreWriter::PathStoreWriter(const std::string &filename,
+                                 PathStoreInfo info)
+    : info_(std::move(info)) {
+  fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("PathStore: cannot open " + filename);
+  }
+  const std::size_t dates = info_.times.size();
+  payloadOffset_ = sizeof(FileHeader) + dates * sizeof(double);
+  const std::size_t size =
+      payloadOffset_ + static_cast<std::size_t>(info_.pathCount) * dates *
+                           valueSize(info_.precision);
+  const FileHeader header = makeHeader(info_);
+  if (!writeAt(fd_, &header, sizeof(header), 0) ||
+      !writeAt(fd_, info_.times.data(), dates * sizeof(double),
+               sizeof(FileHeader)) ||
+      ::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    ::close(fd_);
+    fd_ = -1;
+    throw std::runtime_error("PathStore: write failed for " + filename);
+  }
+}
+
+PathStoreWriter::~PathStoreWriter() {
+  try {
+    close();
+  } catch (...) {
+    // Destructors must not throw; an explicit close() reports errors.
+  }
+}
+
+std::size_t PathStoreWriter::tileCount() const {
+  return pathBlockCount(static_cast<std::size_t>(info_.pathCount));
+}
+
+std::size_t PathStoreWriter::tilePathCount(std::size_t tile) const {
+  return pathBlockEnd(tile, static_cast<std::size_t>(info_.pathCount)) -
+         tile * kPathsPerBlock;
+}
+
+void PathStoreWriter::writeTile(std::size_t tile, const double *spots) const {
+  const std::size_t values = tilePathCount(tile) * info_.times.size();
+  const std::size_t offset =
+      payloadOffset_ +
+      tile * kPathsPerBlock * info_.times.size() * valueSize(info_.precision);
+  bool written = false;
+  if (info_.precision == PathPrecision::Float32) {
+    const std::vector<float> narrowed(spots, spots + values);
+    written = writeAt(fd_, narrowed.data(), values * sizeof(float), offset);
+  } else {
+    written = writeAt(fd_, spots, values * sizeof(double), offset);
+  }
+  if (!written) {
+    throw std::runtime_error("PathStore: write failed");
+  }
+}
+
+void PathStoreWriter::close() {
+  if (fd_ < 0) {
+    return;
+  }
+  const int fd = fd_;
+  fd_ = -1;
+  if (::close(fd) != 0) {
+    throw std::runtime_error("PathStore: write failed");
+  }
+}
+
+void writePathStore(const std::string &filename, const PathModelBase &model,
+                    PathStoreInfo info, std::size_t paths) {
+  if (info.times.empty()) {
+    throw std::runtime_error("PathStore: empty date grid");
+  }
+  const TimeGrid grid(info.times, DiscountCurve(info.rate));
+  const std::size_t dates = info.times.size();
+  const double spot = info.spot;
+  const unsigned int seed = info.seed;
+  info.pathCount = paths;
+
+  PathStoreWriter writer(filename, std::move(info));
+  // One block stream per tile; tiles land at disjoint offsets.
+  parallelFor(writer.tileCount(), [&](std::size_t b) {
+    const std::size_t count = writer.tilePathCount(b);
+    std::vector<double> tile(count * dates);
+    std::mt19937 rng = pathBlockRng(seed, b);
+    for (std::size_t k = 0; k < count; ++k) {
+      const std::vector<double> path = model.simulatePath(spot, grid, rng);
+      for (std::size_t i = 0; i < dates; ++i) {
+        tile[i * count + k] = path[i];
+      }
+    }
+    writer.writeTile(b, tile.data());
+  });
+  writer.close();
+}
+
+PathStoreReader::PathStoreReader(const std::string &filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("PathStore: cannot open " + filename);
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error("PathStore: truncated file " + filename);
+  }
+  mappingSize_ = static_cast<std::size_t>(st.st_size);
+  mapping_ = ::mmap(nullptr, mappingSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    throw std::runtime_error("PathStore: mmap failed for " + filename);
+  }
+  ::madvise(mapping_, mappingSize_, MADV_SEQUENTIAL);
+
+  const auto *bytes = static_cast<const unsigned char *>(mapping_);
+  FileHeader header;
+  std::memcpy(&header, bytes, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    ::munmap(mapping_, mappingSize_);
+    throw std::runtime_error("PathStore: not a path store: " + filename);
+  }
+
+  auto reject = [&](const char *what) {
+    ::munmap(mapping_, mappingSize_);
+    mapping_ = nullptr;
+    throw std::runtime_error(std::string("PathStore: ") + what + " " +
+                             filename);
+  };
+  if (header.modelType > static_cast<std::uint32_t>(ModelType::Slv)) {
+    reject("unknown model type");
+  }
+  if (header.precision > static_cast<std::uint32_t>(PathPrecision::Float32)) {
+    reject("unknown precision");
+  }
+  info_.modelType = static_cast<ModelType>(header.modelType);
+  info_.precision = static_cast<PathPrecision>(header.precision);
+  info_.seed = header.seed;
+  info_.spot = header.spot;
+  info_.rate = header.rate;
+  info_.pathCount = header.pathCount;
+  info_.modelParams.assign(
+      header.modelParams,
+      header.modelParams + std::min<std::size_t>(header.paramCount, kMaxParams));
+  if (header.tilePaths == 0 && header.pathCount > 0) {
+    reject("invalid tile size");
+  }
+  tilePaths_ = header.tilePaths;
+
+  // Sizes are checked against the mapping one factor at a time, so a forged
+  // header cannot overflow them.
+  const std::size_t available = mappingSize_ - sizeof(FileHeader);
+  if (header.dateCount > available / sizeof(double)) {
+    reject("truncated file");
+  }
+  const std::size_t dates = static_cast<std::size_t>(header.dateCount);
+  const std::size_t gridBytes = dates * sizeof(double);
+  const std::size_t pathBytes = dates * valueSize(info_.precision);
+  if (pathBytes > 0 && header.pathCount > (available - gridBytes) / pathBytes) {
+    reject("truncated file");
+  }
+  info_.times.resize(dates);
+  std::memcpy(info_.times.data(), bytes + sizeof(FileHeader), gridBytes);
+  payload_ = bytes + sizeof(FileHeader) + gridBytes;
+}
+
+PathStoreReader::~PathStoreReader() {
+  if (mapping_) {
+    ::munmap(mapping_, mappingSize_);
+  }
+}
+
+std::size_t PathStoreReader::tileCount() const {
+  return tilePaths_ == 0 ? 0 : (pathCount() + tilePaths_ - 1) / tilePaths_;
+}
+
+std::size_t PathStoreReader::tilePathCount(std::size_t tile) const {
+  return std::min(pathCount(), (tile + 1) * tilePaths_) - tile * tilePaths_;
+}
+
+const double *PathStoreReader::tile(std::size_t tile,
+                                    std::vector<double> &scratch) const {
+  const std::size_t first = tile * tilePaths_ * dateCount();
+  if (info_.precision == PathPrecision::Float64) {
+    return reinterpret_cast<const double *>(payload_) + first;
+  }
+  const float *values = reinterpret_cast<const float *>(payload_) + first;
+  scratch.assign(values, values + tilePathCount(tile) * dateCount());
+  return scratch.data();
+}
+
+double PathStoreReader::price(const StructuredProduct &product,
+                              double &standardError) const {
+  const std::size_t paths = pathCount();
+  if (paths == 0 || dateCount() == 0) {
+    standardError = 0.0;
+    return 0.0;
+  }
+  if (product.observationTimes() != info_.times) {
+    throw std::runtime_error("PathStore: product dates differ from store");
+  }
+
+  // Discount factors are sampled once for the whole replay.
+  const TimeGrid grid(info_.times, DiscountCurve(info_.rate));
+  std::vector<PayoffSums> tileSums(tileCount());
+  parallelFor(tileSums.size(), [&](std::size_t b) {
+    std::vector<double> scratch;
+    const double *spots = tile(b, scratch);
+    std::vector<double> values(tilePathCount(b));
+    product.discountedPayoffs(spots, values.size(),
+                              grid.discountFactors.data(), values.data());
+    for (double value : values) {
+      tileSums[b].add(value);
+    }
+  });
+  PayoffSums sums;
+  for (const PayoffSums &tileSum : tileSums) {
+    sums.merge(tileSum);
+  }
+  standardError = sums.stdError();
+  return sums.mean();
+}
@@ -0,0 +1,250 @@
+#include "PayoffDistribution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+// Values buffered before a fold, in units of the compression.
+constexpr double kBufferFactor = 5.0;
+} // namespace
+
+TDigest::TDigest(double compression)
+    : compression_(compression),
+      min_(std::numeric_limits<double>::infinity()),
+      max_(-std::numeric_limits<double>::infinity()) {
+  if (!(compression > 0.0)) {
+    throw std::runtime_error("TDigest: compression must be positive");
+  }
+  buffer_.reserve(static_cast<std::size_t>(kBufferFactor * compression_));
+}
+
+void TDigest::add(double value) {
+  buffer_.push_back({value, 1.0});
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  if (buffer_.size() >= kBufferFactor * compression_) {
+    compress();
+  }
+}
+
+void TDigest::merge(const TDigest &other) {
+  if (centroids_.empty() && buffer_.empty() && other.buffer_.empty() &&
+      compression_ == other.compression_) {
+    // Into an empty digest a folded one is copied as is: folding it again
+    // would move its centroids, so a merge of per-block digests gathered
+    // apart would not equal the merge of the blocks themselves.
+    centroids_ = other.centroids_;
+    weight_ = other.weight_;
+    min_ = other.min_;
+    max_ = other.max_;
+    return;
+  }
+  buffer_.insert(buffer_.end(), other.centroids_.begin(),
+                 other.centroids_.end());
+  buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  compress();
+}
+
+double TDigest::count() const {
+  double total = weight_;
+  for (const auto &c : buffer_) {
+    total += c.weight;
+  }
+  return total;
+}
+
+void TDigest::compress() {
+  if (buffer_.empty()) {
+    return;
+  }
+  auto byMean = [](const Centroid &a, const Centroid &b) {
+    return a.mean < b.mean;
+  };
+  std::sort(buffer_.begin(), buffer_.end(), byMean);
+  std::vector<Centroid> all;
+  all.reserve(centroids_.size() + buffer_.size());
+  std::merge(centroids_.begin(), centroids_.end(), buffer_.begin(),
+             buffer_.end(), std::back_inserter(all), byMean);
+  buffer_.clear();
+
+  double total = 0.0;
+  for (const auto &c : all) {
+    total += c.weight;
+  }
+  // Largest cumulative weight a centroid starting at `before` may reach:
+  // one unit of k(q) = compression / (2 pi) asin(2q - 1) further.
+  const double scale = compression_ / (2.0 * kPi);
+  auto limitAfter = [&](double before) {
+    const double k = scale * std::asin(std::min(2.0 * before / total - 1.0,
+                                                1.0)) +
+                     1.0;
+    if (k >= 0.25 * compression_) {
+      return total;
+    }
+    return total * 0.5 * (std::sin(k / scale) + 1.0);
+  };
+
+  centroids_.clear();
+  Centroid current = all.front();
+  double before = 0.0;
+  double limit = limitAfter(before);
+  for (std::size_t i = 1; i < all.size(); ++i) {
+    const Centroid &next = all[i];
+    if (before + current.weight + next.weight <= limit) {
+      current.weight += next.weight;
+      current.mean += (next.mean - current.mean) * next.weight / current.weight;
+    } else {
+      centroids_.push_back(current);
+      before += current.weight;
+      limit = limitAfter(before);
+      current = next;
+    }
+  }
+  centroids_.push_back(current);
+  weight_ = total;
+}
+
+void TDigest::clear() {
+  centroids_.clear();
+  buffer_.clear();
+  weight_ = 0.0;
+  min_ = std::numeric_limits<double>::infinity();
+  max_ = -std::numeric_limits<double>::infinity();
+}
+
+std::vector<TDigest::Knot> TDigest::quantileKnots() const {
+  if (!buffer_.empty()) {
+    TDigest folded(*this);
+    folded.compress();
+    return folded.quantileKnots();
+  }
+  // Each centroid sits at the middle of its weight; the extreme values
+  // close the curve at 0 and 1.
+  std::vector<Knot> knots;
+  knots.reserve(centroids_.size() + 2);
+  knots.push_back({0.0, min_});
+  double cumulative = 0.0;
+  for (const auto &c : centroids_) {
+    knots.push_back({(cumulative + 0.5 * c.weight) / weight_, c.mean});
+    cumulative += c.weight;
+  }
+  knots.push_back({1.0, max_});
+  return knots;
+}
+
+double TDigest::quantile(double q) const {
+  if (count() == 0.0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  const std::vector<Knot> knots = quantileKnots();
+  q = std::min(std::max(q, 0.0), 1.0);
+  for (std::size_t j = 1; j < knots.size(); ++j) {
+    if (q <= knots[j].fraction) {
+      const double span = knots[j].fraction - knots[j - 1].fraction;
+      const double t = span > 0.0 ? (q - knots[j - 1].fraction) / span : 1.0;
+      return knots[j - 1].value + t * (knots[j].value - knots[j - 1].value);
+    }
+  }
+  return max_;
+}
+
+double TDigest::meanBelow(double q) const {
+  if (count() == 0.0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  q = std::min(std::max(q, 0.0), 1.0);
+  if (q == 0.0) {
+    return min_;
+  }
+  const std::vector<Knot> knots = quantileKnots();
+  // Trapezoids of the piecewise-linear quantile function up to q.
+  double integral = 0.0;
+  for (std::size_t j = 1; j < knots.size(); ++j) {
+    const Knot &left = knots[j - 1];
+    const Knot &right = knots[j];
+    const double end = std::min(right.fraction, q);
+    if (end > left.fraction) {
+      const double valueAtEnd =
+          left.value + (end - left.fraction) /
+                           (right.fraction - left.fraction) *
+                           (right.value - left.value);
+      integral += 0.5 * (left.value + valueAtEnd) * (end - left.fraction);
+    }
+    if (right.fraction >= q) {
+      break;
+    }
+  }
+  return integral / q;
+}
+
+FixedHistogram::FixedHistogram(double low, double high, std::size_t bins)
+    : low_(low), width_((high - low) / static_cast<double>(bins)),
+      counts_(bins, 0) {
+  if (bins == 0 || !(high > low)) {
+    throw std::runtime_error("FixedHistogram: empty range");
+  }
+}
+
+void FixedHistogram::add(double value) {
+  if (value < low_) {
+    ++below_;
+    return;
+  }
+  const double position = (value - low_) / width_;
+  if (!(position < static_cast<double>(counts_.size()))) {
+    ++above_; // Above the range (or NaN).
+    return;
+  }
+  ++counts_[static_cast<std::size_t>(position)];
+}
+
+void FixedHistogram::clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  below_ = 0;
+  above_ = 0;
+}
+
+void FixedHistogram::merge(const FixedHistogram &other) {
+  if (other.counts_.size() != counts_.size() || other.low_ != low_ ||
+      other.width_ != width_) {
+    throw std::runtime_error("FixedHistogram: merging different bins");
+  }
+  for (std::size_t b = 0; b < counts_.size(); ++b) {
+    counts_[b] += other.counts_[b];
+  }
+  below_ += other.below_;
+  above_ += other.above_;
+}
+
+PayoffDistribution::PayoffDistribution(double histogramLow,
+                                       double histogramHigh, std::size_t bins,
+                                       double lossThreshold)
+    : histogram_(histogramLow, histogramHigh, bins),
+      lossThreshold_(lossThreshold) {}
+
+PayoffDistribution PayoffDistribution::emptyCopy() const {
+  PayoffDistribution copy(*this);
+  copy.digest_.clear();
+  copy.histogram_.clear();
+  copy.count_ = 0;
+  copy.losses_ = 0;
+  return copy;
+}
+
+void PayoffDistribution::merge(const PayoffDistribution &other) {
+  digest_.merge(other.digest_);
+  histogram_.merge(other.histogram_);
+  count_ += other.count_;
+  losses_ += other.losses_;
+}
+
+double PayoffDistribution::lossProbability() const {
+  return count_ > 0 ? static_cast<double>(losses_) / static_cast<double>(count_)
+                    : 0.0;
+}
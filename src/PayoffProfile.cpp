@@ -0,0 +1,127 @@
+#include "PayoffProfile.hpp"
+
+#include "Parallel.hpp"
+#include "PathModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+// Quantile of sorted values, interpolated between neighbours.
+double sortedQuantile(const std::vector<double> &sorted, double q) {
+  const double position = q * static_cast<double>(sorted.size() - 1);
+  const std::size_t below = static_cast<std::size_t>(std::floor(position));
+  const std::size_t above = std::min(below + 1, sorted.size() - 1);
+  const double t = position - static_cast<double>(below);
+  return sorted[below] + t * (sorted[above] - sorted[below]);
+}
+} // namespace
+
+PayoffProfile::PayoffProfile(const PricingInputs &inputs, std::size_t paths)
+    : inputs_(inputs) {
+  if (!inputs.basket.empty()) {
+    throw std::runtime_error(
+        "PayoffProfile: worst-of notes have no single terminal spot");
+  }
+  if (paths == 0) {
+    throw std::runtime_error("PayoffProfile: no paths");
+  }
+  inputs_.paths = paths;
+  const auto product = makeProduct(inputs_);
+  const std::vector<double> &times = product->observationTimes();
+  if (times.empty()) {
+    throw std::runtime_error("PayoffProfile: no observation dates");
+  }
+  const DiscountCurve curve = makeDiscountCurve(inputs_);
+  const auto model = makePathModel(inputs_);
+  // Bridge data is kept whatever the monitoring of these inputs, so later
+  // terms monitored during the life of the note reuse the same paths.
+  cache_ = std::make_unique<PathCache>(*model, times, inputs_.spot, curve,
+                                       paths, inputs_.seed, true);
+
+  const std::vector<double> scales = cache_->dateScales(inputs_.spot, curve);
+  std::vector<double> terminal(paths), path;
+  for (std::size_t p = 0; p < paths; ++p) {
+    cache_->fillPath(p, scales, path);
+    terminal[p] = path.back();
+  }
+  order_.resize(paths);
+  std::iota(order_.begin(), order_.end(), std::size_t{0});
+  std::stable_sort(order_.begin(), order_.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return terminal[a] < terminal[b];
+                   });
+}
+
+bool PayoffProfile::covers(const PricingInputs &inputs) const {
+  PricingInputs candidate = inputs;
+  candidate.paths = inputs_.paths;
+  if (!inputs.basket.empty() || !sharesPaths(inputs_, candidate) ||
+      makeProduct(candidate)->observationTimes() != cache_->times()) {
+    return false;
+  }
+  switch (inputs.modelType) {
+  case ModelType::BlackScholes:
+  case ModelType::Heston:
+    return true;
+  case ModelType::LocalVol:
+  case ModelType::Slv:
+    break;
+  }
+  // The local vol surface is read at the simulated spots.
+  return sharesSimulation(inputs_, candidate);
+}
+
+std::vector<PayoffProfileBin>
+PayoffProfile::compute(const PricingInputs &inputs, std::size_t bins) const {
+  if (!covers(inputs)) {
+    throw std::runtime_error(
+        "PayoffProfile: the cached paths do not match the inputs");
+  }
+  const auto product = makeProduct(inputs);
+  const DiscountCurve curve = makeDiscountCurve(inputs);
+  const TimeGrid grid(cache_->times(), curve);
+  const std::vector<double> scales = cache_->dateScales(inputs.spot, curve);
+  const bool bridge = product->needsBridge();
+  const std::size_t paths = cache_->pathCount();
+
+  std::vector<double> payoffs(paths), terminal(paths);
+  parallelFor(pathBlockCount(paths), [&](std::size_t b) {
+    std::vector<double> path;
+    for (std::size_t p = b * kPathsPerBlock; p < pathBlockEnd(b, paths); ++p) {
+      cache_->fillPath(p, scales, path);
+      PathView view(path);
+      if (bridge) {
+        view = view.withBridge(inputs.spot, cache_->intervalVariance(p));
+      }
+      payoffs[p] = product->discountedPayoff(view,
+                                             grid.discountFactors.data());
+      terminal[p] = path.back();
+    }
+  });
+
+  bins = std::max<std::size_t>(1, std::min(bins, paths));
+  std::vector<PayoffProfileBin> profile(bins);
+  std::vector<double> values;
+  for (std::size_t k = 0; k < bins; ++k) {
+    const std::size_t first = k * paths / bins;
+    const std::size_t last = (k + 1) * paths / bins;
+    PayoffProfileBin &bin = profile[k];
+    values.clear();
+    double spotSum = 0.0;
+    for (std::size_t j = first; j < last; ++j) {
+      values.push_back(payoffs[order_[j]]);
+      spotSum += terminal[order_[j]];
+    }
+    bin.paths = values.size();
+    bin.terminalSpot = spotSum / static_cast<double>(bin.paths);
+    bin.mean = std::accumulate(values.begin(), values.end(), 0.0) /
+               static_cast<double>(bin.paths);
+    std::sort(values.begin(), values.end());
+    bin.lower = sortedQuantile(values, kLowerBand);
+    bin.upper = sortedQuantile(values, kUpperBand);
+  }
+  return profile;
+}
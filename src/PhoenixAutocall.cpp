@@ -11,8 +11,8 @@ PhoenixAutocall::PhoenixAutocall(std::string underlying,
                    notional, couponRate, callBarrier, protectionBarrier),
       couponBarrier_(couponBarrier) {}
 
-double PhoenixAutocall::discountedPayoff(const std::vector<double> &path,
-                                         double riskFreeRate) const {
+double PhoenixAutocall::payoff(PathView path, const double *discountFactors,
+                               LifeEvents *events) const {
   double totalValue = 0.0;
   const auto &obs = times();
   const std::size_t steps = std::min(path.size(), obs.size());
@@ -21,18 +21,32 @@ double PhoenixAutocall::discountedPayoff(const std::vector<double> &path,
     // Coupon
     if (path[i] >= couponBarrier_) {
       totalValue +=
-          (notional() * couponRate()) * std::exp(-riskFreeRate * obs[i]);
+          (notional() * couponRate()) * discountFactors[i];
+      if (events) {
+        events->couponPaid(i);
+      }
     }
     // Autocall
     if (path[i] >= callBarrier()) {
-      totalValue += notional() * std::exp(-riskFreeRate * obs[i]);
+      totalValue += notional() * discountFactors[i];
+      if (events) {
+        events->called(i);
+      }
       return totalValue;
     }
   }
 
   // Maturité
-  const double finalSpot = (steps > 0) ? path[steps - 1] : spot0();
+  if (events) {
+    events->matured();
+  }
   totalValue +=
-      terminalRedemption(finalSpot) * std::exp(-riskFreeRate * obs.back());
+      maturityRedemption(path) * discountFactors[obs.size() - 1];
   return totalValue;
-}
\ No newline at end of file
+}
+
+AutocallBase::ObservationRule
+PhoenixAutocall::observationRule(std::size_t /*i*/) const {
+  return {callBarrier(), notional(), couponBarrier_, notional() * couponRate(),
+          false};
+}
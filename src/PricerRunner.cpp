@@ -1,216 +1,1266 @@
 #include "PricerRunner.hpp"
 
 #include "AirbagAutocall.hpp"
+#include "CliquetAnalytic.hpp"
 #include "CliquetCappedCoupons.hpp"
 #include "CliquetMaxReturn.hpp"
+#include "CompiledAutocall.hpp"
 #include "MemoryPhoenixAutocall.hpp"
 #include "PhoenixAutocall.hpp"
 #include "SimpleAutocall.hpp"
 #include "StepDownAutocall.hpp"
 
 #include "BlackScholesMC.hpp"
+#include "AutocallQuadrature.hpp"
+#include "BlackScholesPde.hpp"
 #include "HestonMC.hpp"
+#include "GreeksEngine.hpp"
+#include "HestonPde.hpp"
+#include "KahanSum.hpp"
+#include "LocalVolMC.hpp"
+#include "LongstaffSchwartz.hpp"
+#include "SlvMC.hpp"
 #include "MarketData.hpp"
+#include "MultiAssetModel.hpp"
+#include "Parallel.hpp"
 #include "PathModel.hpp"
+#include "PayoffDistribution.hpp"
+#include "WorkStealing.hpp"
+#include "WorstOfProduct.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace {
 constexpr double kSpotBumpFraction = 0.005;
 constexpr double kVolBumpAdd = 0.01;
+constexpr double kRateBump = 0.0001;
+// The LSM regression set must not share the pricing paths.
+constexpr unsigned int kLsmSeedSalt = 0x9e3779b9u;
 
-// Factory helper to create the model with the correct parameters
-std::unique_ptr<PathModelBase> makePathModel(const PricingInputs &inputs) {
-  switch (inputs.modelType) {
-  case ModelType::BlackScholes:
-    // Pass sigma directly to the BS model
-    return std::make_unique<BlackScholesMC>(inputs.sigma);
-  case ModelType::Heston:
-    return std::make_unique<HestonMC>(inputs.hestonV0, inputs.hestonKappa,
-                                      inputs.hestonTheta, inputs.hestonXi,
-                                      inputs.hestonRho);
+// Curve move priced on the paths of the base run. Both models simulate
+// S_t = S_0 / DF(t) * X_t with X_t independent of the curve, so a shifted
+// curve only rescales date i by DF(t_i) / DF'(t_i) and re-discounts with DF':
+// rho needs no second simulation.
+struct RateScenario {
+  RateScenario(const TimeGrid &base, const TimeGrid &bumped)
+      : discountFactors(bumped.discountFactors) {
+    pathScales.resize(base.times.size());
+    for (std::size_t i = 0; i < pathScales.size(); ++i) {
+      pathScales[i] = base.discountFactors[i] / bumped.discountFactors[i];
+    }
   }
-  return std::make_unique<BlackScholesMC>(inputs.sigma);
+
+  std::vector<double> pathScales;
+  std::vector<double> discountFactors;
+  double price{}; // Filled by the Monte Carlo run.
+};
+
+// Sums of one block of paths. Blocks are merged in block order, so prices do
+// not depend on the number of threads.
+struct BlockSums {
+  PayoffSums payoff;
+  KahanSum scenario;
+};
+
+double mergeBlocks(const std::vector<BlockSums> &blocks, std::size_t paths,
+                   double &standardError, RateScenario *rateScenario) {
+  PayoffSums payoffSums;
+  KahanSum scenarioSum;
+  for (const auto &block : blocks) {
+    payoffSums.merge(block.payoff);
+    scenarioSum.add(block.scenario.sum);
+  }
+
+  if (rateScenario && paths > 0) {
+    rateScenario->price = scenarioSum.sum / static_cast<double>(paths);
+  }
+  standardError = payoffSums.stdError();
+  return payoffSums.mean();
 }
 
-double runMonteCarlo(const StructuredProduct &product, const MarketData &data,
-                     const PathModelBase &model, std::size_t paths,
-                     unsigned int seed, double &standardError) {
+// Basket Monte Carlo run: spots are read from the quote of each asset and
+// joint paths are simulated in the [date][asset] layout into a
+// buffer reused across the paths of a block.
+double runMonteCarloBasket(const WorstOfProduct &product,
+                           const MarketData &data,
+                           const MultiAssetPathModel &model, std::size_t paths,
+                           unsigned int seed, double &standardError,
+                           RateScenario *rateScenario = nullptr) {
   const auto &times = product.observationTimes();
-  // Retrieve spot from MarketData
-  const auto &quote = data.getQuote(product.underlying());
-  const double r = data.riskFreeRate();
 
-  std::vector<double> immediatePath{quote.spot};
+  std::vector<double> spots0;
+  spots0.reserve(product.assetCount());
+  for (SymbolId asset : product.assetIds()) {
+    spots0.push_back(data.getQuote(asset).spot);
+  }
 
   if (times.empty()) {
-    double val = product.discountedPayoff(immediatePath, r);
     standardError = 0.0;
+    const double noDiscount = 1.0;
+    const double val = product.discountedPayoff(spots0, &noDiscount);
+    if (rateScenario) {
+      rateScenario->price = val;
+    }
     return val;
   }
 
-  std::mt19937 rng(seed);
-  double payoffSum = 0.0;
-  double payoffSqSum = 0.0;
+  const TimeGrid grid(times, data.discountCurve());
+  const std::size_t assets = spots0.size();
+
+  std::vector<BlockSums> blocks(pathBlockCount(paths));
+  parallelFor(blocks.size(), [&](std::size_t b) {
+    std::mt19937 rng = pathBlockRng(seed, b);
+    BlockSums &sums = blocks[b];
+    std::vector<double> path;
+    std::vector<double> scenarioPath(times.size() * assets);
+
+    for (std::size_t i = b * kPathsPerBlock; i < pathBlockEnd(b, paths); ++i) {
+      model.simulatePaths(spots0, grid, rng, path);
+      const double pathValue =
+          product.discountedPayoff(path, grid.discountFactors.data());
+      sums.payoff.add(pathValue);
+
+      if (rateScenario) {
+        for (std::size_t k = 0; k < path.size(); ++k) {
+          scenarioPath[k] = path[k] * rateScenario->pathScales[k / assets];
+        }
+        sums.scenario.add(product.discountedPayoff(
+            scenarioPath, rateScenario->discountFactors.data()));
+      }
+    }
+  });
+
+  return mergeBlocks(blocks, paths, standardError, rateScenario);
+}
+
+// Model inputs of the vega scenarios: v0 for Heston; otherwise a parallel
+// shift of sigma and of the implied surface (local vol and SLV; SLV
+// recalibrates its leverage on the shifted surface).
+PricingInputs volBumpedInputs(const PricingInputs &inputs,
+                              double shift = kVolBumpAdd) {
+  PricingInputs bumped = inputs;
+  if (inputs.modelType == ModelType::Heston) {
+    bumped.hestonV0 += shift;
+    return bumped;
+  }
+  bumped.sigma += shift;
+  for (double &vol : bumped.volMatrix) {
+    vol += shift;
+  }
+  return bumped;
+}
+
+// Worst-of pricing. Delta is taken along a proportional move of every asset
+// and expressed per unit of the reference level, so it reads like the
+// single-asset delta; per-asset deltas are bumped one asset at a time. Vega
+// bumps every sigma (BS) or every v0 (Heston) together. Spot and vol bumps
+// are central, up and down on the seed of the price (vega falls back to the
+// up bump when the down one would take a vol to zero).
+PricingResults priceBasket(const PricingInputs &inputs,
+                           const WorstOfProduct &product) {
+  const std::vector<SymbolId> &ids = product.assetIds();
+  std::vector<std::pair<SymbolId, MarketQuote>> quotes;
+  for (std::size_t k = 0; k < inputs.basket.size(); ++k) {
+    quotes.emplace_back(ids[k], MarketQuote{inputs.basket[k].spot,
+                                            inputs.basket[k].sigma});
+  }
+  // Bumped scenarios below are overlays sharing this snapshot.
+  MarketData marketData(std::make_shared<const MarketSnapshot>(quotes));
+  marketData.setDiscountCurve(makeDiscountCurve(inputs));
+
+  const auto &times = product.observationTimes();
+  RateScenario rateUp(
+      TimeGrid(times, marketData.discountCurve()),
+      TimeGrid(times, marketData.discountCurve().shifted(kRateBump)));
+
+  const auto model = makeBasketModel(inputs);
+  double stdError = 0.0;
+  const double price = runMonteCarloBasket(
+      product, marketData, *model, inputs.paths, inputs.seed, stdError, &rateUp);
+
+  PricingResults results;
+  results.price = price;
+  results.stdError = stdError;
+  results.rho = (rateUp.price - price) / kRateBump;
+
+  double ignore = 0.0;
+  const double refBump = inputs.spot * kSpotBumpFraction;
+  if (refBump > 0.0) {
+    MarketData allUp = marketData;
+    MarketData allDown = marketData;
+    for (SymbolId id : ids) {
+      auto quote = marketData.getQuote(id);
+      const double spot = quote.spot;
+      quote.spot = spot * (1.0 + kSpotBumpFraction);
+      allUp.setQuote(id, quote);
+      quote.spot = spot * (1.0 - kSpotBumpFraction);
+      allDown.setQuote(id, quote);
+    }
+    const double upPrice = runMonteCarloBasket(
+        product, allUp, *model, inputs.paths, inputs.seed, ignore);
+    const double downPrice = runMonteCarloBasket(
+        product, allDown, *model, inputs.paths, inputs.seed, ignore);
+    results.delta = (upPrice - downPrice) / (2.0 * refBump);
+  }
+
+  results.assetDeltas.assign(inputs.basket.size(), 0.0);
+  for (std::size_t k = 0; k < inputs.basket.size(); ++k) {
+    const double bump = inputs.basket[k].spot * kSpotBumpFraction;
+    if (bump <= 0.0) {
+      continue;
+    }
+    MarketData oneUp = marketData;
+    MarketData oneDown = marketData;
+    auto quote = marketData.getQuote(ids[k]);
+    const double spot = quote.spot;
+    quote.spot = spot + bump;
+    oneUp.setQuote(ids[k], quote);
+    quote.spot = spot - bump;
+    oneDown.setQuote(ids[k], quote);
+    const double upPrice = runMonteCarloBasket(
+        product, oneUp, *model, inputs.paths, inputs.seed, ignore);
+    const double downPrice = runMonteCarloBasket(
+        product, oneDown, *model, inputs.paths, inputs.seed, ignore);
+    results.assetDeltas[k] = (upPrice - downPrice) / (2.0 * bump);
+  }
+
+  const bool heston = inputs.modelType == ModelType::Heston;
+  auto volShifted = [&](double shift) {
+    PricingInputs shifted = inputs;
+    for (auto &asset : shifted.basket) {
+      if (heston) {
+        asset.hestonV0 += shift;
+      } else {
+        asset.sigma += shift;
+      }
+    }
+    return makeBasketModel(shifted);
+  };
+  const bool downShiftable =
+      std::all_of(inputs.basket.begin(), inputs.basket.end(),
+                  [&](const BasketAsset &asset) {
+                    return (heston ? asset.hestonV0 : asset.sigma) >
+                           kVolBumpAdd;
+                  });
+  const double volDown = downShiftable ? kVolBumpAdd : 0.0;
+  const double vegaUp =
+      runMonteCarloBasket(product, marketData, *volShifted(kVolBumpAdd),
+                          inputs.paths, inputs.seed, ignore);
+  const double vegaDown =
+      volDown > 0.0
+          ? runMonteCarloBasket(product, marketData, *volShifted(-volDown),
+                                inputs.paths, inputs.seed, ignore)
+          : price;
+  results.vega = (vegaUp - vegaDown) / (kVolBumpAdd + volDown);
+
+  const double spread = inputs.notional * inputs.spreadFraction;
+  results.bid = price - spread;
+  results.ask = price + spread;
+  return results;
+}
+
+// Issuer-callable notes: the exercise rule is fitted once on its own paths
+// and kept for the bumped scenarios, which all reuse the pricing seed.
+PricingResults priceIssuerCallable(const PricingInputs &inputs,
+                                   const StructuredProduct &product) {
+  LsmSettings settings;
+  settings.regressionPaths = inputs.lsmRegressionPaths;
+  settings.firstCallDate = inputs.issuerCallFirstDate;
+  LongstaffSchwartz engine(product, settings);
+
+  const auto model = makePathModel(inputs);
+  const DiscountCurve curve = makeDiscountCurve(inputs);
+  engine.fit(*model, inputs.spot, curve, inputs.seed ^ kLsmSeedSalt);
+
+  PricingResults results;
+  results.price = engine.price(*model, inputs.spot, curve, inputs.paths,
+                               inputs.seed, results.stdError);
+
+  double ignore = 0.0;
+  const double spotBump = inputs.spot * kSpotBumpFraction;
+  if (spotBump > 0.0) {
+    const double bumpedPrice =
+        engine.price(*model, inputs.spot + spotBump, curve, inputs.paths,
+                     inputs.seed, ignore);
+    results.delta = (bumpedPrice - results.price) / spotBump;
+  }
+
+  const auto vegaModel = makePathModel(volBumpedInputs(inputs));
+  const double vegaPrice = engine.price(*vegaModel, inputs.spot, curve,
+                                        inputs.paths, inputs.seed, ignore);
+  results.vega = (vegaPrice - results.price) / kVolBumpAdd;
+
+  const double ratePrice =
+      engine.price(*model, inputs.spot, curve.shifted(kRateBump), inputs.paths,
+                   inputs.seed, ignore);
+  results.rho = (ratePrice - results.price) / kRateBump;
+
+  const double spread = inputs.notional * inputs.spreadFraction;
+  results.bid = results.price - spread;
+  results.ask = results.price + spread;
+  return results;
+}
+
+// Noise-free price/delta/gamma from the Crank-Nicolson grid; vega and rho
+// from one-sided bumped solves (the Monte Carlo engine uses central ones).
+PricingResults priceWithBlackScholesPde(const PricingInputs &inputs,
+                                        const AutocallBase &product) {
+  const BlackScholesPde engine(inputs.sigma);
+  const auto base = engine.price(product, inputs.spot, inputs.rate);
+  const BlackScholesPde bumpedEngine(inputs.sigma + kVolBumpAdd);
+  const auto bumped = bumpedEngine.price(product, inputs.spot, inputs.rate);
+  const auto rateUp =
+      engine.price(product, inputs.spot, inputs.rate + kRateBump);
+
+  const double spread = inputs.notional * inputs.spreadFraction;
+  PricingResults results;
+  results.price = base.price;
+  results.delta = base.delta;
+  results.gamma = base.gamma;
+  results.vega = (bumped.price - base.price) / kVolBumpAdd;
+  results.rho = (rateUp.price - base.price) / kRateBump;
+  results.bid = base.price - spread;
+  results.ask = base.price + spread;
+  return results;
+}
+
+// Cliquets under Black-Scholes: price, delta, gamma and vega in closed form
+// (CliquetAnalytic); vanna, rho and theta are differences of the closed form
+// with the Monte Carlo bumps.
+PricingResults priceCliquetAnalytic(const PricingInputs &inputs,
+                                    const CliquetBase &product) {
+  const DiscountCurve curve = makeDiscountCurve(inputs);
+  const CliquetAnalytic engine({inputs.sigma});
+  const auto base = engine.price(product, inputs.spot, curve);
+  const auto volUp =
+      CliquetAnalytic({inputs.sigma + kVolBumpAdd}).price(product, inputs.spot,
+                                                          curve);
+  const auto volDown =
+      CliquetAnalytic({inputs.sigma - kVolBumpAdd}).price(product, inputs.spot,
+                                                          curve);
+  const auto rateUp =
+      engine.price(product, inputs.spot, curve.shifted(kRateBump));
+  const auto rateDown =
+      engine.price(product, inputs.spot, curve.shifted(-kRateBump));
+  const double timeShift = GreeksBumps{}.timeShift;
+  const auto later = engine.price(product, inputs.spot, curve, timeShift);
+
+  const double spread = inputs.notional * inputs.spreadFraction;
+  PricingResults results;
+  results.price = base.price;
+  results.delta = base.delta;
+  results.gamma = base.gamma;
+  results.vega = base.vega;
+  results.vanna = (volUp.delta - volDown.delta) / (2.0 * kVolBumpAdd);
+  results.rho = (rateUp.price - rateDown.price) / (2.0 * kRateBump);
+  results.theta = (later.price - base.price) / timeShift;
+  results.bid = base.price - spread;
+  results.ask = base.price + spread;
+  return results;
+}
+
+// Whether the period returns of a Black-Scholes cliquet are non-degenerate
+// lognormals, as CliquetAnalytic needs (also after the vol-down bump).
+bool hasAnalyticCliquet(const PricingInputs &inputs) {
+  if (inputs.modelType != ModelType::BlackScholes ||
+      inputs.sigma <= kVolBumpAdd) {
+    return false;
+  }
+  const auto &times = inputs.observationTimes;
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    if (times[i] <= (i > 0 ? times[i - 1] : 0.0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Black-Scholes autocalls tested only against the autocall barrier before
+// maturity: price, delta, gamma and vega by recursive quadrature
+// (AutocallQuadrature), the other Greeks as for the cliquets.
+PricingResults priceAutocallQuadrature(const PricingInputs &inputs,
+                                       const AutocallBase &product) {
+  const DiscountCurve curve = makeDiscountCurve(inputs);
+  const AutocallQuadrature engine(inputs.sigma);
+  const auto base = engine.price(product, inputs.spot, curve);
+  const auto volUp = AutocallQuadrature(inputs.sigma + kVolBumpAdd)
+                         .price(product, inputs.spot, curve);
+  const auto volDown = AutocallQuadrature(inputs.sigma - kVolBumpAdd)
+                           .price(product, inputs.spot, curve);
+  const auto rateUp =
+      engine.price(product, inputs.spot, curve.shifted(kRateBump));
+  const auto rateDown =
+      engine.price(product, inputs.spot, curve.shifted(-kRateBump));
 
-  for (std::size_t i = 0; i < paths; ++i) {
-    // The model uses quote.spot as the starting point
-    const std::vector<double> path =
-        model.simulatePath(quote.spot, times, data, rng);
+  const double spread = inputs.notional * inputs.spreadFraction;
+  PricingResults results;
+  results.price = base.price;
+  results.delta = base.delta;
+  results.gamma = base.gamma;
+  results.vega = base.vega;
+  results.vanna = (volUp.delta - volDown.delta) / (2.0 * kVolBumpAdd);
+  results.rho = (rateUp.price - rateDown.price) / (2.0 * kRateBump);
+  // No theta once the next observation is within the time shift.
+  const double timeShift = GreeksBumps{}.timeShift;
+  if (product.observationTimes().front() > timeShift) {
+    const auto later = engine.price(product, inputs.spot, curve, timeShift);
+    results.theta = (later.price - base.price) / timeShift;
+  }
+  results.bid = base.price - spread;
+  results.ask = base.price + spread;
+  return results;
+}
 
-    // NOUVEAU : Calcul direct du payoff actualisé
-    double pathValue =
-        product.discountedPayoff(path.empty() ? immediatePath : path, r);
+// Price, delta, gamma and vega from a single ADI solve: vega is dV/dv0 read
+// from the variance axis of the grid, consistent with the Monte Carlo v0
+// bump. Rho comes from a second solve with the bumped rate.
+PricingResults priceWithHestonPde(const PricingInputs &inputs,
+                                  const AutocallBase &product) {
+  const HestonPde engine(inputs.hestonV0, inputs.hestonKappa,
+                         inputs.hestonTheta, inputs.hestonXi, inputs.hestonRho);
+  const auto base = engine.price(product, inputs.spot, inputs.rate);
+  const auto rateUp =
+      engine.price(product, inputs.spot, inputs.rate + kRateBump);
 
-    payoffSum += pathValue;
-    payoffSqSum += pathValue * pathValue;
+  const double spread = inputs.notional * inputs.spreadFraction;
+  PricingResults results;
+  results.price = base.price;
+  results.delta = base.delta;
+  results.gamma = base.gamma;
+  results.vega = base.vega;
+  results.rho = (rateUp.price - base.price) / kRateBump;
+  results.bid = base.price - spread;
+  results.ask = base.price + spread;
+  return results;
+}
+} // namespace
+
+namespace {
+ImpliedVolSurface makeVolSurface(const PricingInputs &inputs) {
+  return inputs.volMatrix.empty()
+             ? ImpliedVolSurface::flat(inputs.sigma)
+             : ImpliedVolSurface(inputs.volExpiries, inputs.volMoneyness,
+                                 inputs.volMatrix);
+}
+
+// SLV leverage functions are calibrated once per underlying and market
+// (surface + Heston parameters) and shared by every later pricing: the
+// particle calibration costs far more than a pricing run. The leverage lives
+// in log(S/F) and does not depend on the spot or the curve.
+struct LeverageEntry {
+  std::string underlying;
+  double sigma;
+  std::vector<double> expiries;
+  std::vector<double> moneyness;
+  std::vector<double> vols;
+  double v0, kappa, theta, xi, rho;
+  std::shared_ptr<const SlvLeverage> leverage;
+
+  bool matches(const PricingInputs &in) const {
+    return underlying == in.underlying && sigma == in.sigma &&
+           expiries == in.volExpiries && moneyness == in.volMoneyness &&
+           vols == in.volMatrix && v0 == in.hestonV0 &&
+           kappa == in.hestonKappa && theta == in.hestonTheta &&
+           xi == in.hestonXi && rho == in.hestonRho;
   }
+};
 
-  const double n = static_cast<double>(paths);
-  const double mean = payoffSum / n;
-  const double numerator = payoffSqSum - n * mean * mean;
-  const double sampleVariance =
-      n > 1 ? std::max(numerator / (n - 1.0), 0.0) : 0.0;
-  standardError = n > 0 ? std::sqrt(sampleVariance / n) : 0.0;
-  return mean;
+constexpr std::size_t kMaxCachedLeverages = 16;
+
+std::shared_ptr<const SlvLeverage> cachedLeverage(const PricingInputs &inputs) {
+  static std::mutex mutex;
+  static std::vector<LeverageEntry> cache;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &entry : cache) {
+      if (entry.matches(inputs)) {
+        return entry.leverage;
+      }
+    }
+  }
+
+  // Calibrated outside the lock; a concurrent duplicate is harmless.
+  const HestonParameters heston{inputs.hestonV0, inputs.hestonKappa,
+                                inputs.hestonTheta, inputs.hestonXi,
+                                inputs.hestonRho};
+  auto leverage =
+      std::make_shared<const SlvLeverage>(makeVolSurface(inputs), heston);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() >= kMaxCachedLeverages) {
+    cache.erase(cache.begin());
+  }
+  cache.push_back(LeverageEntry{inputs.underlying, inputs.sigma,
+                                inputs.volExpiries, inputs.volMoneyness,
+                                inputs.volMatrix, inputs.hestonV0,
+                                inputs.hestonKappa, inputs.hestonTheta,
+                                inputs.hestonXi, inputs.hestonRho, leverage});
+  return leverage;
 }
 } // namespace
 
-PricingResults priceAutocall(const PricingInputs &inputs) {
-  MarketData marketData;
-  marketData.setRiskFreeRate(inputs.rate);
-  // Store spot and sigma in MarketData, even if BS uses its own sigma member
-  // now, this is useful for consistency or if other components need it.
-  marketData.setQuote(inputs.underlying,
-                      MarketData::Quote{inputs.spot, inputs.sigma});
+// Factory helper to create the model with the correct parameters
+std::unique_ptr<PathModelBase> makePathModel(const PricingInputs &inputs) {
+  switch (inputs.modelType) {
+  case ModelType::BlackScholes:
+    // Pass sigma directly to the BS model
+    return std::make_unique<BlackScholesMC>(inputs.sigma);
+  case ModelType::Heston:
+    return std::make_unique<HestonMC>(inputs.hestonV0, inputs.hestonKappa,
+                                      inputs.hestonTheta, inputs.hestonXi,
+                                      inputs.hestonRho);
+  case ModelType::LocalVol:
+    return std::make_unique<LocalVolMC>(makeVolSurface(inputs));
+  case ModelType::Slv:
+    return std::make_unique<SlvMC>(cachedLeverage(inputs));
+  }
+  return std::make_unique<BlackScholesMC>(inputs.sigma);
+}
 
-  // No need for setVolProvider here.
+DiscountCurve makeDiscountCurve(const PricingInputs &inputs) {
+  if (inputs.curveTimes.empty()) {
+    return DiscountCurve(inputs.rate);
+  }
+  return DiscountCurve(inputs.curveTimes, inputs.curveZeroRates);
+}
 
-  std::unique_ptr<StructuredProduct> product;
+std::unique_ptr<MultiAssetPathModel>
+makeBasketModel(const PricingInputs &inputs) {
+  if (inputs.modelType == ModelType::LocalVol ||
+      inputs.modelType == ModelType::Slv) {
+    throw std::runtime_error("Worst-of baskets support Black-Scholes and "
+                             "Heston only");
+  }
+  // The Cholesky factor only reads the lower triangle: an asymmetric matrix
+  // or one off the unit diagonal would be priced as some other matrix.
+  const std::vector<double> &correlation = inputs.basketCorrelation;
+  if (!correlation.empty()) {
+    const std::size_t n = inputs.basket.size();
+    if (correlation.size() != n * n) {
+      throw std::runtime_error("Basket correlation matrix has the wrong size");
+    }
+    for (std::size_t a = 0; a < n; ++a) {
+      if (correlation[a * n + a] != 1.0) {
+        throw std::runtime_error("Basket correlation diagonal must be 1");
+      }
+      for (std::size_t b = 0; b < a; ++b) {
+        const double rho = correlation[a * n + b];
+        if (!(std::abs(rho) <= 1.0)) {
+          throw std::runtime_error(
+              "Basket correlations must lie in [-1, 1]");
+        }
+        if (rho != correlation[b * n + a]) {
+          throw std::runtime_error(
+              "Basket correlation matrix must be symmetric");
+        }
+      }
+    }
+  }
+  if (inputs.modelType == ModelType::Heston) {
+    std::vector<double> v0s;
+    for (const auto &asset : inputs.basket) {
+      v0s.push_back(asset.hestonV0);
+    }
+    return std::make_unique<CorrelatedHestonMC>(
+        std::move(v0s), inputs.hestonKappa, inputs.hestonTheta,
+        inputs.hestonXi, inputs.hestonRho, inputs.basketCorrelation);
+  }
+  std::vector<double> sigmas;
+  for (const auto &asset : inputs.basket) {
+    sigmas.push_back(asset.sigma);
+  }
+  return std::make_unique<CorrelatedBlackScholesMC>(std::move(sigmas),
+                                                    inputs.basketCorrelation);
+}
+
+namespace {
+std::unique_ptr<StructuredProduct>
+makeSingleAssetProduct(const PricingInputs &inputs) {
+  if (!inputs.termSheet.empty()) {
+    return CompiledAutocall::fromTermSheet(
+        inputs.termSheet,
+        TermSheetDefaults{inputs.underlying, inputs.spot, inputs.notional,
+                          inputs.observationTimes,
+                          inputs.protectionMonitoring});
+  }
   if (inputs.productFamily == ProductFamily::Autocall) {
     switch (inputs.autocallType) {
     case AutocallType::Simple:
-      product = std::make_unique<SimpleAutocall>(
+      return std::make_unique<SimpleAutocall>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional, inputs.coupon, inputs.autocallBarrier,
           inputs.protectionBarrier);
-      break;
     case AutocallType::Phoenix:
-      product = std::make_unique<PhoenixAutocall>(
+      return std::make_unique<PhoenixAutocall>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional, inputs.coupon, inputs.autocallBarrier,
           inputs.protectionBarrier, inputs.couponBarrier);
-      break;
     case AutocallType::MemoryPhoenix:
-      product = std::make_unique<MemoryPhoenixAutocall>(
+      return std::make_unique<MemoryPhoenixAutocall>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional, inputs.coupon, inputs.autocallBarrier,
           inputs.protectionBarrier, inputs.couponBarrier);
-      break;
     case AutocallType::StepDown: {
       std::vector<double> schedule = inputs.callBarriers;
       if (schedule.empty()) {
         schedule.assign(inputs.observationTimes.size(), inputs.autocallBarrier);
       }
-      product = std::make_unique<StepDownAutocall>(
+      return std::make_unique<StepDownAutocall>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional, inputs.coupon, schedule, inputs.protectionBarrier);
-      break;
     }
     case AutocallType::Airbag:
-      product = std::make_unique<AirbagAutocall>(
+      return std::make_unique<AirbagAutocall>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional, inputs.coupon, inputs.autocallBarrier,
           inputs.protectionBarrier, inputs.airbagFloor);
-      break;
     }
   } else {
     switch (inputs.cliquetType) {
     case CliquetType::MaxReturn:
-      product = std::make_unique<CliquetMaxReturn>(
+      return std::make_unique<CliquetMaxReturn>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional);
-      break;
     case CliquetType::CappedCoupons:
-      product = std::make_unique<CliquetCappedCoupons>(
+      return std::make_unique<CliquetCappedCoupons>(
           inputs.underlying, inputs.observationTimes, inputs.spot,
           inputs.notional, inputs.cliquetParticipation, inputs.cliquetCap);
-      break;
     }
   }
+  return nullptr;
+}
+} // namespace
 
-  double stdError = 0.0;
-  auto pathModel = makePathModel(inputs);
+std::unique_ptr<StructuredProduct> makeProduct(const PricingInputs &inputs) {
+  auto product = makeSingleAssetProduct(inputs);
+  if (auto *autocall = dynamic_cast<AutocallBase *>(product.get())) {
+    if (inputs.termSheet.empty()) {
+      // A term sheet carries its own monitoring.
+      autocall->setProtectionMonitoring(inputs.protectionMonitoring);
+    }
+    autocall->setBarrierSmoothing(inputs.barrierSmoothing);
+  }
+  if (!product || inputs.basket.empty()) {
+    return product;
+  }
+  if (product->needsBridge()) {
+    throw std::runtime_error("Worst-of: the protection barrier can only be "
+                             "monitored at maturity");
+  }
+  std::vector<std::string> names;
+  std::vector<double> fixings;
+  for (const auto &asset : inputs.basket) {
+    names.push_back(asset.name);
+    fixings.push_back(asset.spot);
+  }
+  return std::make_unique<WorstOfProduct>(std::move(product), std::move(names),
+                                          std::move(fixings), inputs.spot);
+}
 
-  // 1. Base price calculation
-  const double price = runMonteCarlo(*product, marketData, *pathModel,
-                                     inputs.paths, inputs.seed, stdError);
+namespace {
+// Engine other than single-asset Monte Carlo that prices the inputs.
+enum class OffMonteCarlo {
+  None,
+  Basket,
+  IssuerCallable,
+  CliquetAnalytic,
+  Quadrature,
+  BlackScholesPde,
+  HestonPde
+};
 
-  // Bid/Ask
-  const double spread = inputs.notional * inputs.spreadFraction;
-  const double bid = price - spread;
-  const double ask = price + spread;
+OffMonteCarlo offMonteCarloEngine(const PricingInputs &inputs,
+                                  const StructuredProduct &product) {
+  if (dynamic_cast<const WorstOfProduct *>(&product)) {
+    if (inputs.issuerCallable) {
+      throw std::runtime_error("Issuer-callable worst-of notes are not "
+                               "supported");
+    }
+    return OffMonteCarlo::Basket;
+  }
 
-  // 2. Delta calculation (Bump Spot)
-  const double spotBumpSize = inputs.spot * kSpotBumpFraction;
-  double delta = 0.0;
-  if (spotBumpSize > 0.0) {
-    MarketData spotUp = marketData;
-    auto bumpedQuote = spotUp.getQuote(inputs.underlying);
-    bumpedQuote.spot += spotBumpSize;
-    spotUp.setQuote(inputs.underlying, bumpedQuote);
+  if (inputs.issuerCallable) {
+    return OffMonteCarlo::IssuerCallable;
+  }
 
-    double ignore = 0.0;
-    // Note: The model remains the same (parameters unchanged), only MarketData
-    // changes (spot)
-    const double bumpedPrice = runMonteCarlo(*product, spotUp, *pathModel,
-                                             inputs.paths, inputs.seed, ignore);
-    delta = (bumpedPrice - price) / spotBumpSize;
+  const auto *cliquet = dynamic_cast<const CliquetBase *>(&product);
+  if (cliquet && inputs.engineType == EngineType::Auto &&
+      hasAnalyticCliquet(inputs)) {
+    return OffMonteCarlo::CliquetAnalytic;
   }
 
-  // 3. Vega calculation (Bump Volatility)
-  double vega = 0.0;
+  const auto *autocall = dynamic_cast<const AutocallBase *>(&product);
+  if (autocall && inputs.engineType == EngineType::Auto &&
+      inputs.modelType == ModelType::BlackScholes &&
+      inputs.sigma > kVolBumpAdd && AutocallQuadrature::supports(*autocall)) {
+    return OffMonteCarlo::Quadrature;
+  }
 
+  if (autocall && inputs.engineType == EngineType::Pde &&
+      inputs.curveTimes.empty() && !product.needsBridge()) {
+    if (inputs.modelType == ModelType::BlackScholes) {
+      return OffMonteCarlo::BlackScholesPde;
+    }
+    if (inputs.modelType == ModelType::Heston) {
+      return OffMonteCarlo::HestonPde;
+    }
+  }
+  return OffMonteCarlo::None;
+}
+
+// Prices the inputs with the basket, Longstaff-Schwartz, closed-form or PDE
+// engine when one applies; false leaves them to single-asset Monte Carlo.
+bool priceOffMonteCarlo(const PricingInputs &inputs,
+                        const StructuredProduct &product,
+                        PricingResults &results) {
+  switch (offMonteCarloEngine(inputs, product)) {
+  case OffMonteCarlo::None:
+    return false;
+  case OffMonteCarlo::Basket:
+    results =
+        priceBasket(inputs, dynamic_cast<const WorstOfProduct &>(product));
+    break;
+  case OffMonteCarlo::IssuerCallable:
+    results = priceIssuerCallable(inputs, product);
+    break;
+  case OffMonteCarlo::CliquetAnalytic:
+    results = priceCliquetAnalytic(inputs,
+                                   dynamic_cast<const CliquetBase &>(product));
+    break;
+  case OffMonteCarlo::Quadrature:
+    results = priceAutocallQuadrature(
+        inputs, dynamic_cast<const AutocallBase &>(product));
+    break;
+  case OffMonteCarlo::BlackScholesPde:
+    results = priceWithBlackScholesPde(
+        inputs, dynamic_cast<const AutocallBase &>(product));
+    break;
+  case OffMonteCarlo::HestonPde:
+    results =
+        priceWithHestonPde(inputs, dynamic_cast<const AutocallBase &>(product));
+    break;
+  }
+  return true;
+}
+
+// Heston cliquets: the Black-Scholes path on the same spot normals, priced
+// in closed form, is a control variate of the price.
+bool hasControlVariate(const PricingInputs &inputs,
+                       const StructuredProduct &product) {
+  return dynamic_cast<const CliquetBase *>(&product) &&
+         inputs.modelType == ModelType::Heston &&
+         !product.observationTimes().empty();
+}
+
+// Downward vol shift of the vega scenarios: kVolBumpAdd, or zero (one-sided
+// vega) when it would take sigma, an implied vol or the Heston v0 to zero or
+// below.
+double volDownShift(const PricingInputs &inputs) {
   if (inputs.modelType == ModelType::Heston) {
-    // HESTON LOGIC: Shock the model parameters (v0)
-    PricingInputs bumpedInputs = inputs;
-    // Shock the initial variance.
-    // Warning: kVolBumpAdd is intended for volatility (e.g., +1%).
-    // To remain consistent, we can increase v0 significantly or
-    // simply apply the bump as is if the user understands it is a sensitivity
-    // to v0.
-    bumpedInputs.hestonV0 += kVolBumpAdd;
-
-    auto vegaModel = makePathModel(bumpedInputs);
-    double ignore = 0.0;
-    const double vegaPrice = runMonteCarlo(*product, marketData, *vegaModel,
-                                           inputs.paths, inputs.seed, ignore);
-
-    vega = (vegaPrice - price) / kVolBumpAdd;
+    return inputs.hestonV0 > kVolBumpAdd ? kVolBumpAdd : 0.0;
+  }
+  const bool shiftable =
+      inputs.sigma > kVolBumpAdd &&
+      std::all_of(inputs.volMatrix.begin(), inputs.volMatrix.end(),
+                  [](double vol) { return vol > kVolBumpAdd; });
+  return shiftable ? kVolBumpAdd : 0.0;
+}
 
-  } else {
-    // BLACK-SCHOLES LOGIC: Shock the sigma
-    PricingInputs bumpedInputs = inputs;
-    bumpedInputs.sigma += kVolBumpAdd;
+GreeksBumps runnerBumps(const PricingInputs &inputs) {
+  GreeksBumps bumps;
+  bumps.spotFraction = kSpotBumpFraction;
+  bumps.vol = kVolBumpAdd;
+  bumps.volDown = volDownShift(inputs);
+  bumps.rate = kRateBump;
+  return bumps;
+}
+
+// Single-asset Monte Carlo run of a request: the Greeks engine on the
+// request's models and, for Heston cliquets, the control variate.
+struct MonteCarloRun {
+  MonteCarloRun(const PricingInputs &inputs, const StructuredProduct &product);
+
+  const ControlVariate *controlVariate() const {
+    return control.model ? &control : nullptr;
+  }
+
+  std::unique_ptr<PathModelBase> pathModel;
+  std::unique_ptr<PathModelBase> volUpModel;
+  std::unique_ptr<PathModelBase> volDownModel;
+  GreeksEngine engine;
+  double spot{};
+  DiscountCurve curve;
+  std::unique_ptr<HestonControlMC> controlModel;
+  ControlVariate control;
+};
+
+MonteCarloRun::MonteCarloRun(const PricingInputs &inputs,
+                             const StructuredProduct &product)
+    : pathModel(makePathModel(inputs)),
+      volUpModel(makePathModel(volBumpedInputs(inputs, kVolBumpAdd))),
+      volDownModel(
+          makePathModel(volBumpedInputs(inputs, -volDownShift(inputs)))),
+      // Every bumped scenario is evaluated path by path on the draws of the
+      // base price (see GreeksEngine).
+      engine(*pathModel, *volUpModel, *volDownModel, runnerBumps(inputs)),
+      spot(inputs.spot), curve(makeDiscountCurve(inputs)) {
+
+  if (hasControlVariate(inputs, product)) {
+    const auto &cliquet = dynamic_cast<const CliquetBase &>(product);
+    controlModel = std::make_unique<HestonControlMC>(
+        inputs.hestonV0, inputs.hestonKappa, inputs.hestonTheta,
+        TimeGrid(product.observationTimes(), curve));
+    const std::vector<double> &vols = controlModel->intervalVols();
+    if (std::all_of(vols.begin(), vols.end(),
+                    [](double vol) { return vol > 0.0; })) {
+      control.model = controlModel.get();
+      control.mean = CliquetAnalytic(vols).price(cliquet, spot, curve).price;
+    }
+  }
+}
+
+constexpr std::size_t kHistogramBins = 100;
+
+// Histogram over [0, 2 notional); capital loss below the notional paid at
+// maturity.
+PayoffDistribution makePayoffDistribution(const PricingInputs &inputs,
+                                          const StructuredProduct &product,
+                                          const DiscountCurve &curve) {
+  const auto &times = product.observationTimes();
+  const double maturityDiscount =
+      times.empty() ? 1.0 : curve.discountFactor(times.back());
+  return PayoffDistribution(0.0, 2.0 * inputs.notional, kHistogramBins,
+                            inputs.notional * maturityDiscount);
+}
+
+// VaR and ES are read against `mean`, the mean payoff of the paths the
+// distribution holds (see PayoffDistributionSummary).
+PayoffDistributionSummary summarize(const PayoffDistribution &distribution,
+                                    double mean) {
+  PayoffDistributionSummary summary;
+  const TDigest &digest = distribution.digest();
+  if (distribution.count() == 0) {
+    return summary;
+  }
+  for (double level : kPayoffQuantileLevels) {
+    summary.quantiles.push_back(digest.quantile(level));
+  }
+  summary.valueAtRisk95 = mean - digest.quantile(0.05);
+  summary.expectedShortfall95 = mean - digest.meanBelow(0.05);
+  summary.valueAtRisk99 = mean - digest.quantile(0.01);
+  summary.expectedShortfall99 = mean - digest.meanBelow(0.01);
+  summary.capitalLossProbability = distribution.lossProbability();
+  const FixedHistogram &histogram = distribution.histogram();
+  summary.histogramLow = histogram.low();
+  summary.histogramWidth = histogram.width();
+  const double n = static_cast<double>(distribution.count());
+  for (std::uint64_t count : histogram.counts()) {
+    summary.histogram.push_back(static_cast<double>(count) / n);
+  }
+  return summary;
+}
+
+AutocallLifeSummary summarize(const LifeEvents &events,
+                              const std::vector<double> &times) {
+  AutocallLifeSummary summary;
+  double paths = events.maturities();
+  for (double calls : events.calls()) {
+    paths += calls;
+  }
+  if (times.empty() || paths <= 0.0) {
+    return summary;
+  }
+  summary.maturityProbability = events.maturities() / paths;
+  summary.expectedLife = summary.maturityProbability * times.back();
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    const double called = events.calls()[i] / paths;
+    const double coupon = events.coupons()[i] / paths;
+    summary.callProbabilities.push_back(called);
+    summary.couponProbabilities.push_back(coupon);
+    summary.expectedLife += called * times[i];
+    summary.expectedCoupons += coupon;
+  }
+  return summary;
+}
+
+PricingResults fromEstimate(const PricingInputs &inputs,
+                            const GreeksEstimate &greeks) {
+  const double spread = inputs.notional * inputs.spreadFraction;
+  PricingResults results;
+  results.price = greeks.price;
+  results.stdError = greeks.stdError;
+  results.delta = greeks.delta;
+  results.gamma = greeks.gamma;
+  results.vega = greeks.vega;
+  results.vanna = greeks.vanna;
+  results.rho = greeks.rho;
+  results.theta = greeks.theta;
+  results.bid = greeks.price - spread;
+  results.ask = greeks.price + spread;
+  return results;
+}
+} // namespace
+
+bool sharesPaths(const PricingInputs &a, const PricingInputs &b) {
+  if (a.underlying != b.underlying || a.modelType != b.modelType ||
+      a.observationTimes != b.observationTimes || a.paths != b.paths ||
+      a.seed != b.seed) {
+    return false;
+  }
+  const bool sameHeston =
+      a.hestonV0 == b.hestonV0 && a.hestonKappa == b.hestonKappa &&
+      a.hestonTheta == b.hestonTheta && a.hestonXi == b.hestonXi &&
+      a.hestonRho == b.hestonRho;
+  const bool sameSurface = a.sigma == b.sigma &&
+                           a.volExpiries == b.volExpiries &&
+                           a.volMoneyness == b.volMoneyness &&
+                           a.volMatrix == b.volMatrix;
+  switch (a.modelType) {
+  case ModelType::Heston:
+    return sameHeston;
+  case ModelType::LocalVol:
+    return sameSurface;
+  case ModelType::Slv:
+    return sameHeston && sameSurface;
+  case ModelType::BlackScholes:
+    break;
+  }
+  return a.sigma == b.sigma;
+}
 
-    auto vegaModel = makePathModel(bumpedInputs);
+bool sharesSimulation(const PricingInputs &a, const PricingInputs &b) {
+  return sharesPaths(a, b) && a.spot == b.spot && a.rate == b.rate &&
+         a.curveTimes == b.curveTimes && a.curveZeroRates == b.curveZeroRates;
+}
+
+PricingResults priceAutocall(const PricingInputs &inputs) {
+  auto product = makeProduct(inputs);
+  PricingResults direct;
+  if (priceOffMonteCarlo(inputs, *product, direct)) {
+    return direct;
+  }
+
+  const MonteCarloRun run(inputs, *product);
+  const auto &times = product->observationTimes();
+  PayoffDistribution distribution =
+      makePayoffDistribution(inputs, *product, run.curve);
+  LifeEvents events(times.size());
+  const GreeksEstimate greeks =
+      run.engine.run(*product, run.spot, run.curve, inputs.paths, inputs.seed,
+                     run.controlVariate(), {&distribution, &events});
+  PricingResults results = fromEstimate(inputs, greeks);
+  results.distribution = summarize(distribution, greeks.payoffMean);
+  results.life = summarize(events, times);
+  return results;
+}
+
+bool isShardable(const PricingInputs &inputs) {
+  const auto product = makeProduct(inputs);
+  return !product->observationTimes().empty() &&
+         offMonteCarloEngine(inputs, *product) == OffMonteCarlo::None;
+}
+
+struct AutocallBlockRun::State {
+  explicit State(const PricingInputs &in)
+      : inputs(in), product(makeProduct(in)), run(in, *product) {}
+
+  PricingInputs inputs;
+  std::unique_ptr<StructuredProduct> product;
+  MonteCarloRun run;
+};
+
+AutocallBlockRun::AutocallBlockRun(const PricingInputs &inputs)
+    : state_(std::make_unique<State>(inputs)) {}
+
+AutocallBlockRun::~AutocallBlockRun() = default;
+
+std::vector<double> AutocallBlockRun::blockSums(std::size_t firstBlock,
+                                                std::size_t lastBlock) const {
+  const MonteCarloRun &run = state_->run;
+  return run.engine.blockSums(*state_->product, run.spot, run.curve,
+                              state_->inputs.paths, state_->inputs.seed,
+                              firstBlock, lastBlock, run.controlVariate());
+}
+
+PricingResults
+AutocallBlockRun::results(const std::vector<double> &sums) const {
+  const MonteCarloRun &run = state_->run;
+  return fromEstimate(state_->inputs,
+                      run.engine.fromBlockSums(*state_->product, sums,
+                                               run.spot, state_->inputs.paths,
+                                               run.controlVariate()));
+}
+
+std::vector<double> autocallBlockSums(const PricingInputs &inputs,
+                                      std::size_t firstBlock,
+                                      std::size_t lastBlock) {
+  return AutocallBlockRun(inputs).blockSums(firstBlock, lastBlock);
+}
+
+PricingResults autocallFromBlockSums(const PricingInputs &inputs,
+                                     const std::vector<double> &sums) {
+  return AutocallBlockRun(inputs).results(sums);
+}
+
+std::vector<PricingResults>
+priceAutocalls(const std::vector<PricingInputs> &batch) {
+  std::vector<PricingResults> results(batch.size());
+  std::vector<std::unique_ptr<StructuredProduct>> products(batch.size());
+  std::vector<std::size_t> shared; // Plain Monte Carlo requests.
+  std::vector<std::size_t> book;   // Priced by priceAutocallPortfolio.
+  for (std::size_t k = 0; k < batch.size(); ++k) {
+    products[k] = makeProduct(batch[k]);
+    const bool plain = !products[k]->observationTimes().empty() &&
+                       offMonteCarloEngine(batch[k], *products[k]) ==
+                           OffMonteCarlo::None &&
+                       !hasControlVariate(batch[k], *products[k]);
+    (plain ? shared : book).push_back(k);
+  }
+
+  // Requests sharing a simulation, in order of first appearance.
+  while (!shared.empty()) {
+    const PricingInputs &key = batch[shared.front()];
+    std::vector<std::size_t> group, rest;
+    for (std::size_t k : shared) {
+      (sharesSimulation(key, batch[k]) ? group : rest).push_back(k);
+    }
+    shared.swap(rest);
+
+    const auto pathModel = makePathModel(key);
+    const auto volUpModel = makePathModel(volBumpedInputs(key, kVolBumpAdd));
+    const auto volDownModel =
+        makePathModel(volBumpedInputs(key, -volDownShift(key)));
+    const GreeksEngine engine(*pathModel, *volUpModel, *volDownModel,
+                              runnerBumps(key));
+    const DiscountCurve curve = makeDiscountCurve(key);
+    const auto &times = products[group.front()]->observationTimes();
+    std::vector<const StructuredProduct *> members;
+    std::vector<PayoffDistribution> distributions;
+    std::vector<LifeEvents> events(group.size(), LifeEvents(times.size()));
+    distributions.reserve(group.size());
+    for (std::size_t k : group) {
+      members.push_back(products[k].get());
+      distributions.push_back(
+          makePayoffDistribution(batch[k], *products[k], curve));
+    }
+    std::vector<PathStatistics> statistics;
+    for (std::size_t m = 0; m < group.size(); ++m) {
+      statistics.push_back({&distributions[m], &events[m]});
+    }
+    const auto estimates = engine.runBatch(members, key.spot, curve, key.paths,
+                                           key.seed, statistics);
+    for (std::size_t m = 0; m < group.size(); ++m) {
+      PricingResults &result = results[group[m]];
+      result = fromEstimate(batch[group[m]], estimates[m]);
+      result.distribution =
+          summarize(distributions[m], estimates[m].payoffMean);
+      result.life = summarize(events[m], times);
+    }
+  }
+
+  // Other engines and control variates: several of them on the
+  // work-stealing scheduler, a lone one by priceAutocall.
+  if (book.size() == 1) {
+    results[book.front()] = priceAutocall(batch[book.front()]);
+  } else if (!book.empty()) {
+    std::vector<PricingInputs> trades;
+    trades.reserve(book.size());
+    for (std::size_t k : book) {
+      trades.push_back(batch[k]);
+    }
+    std::vector<PricingResults> priced = priceAutocallPortfolio(trades);
+    for (std::size_t i = 0; i < book.size(); ++i) {
+      results[book[i]] = std::move(priced[i]);
+    }
+  }
+  return results;
+}
+
+namespace {
+// Tasks of a portfolio per worker: enough for stealing to even out the
+// errors of the cost model, few enough to keep the chunks long.
+constexpr std::size_t kChunksPerWorker = 8;
+
+// Estimated cost of one Monte Carlo path of a run, in normals drawn plus
+// payoffs evaluated: GreeksEngine builds four paths (base, vol up and down,
+// theta) and evaluates the product under every scenario.
+double monteCarloPathCost(const MonteCarloRun &run,
+                          const StructuredProduct &product) {
+  const TimeGrid grid(product.observationTimes(), run.curve);
+  double cost = 4.0 * static_cast<double>(run.pathModel->normalCount(grid));
+  if (run.controlModel) {
+    cost += static_cast<double>(run.controlModel->normalCount(grid));
+  }
+  const double dates = static_cast<double>(grid.times.size());
+  return cost + 12.0 * dates;
+}
 
-    // To ensure consistency, we also update MarketData
-    // (although our new BSMC uses the internal sigma)
-    MarketData volUp = marketData;
-    auto q = volUp.getQuote(inputs.underlying);
-    q.sigma += kVolBumpAdd;
-    volUp.setQuote(inputs.underlying, q);
+// Rough cost of a request priced by another engine, in the units of
+// monteCarloPathCost: the basket and Longstaff-Schwartz engines simulate
+// inputs.paths paths, the closed forms and PDEs cost about one path block.
+double offMonteCarloCost(const PricingInputs &inputs,
+                         const StructuredProduct &product) {
+  const double dates =
+      static_cast<double>(std::max<std::size_t>(
+          1, product.observationTimes().size()));
+  const double paths = static_cast<double>(inputs.paths);
+  switch (offMonteCarloEngine(inputs, product)) {
+  case OffMonteCarlo::Basket: {
+    const double assets = static_cast<double>(inputs.basket.size());
+    return paths * dates * assets * (4.0 + 2.0 * assets);
+  }
+  case OffMonteCarlo::IssuerCallable:
+    return 8.0 * paths * dates;
+  case OffMonteCarlo::None:
+  case OffMonteCarlo::CliquetAnalytic:
+  case OffMonteCarlo::Quadrature:
+  case OffMonteCarlo::BlackScholesPde:
+  case OffMonteCarlo::HestonPde:
+    break;
+  }
+  return static_cast<double>(kPathsPerBlock) * dates;
+}
 
-    double ignore = 0.0;
-    const double vegaPrice = runMonteCarlo(*product, volUp, *vegaModel,
-                                           inputs.paths, inputs.seed, ignore);
+void addStats(SchedulerStats &total, const SchedulerStats &phase) {
+  total.wallSeconds += phase.wallSeconds;
+  if (total.workers.size() < phase.workers.size()) {
+    total.workers.resize(phase.workers.size());
+  }
+  for (std::size_t w = 0; w < phase.workers.size(); ++w) {
+    total.workers[w].tasks += phase.workers[w].tasks;
+    total.workers[w].stolen += phase.workers[w].stolen;
+    total.workers[w].busySeconds += phase.workers[w].busySeconds;
+    total.workers[w].cost += phase.workers[w].cost;
+  }
+}
+} // namespace
 
-    vega = (vegaPrice - price) / kVolBumpAdd;
+std::vector<PricingResults>
+priceAutocallPortfolio(const std::vector<PricingInputs> &trades,
+                       SchedulerStats *stats) {
+  const std::size_t count = trades.size();
+  std::vector<PricingResults> results(count);
+  std::vector<std::unique_ptr<StructuredProduct>> products(count);
+  std::vector<std::size_t> monteCarlo, direct;
+  for (std::size_t k = 0; k < count; ++k) {
+    products[k] = makeProduct(trades[k]);
+    const bool split = !products[k]->observationTimes().empty() &&
+                       offMonteCarloEngine(trades[k], *products[k]) ==
+                           OffMonteCarlo::None;
+    (split ? monteCarlo : direct).push_back(k);
   }
-  return {price, stdError, delta, vega, bid, ask};
-}
\ No newline at end of file
+
+  // Models and control variates (SLV leverage calibrations, Heston
+  // analytics) are built concurrently too.
+  SchedulerStats total;
+  std::vector<std::unique_ptr<MonteCarloRun>> runs(count);
+  addStats(total, runWorkStealing(
+                      std::vector<double>(monteCarlo.size(), 1.0),
+                      [&](std::size_t m) {
+                        const std::size_t k = monteCarlo[m];
+                        runs[k] = std::make_unique<MonteCarloRun>(
+                            trades[k], *products[k]);
+                      }));
+
+  // (trade, block range) tasks of about equal estimated cost, and the other
+  // requests whole.
+  struct Task {
+    std::size_t trade;
+    std::size_t firstBlock;
+    std::size_t lastBlock;
+  };
+  std::vector<Task> tasks;
+  std::vector<double> costs;
+  std::vector<double> blockCosts(count);
+  double monteCarloCost = 0.0;
+  for (std::size_t k : monteCarlo) {
+    blockCosts[k] = static_cast<double>(kPathsPerBlock) *
+                    monteCarloPathCost(*runs[k], *products[k]);
+    monteCarloCost +=
+        blockCosts[k] * static_cast<double>(pathBlockCount(trades[k].paths));
+  }
+  const double targetCost =
+      monteCarloCost / static_cast<double>(workerCount() * kChunksPerWorker);
+  std::vector<std::vector<double>> sums(count);
+  // Payoff distribution and life events of each trade, and of each of its
+  // blocks: merged block by block in order like priceAutocall does, so they
+  // do not depend on the task boundaries (hence on the thread count).
+  std::vector<std::unique_ptr<PayoffDistribution>> distributions(count);
+  std::vector<std::vector<PayoffDistribution>> blockDistributions(count);
+  std::vector<std::vector<LifeEvents>> blockEvents(count);
+  for (std::size_t k : monteCarlo) {
+    const std::size_t blocks = pathBlockCount(trades[k].paths);
+    const std::size_t chunk = std::max<std::size_t>(
+        1, static_cast<std::size_t>(targetCost / blockCosts[k]));
+    const std::size_t dates = products[k]->observationTimes().size();
+    sums[k].resize(blocks * GreeksEngine::kBlockSumValues);
+    distributions[k] = std::make_unique<PayoffDistribution>(
+        makePayoffDistribution(trades[k], *products[k], runs[k]->curve));
+    blockDistributions[k].assign(blocks, distributions[k]->emptyCopy());
+    blockEvents[k].assign(blocks, LifeEvents(dates));
+    for (std::size_t first = 0; first < blocks; first += chunk) {
+      const std::size_t last = std::min(blocks, first + chunk);
+      tasks.push_back({k, first, last});
+      costs.push_back(blockCosts[k] * static_cast<double>(last - first));
+    }
+  }
+  for (std::size_t k : direct) {
+    tasks.push_back({k, 0, 0});
+    costs.push_back(offMonteCarloCost(trades[k], *products[k]));
+  }
+
+  addStats(total, runWorkStealing(costs, [&](std::size_t t) {
+    const Task &task = tasks[t];
+    const std::size_t k = task.trade;
+    if (!runs[k]) {
+      results[k] = priceAutocall(trades[k]);
+      return;
+    }
+    // A block range is one worker's share of the book: its loop over the
+    // blocks stays on that worker. The direct requests (baskets,
+    // Longstaff-Schwartz, SLV calibrations) keep their parallel loops and
+    // borrow the pool threads left idle.
+    const InlineParallelLoops inlineLoops;
+    const MonteCarloRun &run = *runs[k];
+    for (std::size_t b = task.firstBlock; b < task.lastBlock; ++b) {
+      const std::vector<double> block = run.engine.blockSums(
+          *products[k], run.spot, run.curve, trades[k].paths, trades[k].seed,
+          b, b + 1, run.controlVariate(),
+          {&blockDistributions[k][b], &blockEvents[k][b]});
+      std::copy(block.begin(), block.end(),
+                sums[k].begin() + b * GreeksEngine::kBlockSumValues);
+    }
+  }));
+
+  std::vector<LifeEvents> events(count);
+  for (std::size_t k : monteCarlo) {
+    events[k] = LifeEvents(products[k]->observationTimes().size());
+    for (std::size_t b = 0; b < blockEvents[k].size(); ++b) {
+      distributions[k]->merge(blockDistributions[k][b]);
+      events[k].merge(blockEvents[k][b]);
+    }
+    blockDistributions[k].clear();
+  }
+  for (std::size_t k : monteCarlo) {
+    const MonteCarloRun &run = *runs[k];
+    const GreeksEstimate estimate =
+        run.engine.fromBlockSums(*products[k], sums[k], run.spot,
+                                 trades[k].paths, run.controlVariate());
+    results[k] = fromEstimate(trades[k], estimate);
+    results[k].distribution =
+        summarize(*distributions[k], estimate.payoffMean);
+    results[k].life = summarize(events[k], products[k]->observationTimes());
+  }
+  if (stats) {
+    *stats = std::move(total);
+  }
+  return results;
+}
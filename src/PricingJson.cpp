@@ -0,0 +1,339 @@
+#include "PricingJson.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+[[noreturn]] void fail(const std::string &what) {
+  throw std::runtime_error("PricingJson: " + what);
+}
+
+double number(const JsonValue &value, const std::string &name) {
+  if (!value.isNumber()) {
+    fail(name + " must be a number");
+  }
+  return value.asNumber();
+}
+
+std::size_t count(const JsonValue &value, const std::string &name) {
+  const double x = number(value, name);
+  if (!(x >= 0.0) || x != std::floor(x) || x > 9.0e15) {
+    fail(name + " must be a non-negative integer");
+  }
+  return static_cast<std::size_t>(x);
+}
+
+bool flag(const JsonValue &value, const std::string &name) {
+  if (value.type() != JsonValue::Type::Bool) {
+    fail(name + " must be true or false");
+  }
+  return value.asBool();
+}
+
+const std::string &text(const JsonValue &value, const std::string &name) {
+  if (value.type() != JsonValue::Type::String) {
+    fail(name + " must be a string");
+  }
+  return value.asString();
+}
+
+std::vector<double> numbers(const JsonValue &value, const std::string &name) {
+  if (!value.isArray()) {
+    fail(name + " must be an array of numbers");
+  }
+  std::vector<double> out;
+  out.reserve(value.asArray().size());
+  for (const auto &item : value.asArray()) {
+    out.push_back(number(item, name + " entries"));
+  }
+  return out;
+}
+
+// Index of `value` among `names`, the enumerators in declaration order.
+template <class Enum, std::size_t N>
+Enum enumerator(const JsonValue &value, const std::string &name,
+                const char *const (&names)[N]) {
+  const std::string &word = text(value, name);
+  for (std::size_t k = 0; k < N; ++k) {
+    if (word == names[k]) {
+      return static_cast<Enum>(k);
+    }
+  }
+  fail("unknown " + name + " \"" + word + "\"");
+}
+
+constexpr const char *kFamilies[] = {"autocall", "cliquet"};
+constexpr const char *kAutocallTypes[] = {"simple", "phoenix", "memoryPhoenix",
+                                          "stepDown", "airbag"};
+constexpr const char *kCliquetTypes[] = {"maxReturn", "cappedCoupons"};
+constexpr const char *kModels[] = {"blackScholes", "heston", "localVol",
+                                   "slv"};
+constexpr const char *kEngines[] = {"monteCarlo", "pde", "auto"};
+constexpr const char *kMonitorings[] = {"maturity", "daily", "continuous"};
+
+BasketAsset basketAsset(const JsonValue &value) {
+  if (!value.isObject()) {
+    fail("basket entries must be objects");
+  }
+  BasketAsset asset;
+  for (const auto &member : value.asObject()) {
+    const std::string &key = member.first;
+    const JsonValue &v = member.second;
+    if (key == "name") {
+      asset.name = text(v, "basket.name");
+    } else if (key == "spot") {
+      asset.spot = number(v, "basket.spot");
+    } else if (key == "sigma") {
+      asset.sigma = number(v, "basket.sigma");
+    } else if (key == "hestonV0") {
+      asset.hestonV0 = number(v, "basket.hestonV0");
+    } else {
+      fail("unknown member basket." + key);
+    }
+  }
+  return asset;
+}
+} // namespace
+
+PricingInputs pricingInputsFromJson(const JsonValue &request,
+                                    const PricingInputs &defaults) {
+  if (!request.isObject()) {
+    fail("a request must be an object");
+  }
+  PricingInputs in = defaults;
+  // Scalar members, by name.
+  const std::pair<const char *, double *> reals[] = {
+      {"spot", &in.spot},
+      {"sigma", &in.sigma},
+      {"rate", &in.rate},
+      {"notional", &in.notional},
+      {"coupon", &in.coupon},
+      {"autocallBarrier", &in.autocallBarrier},
+      {"protectionBarrier", &in.protectionBarrier},
+      {"spreadFraction", &in.spreadFraction},
+      {"couponBarrier", &in.couponBarrier},
+      {"airbagFloor", &in.airbagFloor},
+      {"barrierSmoothing", &in.barrierSmoothing},
+      {"hestonV0", &in.hestonV0},
+      {"hestonKappa", &in.hestonKappa},
+      {"hestonTheta", &in.hestonTheta},
+      {"hestonXi", &in.hestonXi},
+      {"hestonRho", &in.hestonRho},
+      {"cliquetParticipation", &in.cliquetParticipation},
+      {"cliquetCap", &in.cliquetCap}};
+  const std::pair<const char *, std::vector<double> *> arrays[] = {
+      {"curveTimes", &in.curveTimes},
+      {"curveZeroRates", &in.curveZeroRates},
+      {"observationTimes", &in.observationTimes},
+      {"callBarriers", &in.callBarriers},
+      {"volExpiries", &in.volExpiries},
+      {"volMoneyness", &in.volMoneyness},
+      {"volMatrix", &in.volMatrix},
+      {"basketCorrelation", &in.basketCorrelation}};
+  const std::pair<const char *, std::size_t *> counts[] = {
+      {"paths", &in.paths},
+      {"issuerCallFirstDate", &in.issuerCallFirstDate},
+      {"lsmRegressionPaths", &in.lsmRegressionPaths}};
+
+  for (const auto &member : request.asObject()) {
+    const std::string &key = member.first;
+    const JsonValue &v = member.second;
+    bool known = false;
+    for (const auto &real : reals) {
+      if (key == real.first) {
+        *real.second = number(v, key);
+        known = true;
+      }
+    }
+    for (const auto &array : arrays) {
+      if (key == array.first) {
+        *array.second = numbers(v, key);
+        known = true;
+      }
+    }
+    for (const auto &c : counts) {
+      if (key == c.first) {
+        *c.second = count(v, key);
+        known = true;
+      }
+    }
+    if (known) {
+      continue;
+    }
+    if (key == "underlying") {
+      in.underlying = text(v, key);
+    } else if (key == "seed") {
+      const std::size_t seed = count(v, key);
+      if (seed > 0xFFFFFFFFu) {
+        fail("seed must fit in 32 bits");
+      }
+      in.seed = static_cast<unsigned int>(seed);
+    } else if (key == "productFamily") {
+      in.productFamily = enumerator<ProductFamily>(v, key, kFamilies);
+    } else if (key == "autocallType") {
+      in.autocallType = enumerator<AutocallType>(v, key, kAutocallTypes);
+    } else if (key == "cliquetType") {
+      in.cliquetType = enumerator<CliquetType>(v, key, kCliquetTypes);
+    } else if (key == "modelType") {
+      in.modelType = enumerator<ModelType>(v, key, kModels);
+    } else if (key == "engineType") {
+      in.engineType = enumerator<EngineType>(v, key, kEngines);
+    } else if (key == "protectionMonitoring") {
+      in.protectionMonitoring =
+          enumerator<BarrierMonitoring>(v, key, kMonitorings);
+    } else if (key == "issuerCallable") {
+      in.issuerCallable = flag(v, key);
+    } else if (key == "basket") {
+      if (!v.isArray()) {
+        fail("basket must be an array");
+      }
+      in.basket.clear();
+      for (const auto &item : v.asArray()) {
+        in.basket.push_back(basketAsset(item));
+      }
+    } else if (key == "termSheet") {
+      // Parsed (and validated) by CompiledAutocall::fromTermSheet.
+      in.termSheet = v.isObject() ? v.dump() : text(v, key);
+    } else {
+      fail("unknown member " + key);
+    }
+  }
+  return in;
+}
+
+JsonValue pricingInputsToJson(const PricingInputs &inputs) {
+  auto numbers = [](const std::vector<double> &values) {
+    std::vector<JsonValue> items;
+    items.reserve(values.size());
+    for (double value : values) {
+      items.push_back(JsonValue::number(value));
+    }
+    return JsonValue::array(std::move(items));
+  };
+  auto count = [](std::size_t value) {
+    return JsonValue::number(static_cast<double>(value));
+  };
+  auto name = [](const auto &names, auto value) {
+    return JsonValue::string(names[static_cast<std::size_t>(value)]);
+  };
+  std::vector<JsonValue> basket;
+  for (const auto &asset : inputs.basket) {
+    basket.push_back(JsonValue::object(
+        {{"name", JsonValue::string(asset.name)},
+         {"spot", JsonValue::number(asset.spot)},
+         {"sigma", JsonValue::number(asset.sigma)},
+         {"hestonV0", JsonValue::number(asset.hestonV0)}}));
+  }
+  return JsonValue::object({
+      {"underlying", JsonValue::string(inputs.underlying)},
+      {"spot", JsonValue::number(inputs.spot)},
+      {"sigma", JsonValue::number(inputs.sigma)},
+      {"rate", JsonValue::number(inputs.rate)},
+      {"curveTimes", numbers(inputs.curveTimes)},
+      {"curveZeroRates", numbers(inputs.curveZeroRates)},
+      {"notional", JsonValue::number(inputs.notional)},
+      {"coupon", JsonValue::number(inputs.coupon)},
+      {"autocallBarrier", JsonValue::number(inputs.autocallBarrier)},
+      {"protectionBarrier", JsonValue::number(inputs.protectionBarrier)},
+      {"observationTimes", numbers(inputs.observationTimes)},
+      {"paths", count(inputs.paths)},
+      {"seed", count(inputs.seed)},
+      {"spreadFraction", JsonValue::number(inputs.spreadFraction)},
+      {"productFamily", name(kFamilies, inputs.productFamily)},
+      {"autocallType", name(kAutocallTypes, inputs.autocallType)},
+      {"cliquetType", name(kCliquetTypes, inputs.cliquetType)},
+      {"modelType", name(kModels, inputs.modelType)},
+      {"engineType", name(kEngines, inputs.engineType)},
+      {"couponBarrier", JsonValue::number(inputs.couponBarrier)},
+      {"callBarriers", numbers(inputs.callBarriers)},
+      {"airbagFloor", JsonValue::number(inputs.airbagFloor)},
+      {"protectionMonitoring",
+       name(kMonitorings, inputs.protectionMonitoring)},
+      {"barrierSmoothing", JsonValue::number(inputs.barrierSmoothing)},
+      {"hestonV0", JsonValue::number(inputs.hestonV0)},
+      {"hestonKappa", JsonValue::number(inputs.hestonKappa)},
+      {"hestonTheta", JsonValue::number(inputs.hestonTheta)},
+      {"hestonXi", JsonValue::number(inputs.hestonXi)},
+      {"hestonRho", JsonValue::number(inputs.hestonRho)},
+      {"volExpiries", numbers(inputs.volExpiries)},
+      {"volMoneyness", numbers(inputs.volMoneyness)},
+      {"volMatrix", numbers(inputs.volMatrix)},
+      {"cliquetParticipation", JsonValue::number(inputs.cliquetParticipation)},
+      {"cliquetCap", JsonValue::number(inputs.cliquetCap)},
+      {"basket", JsonValue::array(std::move(basket))},
+      {"basketCorrelation", numbers(inputs.basketCorrelation)},
+      {"issuerCallable", JsonValue::boolean(inputs.issuerCallable)},
+      {"issuerCallFirstDate", count(inputs.issuerCallFirstDate)},
+      {"lsmRegressionPaths", count(inputs.lsmRegressionPaths)},
+      {"termSheet", JsonValue::string(inputs.termSheet)}});
+}
+
+JsonValue pricingResultsToJson(const PricingResults &results) {
+  std::vector<JsonValue::Member> members{
+      {"price", JsonValue::number(results.price)},
+      {"stdError", JsonValue::number(results.stdError)},
+      {"delta", JsonValue::number(results.delta)},
+      {"gamma", JsonValue::number(results.gamma)},
+      {"vega", JsonValue::number(results.vega)},
+      {"vanna", JsonValue::number(results.vanna)},
+      {"rho", JsonValue::number(results.rho)},
+      {"theta", JsonValue::number(results.theta)},
+      {"bid", JsonValue::number(results.bid)},
+      {"ask", JsonValue::number(results.ask)}};
+  if (!results.assetDeltas.empty()) {
+    std::vector<JsonValue> deltas;
+    for (double delta : results.assetDeltas) {
+      deltas.push_back(JsonValue::number(delta));
+    }
+    members.emplace_back("assetDeltas", JsonValue::array(std::move(deltas)));
+  }
+  const PayoffDistributionSummary &distribution = results.distribution;
+  if (!distribution.quantiles.empty()) {
+    std::vector<JsonValue> quantiles;
+    for (std::size_t k = 0; k < distribution.quantiles.size(); ++k) {
+      quantiles.push_back(JsonValue::object(
+          {{"level", JsonValue::number(kPayoffQuantileLevels[k])},
+           {"payoff", JsonValue::number(distribution.quantiles[k])}}));
+    }
+    std::vector<JsonValue> histogram;
+    for (double fraction : distribution.histogram) {
+      histogram.push_back(JsonValue::number(fraction));
+    }
+    members.emplace_back(
+        "distribution",
+        JsonValue::object(
+            {{"quantiles", JsonValue::array(std::move(quantiles))},
+             {"valueAtRisk95", JsonValue::number(distribution.valueAtRisk95)},
+             {"expectedShortfall95",
+              JsonValue::number(distribution.expectedShortfall95)},
+             {"valueAtRisk99", JsonValue::number(distribution.valueAtRisk99)},
+             {"expectedShortfall99",
+              JsonValue::number(distribution.expectedShortfall99)},
+             {"capitalLossProbability",
+              JsonValue::number(distribution.capitalLossProbability)},
+             {"histogramLow", JsonValue::number(distribution.histogramLow)},
+             {"histogramWidth", JsonValue::number(distribution.histogramWidth)},
+             {"histogram", JsonValue::array(std::move(histogram))}}));
+  }
+  const AutocallLifeSummary &life = results.life;
+  if (!life.callProbabilities.empty()) {
+    std::vector<JsonValue> calls, coupons;
+    for (std::size_t i = 0; i < life.callProbabilities.size(); ++i) {
+      calls.push_back(JsonValue::number(life.callProbabilities[i]));
+      coupons.push_back(JsonValue::number(life.couponProbabilities[i]));
+    }
+    members.emplace_back(
+        "life",
+        JsonValue::object(
+            {{"callProbabilities", JsonValue::array(std::move(calls))},
+             {"maturityProbability",
+              JsonValue::number(life.maturityProbability)},
+             {"couponProbabilities", JsonValue::array(std::move(coupons))},
+             {"expectedLife", JsonValue::number(life.expectedLife)},
+             {"expectedCoupons", JsonValue::number(life.expectedCoupons)}}));
+  }
+  return JsonValue::object(std::move(members));
+}
@@ -0,0 +1,288 @@
+#include "PricingServer.hpp"
+
+#include "Json.hpp"
+#include "Parallel.hpp"
+#include "PricingJson.hpp"
+#include "StreamSocket.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+std::string errorResponse(const std::string &message) {
+  return JsonValue::object({{"error", JsonValue::string(message)}}).dump();
+}
+} // namespace
+
+void LatencyHistogram::record(double seconds) {
+  const double micros = seconds * 1.0e6;
+  std::size_t bucket = 0;
+  if (micros > 1.0) {
+    const double position = std::floor(std::log2(micros) * kBucketsPerDoubling);
+    bucket = static_cast<std::size_t>(
+        std::min(position, static_cast<double>(kBuckets - 1)));
+  }
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::quantile(double q) const {
+  const std::uint64_t total = count_.load();
+  if (total == 0) {
+    return 0.0;
+  }
+  const double clamped = std::min(std::max(q, 0.0), 1.0);
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(std::ceil(clamped * total)));
+  std::uint64_t seen = 0;
+  std::size_t bucket = 0;
+  for (; bucket + 1 < kBuckets; ++bucket) {
+    seen += buckets_[bucket].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      break;
+    }
+  }
+  // Geometric middle of [2^(b/16), 2^((b+1)/16)) microseconds.
+  return 1.0e-6 *
+         std::exp2((static_cast<double>(bucket) + 0.5) / kBucketsPerDoubling);
+}
+
+PricingServer::PricingServer(ServerOptions options)
+    : options_(std::move(options)) {
+  if (options_.maxBatch == 0) {
+    throw std::runtime_error("PricingServer: maxBatch must be positive");
+  }
+  listenFd_ = listenStream(options_.unixPath.empty()
+                               ? "127.0.0.1:" + std::to_string(options_.tcpPort)
+                               : options_.unixPath);
+  const std::size_t workers =
+      options_.workers > 0 ? options_.workers : workerCount();
+  dispatcher_ = std::thread(&PricingServer::dispatchLoop, this);
+  workers_.reserve(workers);
+  for (std::size_t w = 0; w < workers; ++w) {
+    workers_.emplace_back(&PricingServer::workLoop, this);
+  }
+}
+
+PricingServer::~PricingServer() {
+  stop();
+  // Connections first: a request they already queued is still priced.
+  for (auto &connection : connections_) {
+    if (connection.thread.joinable()) {
+      connection.thread.join();
+    }
+  }
+  dispatcher_.join();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  ::close(listenFd_);
+  if (!options_.unixPath.empty()) {
+    ::unlink(options_.unixPath.c_str());
+  }
+}
+
+void PricingServer::serve() {
+  while (!stopping_) {
+    const int fd = ::accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (stopping_) {
+        break;
+      }
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      throw std::runtime_error(std::string("PricingServer: accept: ") +
+                               std::strerror(errno));
+    }
+    std::lock_guard<std::mutex> lock(connectionMutex_);
+    // Reap the connections closed since the last accept.
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      if (it->done) {
+        it->thread.join();
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (stopping_) {
+      ::close(fd);
+      break;
+    }
+    connections_.push_back(Connection{fd, false, {}});
+    Connection &connection = connections_.back();
+    connection.thread =
+        std::thread(&PricingServer::serveConnection, this, std::ref(connection));
+  }
+}
+
+void PricingServer::stop() {
+  if (stopping_.exchange(true)) {
+    return;
+  }
+  // Wakes the blocked accept() (close alone does not on Linux).
+  ::shutdown(listenFd_, SHUT_RDWR);
+  {
+    std::lock_guard<std::mutex> lock(connectionMutex_);
+    for (const auto &connection : connections_) {
+      if (!connection.done) {
+        ::shutdown(connection.fd, SHUT_RDWR);
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+  }
+  queueReady_.notify_all();
+}
+
+PricingResults PricingServer::price(const PricingInputs &inputs) {
+  if (inputs.paths > options_.maxPaths ||
+      inputs.lsmRegressionPaths > options_.maxPaths) {
+    throw std::runtime_error("PricingServer: more than " +
+                             std::to_string(options_.maxPaths) +
+                             " paths per request");
+  }
+  std::future<PricingResults> result;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    // Checked under the queue lock: the dispatcher only exits on an empty
+    // queue once stopping_ is set, so no accepted request is left behind.
+    if (stopping_) {
+      throw std::runtime_error("PricingServer: server is stopping");
+    }
+    queue_.push_back(Pending{inputs, {}});
+    result = queue_.back().result.get_future();
+  }
+  queueReady_.notify_all();
+  return result.get();
+}
+
+std::string PricingServer::respond(const std::string &request) {
+  const auto start = std::chrono::steady_clock::now();
+  std::string response;
+  try {
+    const JsonValue document = JsonValue::parse(request);
+    if (const JsonValue *command = document.find("command")) {
+      if (command->type() != JsonValue::Type::String ||
+          command->asString() != "stats") {
+        return errorResponse("PricingServer: unknown command");
+      }
+      return JsonValue::object(
+                 {{"requests",
+                   JsonValue::number(static_cast<double>(latency_.count()))},
+                  {"p50Ms", JsonValue::number(1.0e3 * latency_.quantile(0.5))},
+                  {"p99Ms",
+                   JsonValue::number(1.0e3 * latency_.quantile(0.99))}})
+          .dump();
+    }
+    response = pricingResultsToJson(price(pricingInputsFromJson(document)))
+                   .dump();
+  } catch (const std::exception &ex) {
+    response = errorResponse(ex.what());
+  }
+  latency_.record(std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count());
+  return response;
+}
+
+void PricingServer::dispatchLoop() {
+  std::unique_lock<std::mutex> lock(queueMutex_);
+  for (;;) {
+    queueReady_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      break;
+    }
+    // Coalescing window, opened by the first request of the batch.
+    const auto deadline =
+        std::chrono::steady_clock::now() + options_.batchWindow;
+    queueReady_.wait_until(lock, deadline, [&] {
+      return stopping_ || queue_.size() >= options_.maxBatch;
+    });
+
+    const std::size_t taken = std::min(queue_.size(), options_.maxBatch);
+    std::vector<Batch> parts;
+    for (std::size_t k = 0; k < taken; ++k) {
+      Pending pending = std::move(queue_.front());
+      queue_.pop_front();
+      auto part = std::find_if(parts.begin(), parts.end(), [&](const Batch &b) {
+        return sharesSimulation(b.front().inputs, pending.inputs);
+      });
+      if (part == parts.end()) {
+        parts.emplace_back();
+        part = parts.end() - 1;
+      }
+      part->push_back(std::move(pending));
+    }
+    for (auto &part : parts) {
+      batches_.push_back(std::move(part));
+    }
+    batchReady_.notify_all();
+  }
+  drained_ = true;
+  batchReady_.notify_all();
+}
+
+void PricingServer::workLoop() {
+  std::vector<PricingInputs> inputs;
+  for (;;) {
+    Batch batch;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex_);
+      batchReady_.wait(lock, [&] { return drained_ || !batches_.empty(); });
+      if (batches_.empty()) {
+        return;
+      }
+      batch = std::move(batches_.front());
+      batches_.pop_front();
+    }
+    inputs.clear();
+    for (auto &pending : batch) {
+      inputs.push_back(std::move(pending.inputs));
+    }
+    try {
+      std::vector<PricingResults> results = priceAutocalls(inputs);
+      for (std::size_t k = 0; k < batch.size(); ++k) {
+        batch[k].result.set_value(std::move(results[k]));
+      }
+    } catch (...) {
+      // One invalid request must not fail the others: price them one by
+      // one, each promise getting its own result or error.
+      for (std::size_t k = 0; k < batch.size(); ++k) {
+        try {
+          batch[k].result.set_value(priceAutocall(inputs[k]));
+        } catch (...) {
+          batch[k].result.set_exception(std::current_exception());
+        }
+      }
+    }
+  }
+}
+
+void PricingServer::serveConnection(Connection &connection) {
+  const int fd = connection.fd;
+  // Reused for every frame of the connection.
+  std::string request;
+  std::string frame;
+  for (;;) {
+    const FrameRead read = readFrame(fd, request, options_.maxFrameBytes);
+    if (read == FrameRead::TooLarge) {
+      writeFrame(fd, errorResponse("PricingServer: frame too large"), frame);
+    }
+    if (read != FrameRead::Ok || !writeFrame(fd, respond(request), frame)) {
+      break;
+    }
+  }
+  std::lock_guard<std::mutex> lock(connectionMutex_);
+  ::close(fd);
+  connection.done = true;
+}
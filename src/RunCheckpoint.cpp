@@ -0,0 +1,222 @@
+#include "RunCheckpoint.hpp"
+
+#include "GreeksEngine.hpp"
+#include "Parallel.hpp"
+#include "PathModel.hpp"
+#include "PricingJson.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char kMagic[8] = {'P', 'C', 'K', 'P', 'T', '\0', '\0', '\1'};
+// Version 2: the squares of version 1 became centred moments.
+constexpr std::uint32_t kVersion = 2;
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t valuesPerBlock;
+  std::uint64_t fingerprint;
+  std::uint64_t totalBlocks;
+  std::uint64_t completedBlocks;
+};
+static_assert(sizeof(FileHeader) % 8 == 0, "sums must stay 8-byte aligned");
+
+// Blocks simulated between two checks of the checkpoint interval: enough to
+// keep every thread of parallelFor busy.
+constexpr std::size_t kChunkBlocksPerThread = 16;
+
+std::uint64_t fnv1a(const char *data, std::size_t size,
+                    std::uint64_t hash = 14695981039346656037ull) {
+  for (std::size_t k = 0; k < size; ++k) {
+    hash ^= static_cast<unsigned char>(data[k]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+[[noreturn]] void failErrno(const std::string &what) {
+  throw std::runtime_error("RunCheckpoint: " + what + ": " +
+                           std::strerror(errno));
+}
+
+void writeAll(int fd, const char *data, std::size_t size,
+              const std::string &path) {
+  while (size > 0) {
+    const ssize_t written = ::write(fd, data, size);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      failErrno("write " + path);
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+}
+} // namespace
+
+std::size_t RunCheckpoint::completedBlocks() const {
+  return sums.size() / GreeksEngine::kBlockSumValues;
+}
+
+void writeCheckpoint(const std::string &path, const RunCheckpoint &checkpoint) {
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.valuesPerBlock = GreeksEngine::kBlockSumValues;
+  header.fingerprint = checkpoint.fingerprint;
+  header.totalBlocks = checkpoint.totalBlocks;
+  header.completedBlocks = checkpoint.completedBlocks();
+  const char *headerBytes = reinterpret_cast<const char *>(&header);
+  const char *sumBytes = reinterpret_cast<const char *>(checkpoint.sums.data());
+  const std::size_t sumSize = checkpoint.sums.size() * sizeof(double);
+  const std::uint64_t checksum =
+      fnv1a(sumBytes, sumSize, fnv1a(headerBytes, sizeof(header)));
+
+  const std::string temporary = path + ".tmp";
+  const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    failErrno("cannot open " + temporary);
+  }
+  writeAll(fd, headerBytes, sizeof(header), temporary);
+  writeAll(fd, sumBytes, sumSize, temporary);
+  writeAll(fd, reinterpret_cast<const char *>(&checksum), sizeof(checksum),
+           temporary);
+  if (::fsync(fd) != 0) {
+    const int error = errno;
+    ::close(fd);
+    errno = error;
+    failErrno("fsync " + temporary);
+  }
+  if (::close(fd) != 0) {
+    failErrno("close " + temporary);
+  }
+  if (::rename(temporary.c_str(), path.c_str()) != 0) {
+    failErrno("rename " + temporary);
+  }
+}
+
+bool readCheckpoint(const std::string &path, RunCheckpoint &checkpoint) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    failErrno("cannot open " + path);
+  }
+  std::string bytes;
+  char buffer[1 << 16];
+  for (;;) {
+    const ssize_t got = ::read(fd, buffer, sizeof(buffer));
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got < 0) {
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      failErrno("read " + path);
+    }
+    if (got == 0) {
+      break;
+    }
+    bytes.append(buffer, static_cast<std::size_t>(got));
+  }
+  ::close(fd);
+
+  FileHeader header{};
+  if (bytes.size() < sizeof(header) + sizeof(std::uint64_t)) {
+    throw std::runtime_error("RunCheckpoint: truncated file " + path);
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion ||
+      header.valuesPerBlock != GreeksEngine::kBlockSumValues) {
+    throw std::runtime_error("RunCheckpoint: not a checkpoint: " + path);
+  }
+  // Bounded by the file size before any multiplication: the counts are
+  // read from the file.
+  const std::size_t blockBytes = GreeksEngine::kBlockSumValues * sizeof(double);
+  const std::size_t bodyBytes =
+      bytes.size() - sizeof(header) - sizeof(std::uint64_t);
+  if (header.completedBlocks > header.totalBlocks ||
+      header.completedBlocks > bodyBytes / blockBytes ||
+      header.completedBlocks * blockBytes != bodyBytes) {
+    throw std::runtime_error("RunCheckpoint: truncated file " + path);
+  }
+  const std::size_t sumSize = header.completedBlocks * blockBytes;
+  std::uint64_t checksum;
+  std::memcpy(&checksum, bytes.data() + sizeof(header) + sumSize,
+              sizeof(checksum));
+  if (checksum != fnv1a(bytes.data(), sizeof(header) + sumSize)) {
+    throw std::runtime_error("RunCheckpoint: checksum mismatch in " + path);
+  }
+  checkpoint.fingerprint = header.fingerprint;
+  checkpoint.totalBlocks = header.totalBlocks;
+  checkpoint.sums.resize(sumSize / sizeof(double));
+  std::memcpy(checkpoint.sums.data(), bytes.data() + sizeof(header), sumSize);
+  return true;
+}
+
+std::uint64_t runFingerprint(const PricingInputs &inputs) {
+  const std::string text = pricingInputsToJson(inputs).dump();
+  return fnv1a(text.data(), text.size());
+}
+
+PricingResults priceAutocallCheckpointed(const PricingInputs &inputs,
+                                         const CheckpointOptions &options) {
+  if (!isShardable(inputs)) {
+    return priceAutocall(inputs);
+  }
+  RunCheckpoint checkpoint;
+  checkpoint.fingerprint = runFingerprint(inputs);
+  checkpoint.totalBlocks = pathBlockCount(inputs.paths);
+
+  RunCheckpoint saved;
+  if (options.resume && readCheckpoint(options.path, saved)) {
+    if (saved.fingerprint != checkpoint.fingerprint ||
+        saved.totalBlocks != checkpoint.totalBlocks) {
+      throw std::runtime_error("RunCheckpoint: " + options.path +
+                               " belongs to another run");
+    }
+    checkpoint.sums = std::move(saved.sums);
+  }
+  checkpoint.sums.reserve(checkpoint.totalBlocks *
+                          GreeksEngine::kBlockSumValues);
+
+  const AutocallBlockRun run(inputs);
+  const std::size_t chunk = workerCount() * kChunkBlocksPerThread;
+  auto lastSave = std::chrono::steady_clock::now();
+  bool dirty = false;
+  while (checkpoint.completedBlocks() < checkpoint.totalBlocks) {
+    const std::size_t first = checkpoint.completedBlocks();
+    const std::size_t last =
+        std::min<std::size_t>(checkpoint.totalBlocks, first + chunk);
+    const std::vector<double> sums = run.blockSums(first, last);
+    checkpoint.sums.insert(checkpoint.sums.end(), sums.begin(), sums.end());
+    dirty = true;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - lastSave >= options.interval) {
+      writeCheckpoint(options.path, checkpoint);
+      lastSave = now;
+      dirty = false;
+    }
+  }
+  if (dirty) {
+    // Complete: resuming again returns the results at once.
+    writeCheckpoint(options.path, checkpoint);
+  }
+  return run.results(checkpoint.sums);
+}
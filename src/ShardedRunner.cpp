@@ -0,0 +1,258 @@
+#include "ShardedRunner.hpp"
+
+#include "GreeksEngine.hpp"
+#include "Json.hpp"
+#include "PathModel.hpp"
+#include "PricingJson.hpp"
+#include "StreamSocket.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+// Reply tags: block sums, or the error message of the shard.
+constexpr char kSumsReply = 'S';
+constexpr char kErrorReply = 'E';
+constexpr std::size_t kMaxRequestBytes = std::size_t{16} << 20;
+constexpr std::size_t kMaxErrorBytes = std::size_t{64} << 10;
+
+// Doubles as little-endian IEEE bit patterns: exact, whatever the hosts.
+void appendDoubles(const std::vector<double> &values, std::string &out) {
+  out.reserve(out.size() + 8 * values.size());
+  for (double value : values) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int byte = 0; byte < 8; ++byte) {
+      out.push_back(static_cast<char>((bits >> (8 * byte)) & 0xFF));
+    }
+  }
+}
+
+void readDoubles(const char *data, std::size_t count, double *out) {
+  for (std::size_t k = 0; k < count; ++k) {
+    std::uint64_t bits = 0;
+    for (int byte = 7; byte >= 0; --byte) {
+      bits = (bits << 8) | static_cast<unsigned char>(data[8 * k + byte]);
+    }
+    std::memcpy(out + k, &bits, sizeof(bits));
+  }
+}
+
+std::size_t blockIndex(const JsonValue *value, const char *name) {
+  if (!value || !value->isNumber() || !(value->asNumber() >= 0.0) ||
+      value->asNumber() != std::floor(value->asNumber()) ||
+      value->asNumber() > 9.0e15) {
+    throw std::runtime_error(std::string("ShardedRunner: ") + name +
+                             " must be a non-negative integer");
+  }
+  return static_cast<std::size_t>(value->asNumber());
+}
+
+// Connections to the workers of one run; closing them ends the local ones.
+struct WorkerSet {
+  WorkerSet() = default;
+  WorkerSet(const WorkerSet &) = delete;
+  WorkerSet &operator=(const WorkerSet &) = delete;
+  ~WorkerSet() {
+    for (int fd : fds) {
+      ::close(fd);
+    }
+    for (pid_t child : children) {
+      int status = 0;
+      ::waitpid(child, &status, 0);
+    }
+  }
+
+  std::vector<int> fds;
+  std::vector<pid_t> children;
+};
+
+// Starts `program --stdin` on one end of a socket pair per worker. Both
+// ends are close-on-exec, so a worker inherits its own end only (as its
+// standard input) and sees the end of stream when the run closes the other.
+void spawnLocalWorkers(std::size_t count, const std::string &program,
+                       WorkerSet &workers) {
+  std::string name = program;
+  std::string flag = "--stdin";
+  char *argv[] = {&name[0], &flag[0], nullptr};
+  for (std::size_t w = 0; w < count; ++w) {
+    int pair[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) {
+      continue; // One worker fewer.
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pair[1], STDIN_FILENO);
+    pid_t child = 0;
+    const int spawned = ::posix_spawnp(&child, program.c_str(), &actions,
+                                       nullptr, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    ::close(pair[1]);
+    if (spawned != 0) {
+      ::close(pair[0]);
+      continue;
+    }
+    workers.fds.push_back(pair[0]);
+    workers.children.push_back(child);
+  }
+}
+
+// Shards not yet assigned, shared by the connections of one run.
+struct ShardQueue {
+  std::mutex mutex;
+  std::deque<std::size_t> pending;
+  std::exception_ptr error;
+};
+} // namespace
+
+PricingResults priceAutocallSharded(const PricingInputs &inputs,
+                                    const ShardOptions &options) {
+  if (!isShardable(inputs)) {
+    return priceAutocall(inputs);
+  }
+  const std::size_t blocks = pathBlockCount(inputs.paths);
+  const std::size_t perShard = std::max<std::size_t>(1, options.blocksPerShard);
+  const std::size_t shards = (blocks + perShard - 1) / perShard;
+  auto firstBlock = [&](std::size_t s) { return s * perShard; };
+  auto lastBlock = [&](std::size_t s) {
+    return std::min(blocks, (s + 1) * perShard);
+  };
+
+  std::vector<double> sums(blocks * GreeksEngine::kBlockSumValues);
+  ShardQueue queue;
+  for (std::size_t s = 0; s < shards; ++s) {
+    queue.pending.push_back(s);
+  }
+  // The request of shard s is this text with its block range appended.
+  const std::string request = "{\"inputs\":" +
+                              pricingInputsToJson(inputs).dump() +
+                              ",\"firstBlock\":";
+
+  WorkerSet workers;
+  spawnLocalWorkers(options.localWorkers, options.workerProgram, workers);
+  for (const auto &address : options.workers) {
+    try {
+      workers.fds.push_back(connectStream(address));
+    } catch (const std::runtime_error &) {
+      // Unreachable: its shards go to the other workers.
+    }
+  }
+
+  auto serveWorker = [&](int fd) {
+    setReceiveTimeout(fd, options.shardTimeout);
+    std::string frame, reply, buffer;
+    for (;;) {
+      std::size_t s;
+      {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.error || queue.pending.empty()) {
+          return;
+        }
+        s = queue.pending.front();
+        queue.pending.pop_front();
+      }
+      const std::size_t count =
+          (lastBlock(s) - firstBlock(s)) * GreeksEngine::kBlockSumValues;
+      frame = request + std::to_string(firstBlock(s)) +
+              ",\"lastBlock\":" + std::to_string(lastBlock(s)) + "}";
+      const bool answered =
+          writeFrame(fd, frame, buffer) &&
+          readFrame(fd, reply, std::max(1 + 8 * count, kMaxErrorBytes)) ==
+              FrameRead::Ok &&
+          !reply.empty();
+      if (!answered) {
+        // Worker lost: the shard is reissued to another one.
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pending.push_back(s);
+        return;
+      }
+      if (reply[0] != kSumsReply || reply.size() != 1 + 8 * count) {
+        const std::string message =
+            reply[0] == kErrorReply ? reply.substr(1)
+                                    : "ShardedRunner: malformed shard reply";
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.error) {
+          queue.error = std::make_exception_ptr(std::runtime_error(message));
+        }
+        return;
+      }
+      readDoubles(reply.data() + 1, count,
+                  sums.data() + firstBlock(s) * GreeksEngine::kBlockSumValues);
+    }
+  };
+  std::vector<std::thread> connections;
+  connections.reserve(workers.fds.size());
+  for (int fd : workers.fds) {
+    connections.emplace_back(serveWorker, fd);
+  }
+  for (auto &connection : connections) {
+    connection.join();
+  }
+  if (queue.error) {
+    std::rethrow_exception(queue.error);
+  }
+
+  // Shards left without any worker, on one run built for all of them.
+  if (queue.pending.empty()) {
+    return autocallFromBlockSums(inputs, sums);
+  }
+  const AutocallBlockRun run(inputs);
+  for (std::size_t s : queue.pending) {
+    const std::vector<double> local =
+        run.blockSums(firstBlock(s), lastBlock(s));
+    std::copy(local.begin(), local.end(),
+              sums.begin() + firstBlock(s) * GreeksEngine::kBlockSumValues);
+  }
+  return run.results(sums);
+}
+
+void serveShards(int fd) {
+  std::string request, reply, buffer;
+  for (;;) {
+    const FrameRead read = readFrame(fd, request, kMaxRequestBytes);
+    reply.clear();
+    if (read == FrameRead::TooLarge) {
+      reply.push_back(kErrorReply);
+      reply += "ShardedRunner: shard request too large";
+      writeFrame(fd, reply, buffer);
+    }
+    if (read != FrameRead::Ok) {
+      return;
+    }
+    try {
+      const JsonValue document = JsonValue::parse(request);
+      const JsonValue *inputs = document.find("inputs");
+      if (!inputs) {
+        throw std::runtime_error("ShardedRunner: shard request without "
+                                 "inputs");
+      }
+      const std::vector<double> sums = autocallBlockSums(
+          pricingInputsFromJson(*inputs),
+          blockIndex(document.find("firstBlock"), "firstBlock"),
+          blockIndex(document.find("lastBlock"), "lastBlock"));
+      reply.push_back(kSumsReply);
+      appendDoubles(sums, reply);
+    } catch (const std::exception &ex) {
+      reply.assign(1, kErrorReply);
+      reply += ex.what();
+    }
+    if (!writeFrame(fd, reply, buffer)) {
+      return;
+    }
+  }
+}
@@ -10,8 +10,8 @@ SimpleAutocall::SimpleAutocall(std::string underlying,
     : AutocallBase(std::move(underlying), std::move(observationTimes), spot0,
                    notional, couponRate, callBarrier, protectionBarrier) {}
 
-double SimpleAutocall::discountedPayoff(const std::vector<double> &path,
-                                        double riskFreeRate) const {
+double SimpleAutocall::payoff(PathView path, const double *discountFactors,
+                              LifeEvents *events) const {
   const auto &obs = times();
   const std::size_t steps = std::min(path.size(), obs.size());
 
@@ -19,11 +19,16 @@ double SimpleAutocall::discountedPayoff(const std::vector<double> &path,
     if (path[i] >= callBarrier()) {
       // Autocall : Nominal + Coupon
       double amount = notional() * (1.0 + couponRate());
-      return amount * std::exp(-riskFreeRate * obs[i]);
+      if (events) {
+        events->called(i);
+      }
+      return amount * discountFactors[i];
     }
   }
 
-  const double finalSpot = (steps > 0) ? path[steps - 1] : spot0();
-  double amount = terminalRedemption(finalSpot);
-  return amount * std::exp(-riskFreeRate * obs.back());
+  if (events) {
+    events->matured();
+  }
+  double amount = maturityRedemption(path);
+  return amount * discountFactors[obs.size() - 1];
 } 
\ No newline at end of file
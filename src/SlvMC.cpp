@@ -0,0 +1,180 @@
+#include "SlvMC.hpp"
+
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+namespace {
+constexpr double kMinLeverage = 0.01;
+constexpr double kMaxLeverage = 10.0;
+constexpr double kMinConditionalVariance = 1e-8;
+
+// One full-truncation Euler step of (x, v) with leverage lev.
+inline void slvStep(double &x, double &v, double lev, double h, double sqrtH,
+                    const HestonParameters &p, double rhoBar, double z1,
+                    double z2) {
+  const double vPlus = std::max(v, 0.0);
+  const double sqrtV = std::sqrt(vPlus);
+  const double zv = p.rho * z1 + rhoBar * z2;
+  x += -0.5 * lev * lev * vPlus * h + lev * sqrtV * sqrtH * z1;
+  v += p.kappa * (p.theta - vPlus) * h + p.xi * sqrtV * sqrtH * zv;
+}
+} // namespace
+
+SlvLeverage::SlvLeverage(const ImpliedVolSurface &surface,
+                         const HestonParameters &heston,
+                         const SlvSettings &settings)
+    : heston_(heston), stepsPerYear_(settings.stepsPerYear) {
+  const LocalVolTable localVol(surface, settings.localVol);
+  const UniformTable &lvGrid = localVol.grid();
+
+  const double horizon = surface.lastExpiry();
+  const std::size_t steps = std::max<std::size_t>(
+      1, static_cast<std::size_t>(std::ceil(horizon * stepsPerYear_)));
+  const std::size_t cols = std::max<std::size_t>(3, settings.logSpotNodes);
+  table_ = UniformTable(horizon, steps + 1, lvGrid.colX(0),
+                        lvGrid.colX(lvGrid.cols() - 1), cols);
+
+  const double h = horizon / static_cast<double>(steps);
+  const double sqrtH = std::sqrt(h);
+  const double rhoBar = std::sqrt(1.0 - heston.rho * heston.rho);
+  const std::size_t particles = std::max<std::size_t>(1, settings.particles);
+  const std::size_t chunks = pathBlockCount(particles);
+
+  std::vector<double> xs(particles, 0.0);
+  std::vector<double> vs(particles, heston.v0);
+  std::vector<std::mt19937> rngs;
+  rngs.reserve(chunks);
+  for (std::size_t c = 0; c < chunks; ++c) {
+    rngs.push_back(pathBlockRng(settings.seed, c));
+  }
+
+  // Per-chunk bin statistics, merged in chunk order.
+  std::vector<double> sums(chunks * cols);
+  std::vector<double> counts(chunks * cols);
+  std::vector<double> conditional(cols);
+  std::vector<char> valid(cols);
+
+  for (std::size_t k = 0; k <= steps; ++k) {
+    const double t = static_cast<double>(k) * h;
+
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(counts.begin(), counts.end(), 0.0);
+    parallelFor(chunks, [&](std::size_t c) {
+      double *sum = sums.data() + c * cols;
+      double *count = counts.data() + c * cols;
+      for (std::size_t p = c * kPathsPerBlock; p < pathBlockEnd(c, particles);
+           ++p) {
+        const std::size_t col = table_.nearestCol(xs[p]);
+        sum[col] += std::max(vs[p], 0.0);
+        count[col] += 1.0;
+      }
+    });
+
+    double totalSum = 0.0;
+    double totalCount = 0.0;
+    for (std::size_t col = 0; col < cols; ++col) {
+      double sum = 0.0;
+      double count = 0.0;
+      for (std::size_t c = 0; c < chunks; ++c) {
+        sum += sums[c * cols + col];
+        count += counts[c * cols + col];
+      }
+      totalSum += sum;
+      totalCount += count;
+      valid[col] = count >= static_cast<double>(settings.minParticlesPerBin);
+      conditional[col] = count > 0.0 ? sum / count : 0.0;
+    }
+
+    // Sparse bins (tails, early steps) take the nearest populated bin, or
+    // the population mean when no bin is populated enough.
+    const double mean = totalCount > 0.0 ? totalSum / totalCount : heston.v0;
+    for (std::size_t col = 0; col < cols; ++col) {
+      if (valid[col]) {
+        continue;
+      }
+      std::size_t best = cols;
+      for (std::size_t d = 1; d < cols && best == cols; ++d) {
+        if (col >= d && valid[col - d]) {
+          best = col - d;
+        } else if (col + d < cols && valid[col + d]) {
+          best = col + d;
+        }
+      }
+      conditional[col] = best == cols ? mean : conditional[best];
+    }
+    for (std::size_t col = 0; col < cols; ++col) {
+      const double sigma = localVol.volatility(t, table_.colX(col));
+      const double ev = std::max(conditional[col], kMinConditionalVariance);
+      table_.at(k, col) =
+          std::clamp(sigma / std::sqrt(ev), kMinLeverage, kMaxLeverage);
+    }
+
+    if (k == steps) {
+      break;
+    }
+    parallelFor(chunks, [&](std::size_t c) {
+      std::mt19937 &rng = rngs[c];
+      std::normal_distribution<double> dist(0.0, 1.0);
+      for (std::size_t p = c * kPathsPerBlock; p < pathBlockEnd(c, particles);
+           ++p) {
+        const double lev = table_.rowValue(k, xs[p]);
+        const double z1 = dist(rng);
+        const double z2 = dist(rng);
+        slvStep(xs[p], vs[p], lev, h, sqrtH, heston_, rhoBar, z1, z2);
+      }
+    });
+  }
+}
+
+SlvMC::SlvMC(std::shared_ptr<const SlvLeverage> leverage)
+    : leverage_(std::move(leverage)) {}
+
+std::size_t SlvMC::normalCount(const TimeGrid &grid) const {
+  std::size_t count = 0;
+  for (double dt : grid.dt) {
+    count += 2 * subStepCount(dt, leverage_->stepsPerYear());
+  }
+  return count;
+}
+
+void SlvMC::buildPath(double spot0, const TimeGrid &grid,
+                      const double *normals, std::vector<double> &path,
+                      double *intervalVariance) const {
+  const SlvLeverage &leverage = *leverage_;
+  const HestonParameters &p = leverage.heston();
+  const double rhoBar = std::sqrt(1.0 - p.rho * p.rho);
+  const std::size_t n = grid.times.size();
+  path.resize(n);
+
+  double x = 0.0;          // log(S_t / F(t))
+  double v = p.v0;
+  double logForward = 0.0; // log(F(t) / S_0)
+  double t = 0.0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const double dt = grid.dt[i];
+    const std::size_t steps = subStepCount(dt, leverage.stepsPerYear());
+    double integratedVariance = 0.0;
+    if (steps > 0) {
+      const double h = dt / static_cast<double>(steps);
+      const double sqrtH = std::sqrt(h);
+      for (std::size_t s = 0; s < steps; ++s) {
+        const double lev = leverage(t, x);
+        const double z1 = *normals++;
+        const double z2 = *normals++;
+        integratedVariance += lev * lev * std::max(v, 0.0) * h;
+        slvStep(x, v, lev, h, sqrtH, p, rhoBar, z1, z2);
+        t += h;
+      }
+    }
+    if (intervalVariance) {
+      intervalVariance[i] = integratedVariance;
+    }
+    t = grid.times[i];
+    logForward += grid.logGrowth[i];
+    path[i] = spot0 * std::exp(logForward + x);
+  }
+}
@@ -14,8 +14,8 @@ StepDownAutocall::StepDownAutocall(std::string underlying,
                    protectionBarrier),
       callBarriers_(std::move(callBarriers)) {}
 
-double StepDownAutocall::discountedPayoff(const std::vector<double> &path,
-                                          double riskFreeRate) const {
+double StepDownAutocall::payoff(PathView path, const double *discountFactors,
+                                LifeEvents *events) const {
   const auto &obs = times();
   const std::size_t steps = std::min(path.size(), obs.size());
 
@@ -27,11 +27,25 @@ double StepDownAutocall::discountedPayoff(const std::vector<double> &path,
 
     if (path[i] >= currentBarrier) {
       double amount = notional() * (1.0 + couponRate());
-      return amount * std::exp(-riskFreeRate * obs[i]);
+      if (events) {
+        events->called(i);
+      }
+      return amount * discountFactors[i];
     }
   }
 
-  const double finalSpot = (steps > 0) ? path[steps - 1] : spot0();
-  double amount = terminalRedemption(finalSpot);
-  return amount * std::exp(-riskFreeRate * obs.back());
-}
\ No newline at end of file
+  if (events) {
+    events->matured();
+  }
+  double amount = maturityRedemption(path);
+  return amount * discountFactors[obs.size() - 1];
+}
+
+AutocallBase::ObservationRule
+StepDownAutocall::observationRule(std::size_t i) const {
+  ObservationRule rule = AutocallBase::observationRule(i);
+  if (!callBarriers_.empty()) {
+    rule.callBarrier = callBarriers_[std::min(i, callBarriers_.size() - 1)];
+  }
+  return rule;
+}
@@ -0,0 +1,194 @@
+#include "StreamSocket.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+[[noreturn]] void failErrno(const std::string &what) {
+  throw std::runtime_error("Socket: " + what + ": " + std::strerror(errno));
+}
+
+bool isUnixPath(const std::string &address) {
+  return address.find('/') != std::string::npos;
+}
+
+sockaddr_un unixAddress(const std::string &path) {
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket: path too long: " + path);
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+// Resolved "host:port" (IPv4 or IPv6), to be released with freeaddrinfo.
+addrinfo *resolve(const std::string &address, bool passive) {
+  const auto colon = address.rfind(':');
+  if (colon == std::string::npos || colon == 0 ||
+      colon + 1 == address.size()) {
+    throw std::runtime_error("Socket: expected host:port or a path, got " +
+                             address);
+  }
+  const std::string host = address.substr(0, colon);
+  const std::string port = address.substr(colon + 1);
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  addrinfo *found = nullptr;
+  const int status = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+  if (status != 0) {
+    throw std::runtime_error("Socket: cannot resolve " + address + ": " +
+                             ::gai_strerror(status));
+  }
+  return found;
+}
+
+// Closes fd and throws the error of `what`, errno preserved.
+[[noreturn]] void closeAndFail(int fd, const std::string &what) {
+  const int error = errno;
+  ::close(fd);
+  errno = error;
+  failErrno(what);
+}
+
+bool readExact(int fd, char *data, std::size_t size) {
+  while (size > 0) {
+    const ssize_t got = ::recv(fd, data, size, 0);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      return false;
+    }
+    data += got;
+    size -= static_cast<std::size_t>(got);
+  }
+  return true;
+}
+} // namespace
+
+int listenStream(const std::string &address) {
+  int fd = -1;
+  if (isUnixPath(address)) {
+    const sockaddr_un path = unixAddress(address);
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      failErrno("socket");
+    }
+    ::unlink(address.c_str()); // Left behind by a previous run.
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&path), sizeof(path)) !=
+        0) {
+      closeAndFail(fd, "bind " + address);
+    }
+  } else {
+    addrinfo *found = resolve(address, true);
+    fd = ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (fd < 0) {
+      ::freeaddrinfo(found);
+      failErrno("socket");
+    }
+    const int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    const int status = ::bind(fd, found->ai_addr, found->ai_addrlen);
+    ::freeaddrinfo(found);
+    if (status != 0) {
+      closeAndFail(fd, "bind " + address);
+    }
+  }
+  if (::listen(fd, SOMAXCONN) != 0) {
+    closeAndFail(fd, "listen " + address);
+  }
+  return fd;
+}
+
+int connectStream(const std::string &address) {
+  if (isUnixPath(address)) {
+    const sockaddr_un path = unixAddress(address);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      failErrno("socket");
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&path),
+                  sizeof(path)) != 0) {
+      closeAndFail(fd, "connect " + address);
+    }
+    return fd;
+  }
+  addrinfo *found = resolve(address, false);
+  const int fd =
+      ::socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+  if (fd < 0) {
+    ::freeaddrinfo(found);
+    failErrno("socket");
+  }
+  const int status = ::connect(fd, found->ai_addr, found->ai_addrlen);
+  ::freeaddrinfo(found);
+  if (status != 0) {
+    closeAndFail(fd, "connect " + address);
+  }
+  return fd;
+}
+
+void setReceiveTimeout(int fd, std::chrono::milliseconds timeout) {
+  timeval value{};
+  value.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+  value.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+}
+
+FrameRead readFrame(int fd, std::string &payload, std::size_t maxBytes) {
+  unsigned char header[4];
+  if (!readExact(fd, reinterpret_cast<char *>(header), sizeof(header))) {
+    return FrameRead::Closed;
+  }
+  const std::uint32_t length = (std::uint32_t{header[0]} << 24) |
+                               (std::uint32_t{header[1]} << 16) |
+                               (std::uint32_t{header[2]} << 8) |
+                               std::uint32_t{header[3]};
+  if (length > maxBytes) {
+    return FrameRead::TooLarge;
+  }
+  payload.resize(length);
+  if (!readExact(fd, &payload[0], length)) {
+    return FrameRead::Closed;
+  }
+  return FrameRead::Ok;
+}
+
+bool writeFrame(int fd, const std::string &payload, std::string &buffer) {
+  if (payload.size() > 0xFFFFFFFFu) {
+    return false;
+  }
+  const auto length = static_cast<std::uint32_t>(payload.size());
+  buffer.clear();
+  buffer.push_back(static_cast<char>((length >> 24) & 0xFF));
+  buffer.push_back(static_cast<char>((length >> 16) & 0xFF));
+  buffer.push_back(static_cast<char>((length >> 8) & 0xFF));
+  buffer.push_back(static_cast<char>(length & 0xFF));
+  buffer += payload;
+
+  const char *data = buffer.data();
+  std::size_t size = buffer.size();
+  while (size > 0) {
+    const ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    size -= static_cast<std::size_t>(sent);
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+#include "SymbolTable.hpp"
+
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+struct SymbolTable {
+    std::mutex mutex;
+    std::unordered_map<std::string, SymbolId> ids;
+    std::deque<std::string> names; // Indexed by ID.
+};
+
+SymbolTable& table() {
+    static SymbolTable instance;
+    return instance;
+}
+} // namespace
+
+SymbolId internSymbol(const std::string& name) {
+    SymbolTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    auto it = t.ids.find(name);
+    if (it != t.ids.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<SymbolId>(t.names.size());
+    t.names.push_back(name);
+    t.ids.emplace(name, id);
+    return id;
+}
+
+std::string symbolName(SymbolId id) {
+    SymbolTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    if (id >= t.names.size()) {
+        throw std::runtime_error("SymbolTable: unknown symbol id");
+    }
+    return t.names[id];
+}
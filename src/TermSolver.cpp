@@ -0,0 +1,167 @@
+#include "TermSolver.hpp"
+
+#include "PathModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+constexpr int kMaxIterations = 100;
+// Bracket width, relative to the level, at which the search stops.
+constexpr double kLevelTolerance = 1e-7;
+} // namespace
+
+TermSolver::TermSolver(const PricingInputs &inputs)
+    : inputs_(inputs), curve_(makeDiscountCurve(inputs)) {
+  if (inputs.productFamily != ProductFamily::Autocall) {
+    throw std::runtime_error("TermSolver: autocalls only");
+  }
+  if (!inputs.termSheet.empty()) {
+    throw std::runtime_error("TermSolver: term sheets are not supported");
+  }
+  if (!inputs.basket.empty()) {
+    throw std::runtime_error("TermSolver: worst-of notes are not supported");
+  }
+  if (inputs.issuerCallable) {
+    throw std::runtime_error(
+        "TermSolver: issuer-callable notes are not supported");
+  }
+  if (makeProduct(inputs)->needsBridge()) {
+    // Cached shapes do not keep the interval variances.
+    throw std::runtime_error("TermSolver: the protection barrier can only be "
+                             "monitored at maturity");
+  }
+  // The spot never moves, so the cached paths are exact for every model.
+  auto model = makePathModel(inputs);
+  cache_ = std::make_unique<PathCache>(*model, inputs.observationTimes,
+                                       inputs.spot, curve_, inputs.paths,
+                                       inputs.seed);
+}
+
+PricingInputs TermSolver::withLevel(SolveTarget target, double level) const {
+  PricingInputs terms = inputs_;
+  switch (target) {
+  case SolveTarget::Coupon:
+    terms.coupon = level;
+    break;
+  case SolveTarget::CallBarrier: {
+    const double shift = level - inputs_.autocallBarrier;
+    terms.autocallBarrier = level;
+    for (double &barrier : terms.callBarriers) {
+      barrier += shift;
+    }
+    break;
+  }
+  case SolveTarget::ProtectionBarrier:
+    terms.protectionBarrier = level;
+    break;
+  case SolveTarget::AirbagFloor:
+    if (inputs_.autocallType != AutocallType::Airbag) {
+      throw std::runtime_error("TermSolver: only Airbag autocalls have a "
+                               "floor");
+    }
+    terms.airbagFloor = level;
+    break;
+  }
+  return terms;
+}
+
+double TermSolver::price(SolveTarget target, double level,
+                         double &stdError) const {
+  const auto product = makeProduct(withLevel(target, level));
+  return cache_->price(*product, inputs_.spot, curve_, stdError);
+}
+
+SolveResult TermSolver::solve(SolveTarget target, double targetPrice,
+                              double lower, double upper) const {
+  if (target == SolveTarget::Coupon) {
+    return solveCoupon(targetPrice);
+  }
+  return solveBracketed(target, targetPrice, lower, upper);
+}
+
+SolveResult TermSolver::solveCoupon(double targetPrice) const {
+  double stdError = 0.0;
+  const double fixedLeg = price(SolveTarget::Coupon, 0.0, stdError);
+  const double couponLeg =
+      price(SolveTarget::Coupon, 1.0, stdError) - fixedLeg;
+  if (couponLeg == 0.0) {
+    throw std::runtime_error("TermSolver: the coupon does not move the price");
+  }
+
+  SolveResult result;
+  result.level = (targetPrice - fixedLeg) / couponLeg;
+  result.price = price(SolveTarget::Coupon, result.level, result.priceStdError);
+  // dV/dc = couponLeg exactly, path by path.
+  result.stdError = result.priceStdError / std::abs(couponLeg);
+  result.evaluations = 3;
+  return result;
+}
+
+SolveResult TermSolver::solveBracketed(SolveTarget target, double targetPrice,
+                                       double lower, double upper) const {
+  SolveResult result;
+  double stdError = 0.0;
+  auto gap = [&](double level) {
+    ++result.evaluations;
+    return price(target, level, stdError) - targetPrice;
+  };
+
+  double a = lower;
+  double b = upper;
+  double fa = gap(a);
+  double fb = gap(b);
+  if (fa * fb > 0.0) {
+    throw std::runtime_error("TermSolver: the target price is not bracketed "
+                             "by [lower, upper]");
+  }
+  const double tolerance =
+      kLevelTolerance * std::max({std::abs(a), std::abs(b), 1.0});
+
+  // Illinois: regula falsi that halves the stale end's value so that the
+  // bracket shrinks from both sides, also across a price jump.
+  int side = 0;
+  for (int iteration = 0;
+       iteration < kMaxIterations && std::abs(b - a) > tolerance;
+       ++iteration) {
+    double c = fb != fa ? (a * fb - b * fa) / (fb - fa) : 0.5 * (a + b);
+    if (!(c > std::min(a, b) && c < std::max(a, b))) {
+      c = 0.5 * (a + b);
+    }
+    const double fc = gap(c);
+    if (fc == 0.0) {
+      a = b = c;
+      break;
+    }
+    if (fc * fb > 0.0) {
+      b = c;
+      fb = fc;
+      if (side == -1) {
+        fa *= 0.5;
+      }
+      side = -1;
+    } else {
+      a = c;
+      fa = fc;
+      if (side == 1) {
+        fb *= 0.5;
+      }
+      side = 1;
+    }
+  }
+
+  result.level = 0.5 * (a + b);
+  result.price = price(target, result.level, result.priceStdError);
+  const double h =
+      kSlopeBumpFraction * (result.level != 0.0 ? std::abs(result.level) : 1.0);
+  const double slope = (price(target, result.level + h, stdError) -
+                        price(target, result.level - h, stdError)) /
+                       (2.0 * h);
+  result.evaluations += 3;
+  result.stdError = slope != 0.0
+                        ? result.priceStdError / std::abs(slope)
+                        : std::numeric_limits<double>::infinity();
+  return result;
+}
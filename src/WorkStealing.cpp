@@ -0,0 +1,156 @@
+#include "WorkStealing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <numeric>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Tasks of one worker. The owner pops from the front, thieves from the back.
+struct TaskDeque {
+  std::mutex mutex;
+  std::deque<std::size_t> tasks;
+  double cost{}; // Estimated cost of the tasks left.
+
+  bool popFront(const std::vector<double> &costs, std::size_t &task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tasks.empty()) {
+      return false;
+    }
+    task = tasks.front();
+    tasks.pop_front();
+    cost -= costs[task];
+    return true;
+  }
+
+  bool popBack(const std::vector<double> &costs, std::size_t &task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tasks.empty()) {
+      return false;
+    }
+    task = tasks.back();
+    tasks.pop_back();
+    cost -= costs[task];
+    return true;
+  }
+
+  // Estimated cost left, negative when there is no task left.
+  double remaining() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.empty() ? -1.0 : cost;
+  }
+};
+} // namespace
+
+double SchedulerStats::utilisation() const {
+  if (workers.empty() || wallSeconds <= 0.0) {
+    return 1.0;
+  }
+  double busy = 0.0;
+  for (const WorkerStats &worker : workers) {
+    busy += worker.busySeconds;
+  }
+  return busy / (wallSeconds * static_cast<double>(workers.size()));
+}
+
+SchedulerStats runWorkStealing(const std::vector<double> &costs,
+                               const std::function<void(std::size_t)> &task,
+                               std::size_t threads) {
+  const auto start = Clock::now();
+  const std::size_t count = costs.size();
+  // Inside another parallel loop, the caller runs every deque itself.
+  const bool nested = insideParallelWorker();
+  threads = nested ? 1 : std::max<std::size_t>(1, std::min(threads, count));
+  SchedulerStats stats;
+  stats.workers.resize(threads);
+
+  // Longest tasks first, each to the least loaded deque (LPT).
+  std::vector<std::size_t> order(count);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](std::size_t a,
+                                                   std::size_t b) {
+    return costs[a] > costs[b];
+  });
+  std::vector<TaskDeque> deques(threads);
+  for (std::size_t i : order) {
+    TaskDeque &target = *std::min_element(
+        deques.begin(), deques.end(),
+        [](const TaskDeque &a, const TaskDeque &b) { return a.cost < b.cost; });
+    target.tasks.push_back(i);
+    target.cost += costs[i];
+  }
+
+  std::atomic<bool> stop{false};
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto worker = [&](std::size_t w) {
+    WorkerStats &own = stats.workers[w];
+    std::vector<std::size_t> victims;
+    std::vector<double> left(threads);
+    while (!stop) {
+      std::size_t i;
+      bool stolen = false;
+      if (!deques[w].popFront(costs, i)) {
+        // Richest deque first; the estimates may be stale, so fall back on
+        // the others when it was emptied meanwhile.
+        victims.clear();
+        for (std::size_t v = 0; v < threads; ++v) {
+          left[v] = v == w ? -1.0 : deques[v].remaining();
+          if (left[v] >= 0.0) {
+            victims.push_back(v);
+          }
+        }
+        std::sort(victims.begin(), victims.end(),
+                  [&](std::size_t a, std::size_t b) {
+                    return left[a] > left[b];
+                  });
+        for (std::size_t v : victims) {
+          if (deques[v].popBack(costs, i)) {
+            stolen = true;
+            break;
+          }
+        }
+        if (!stolen) {
+          break; // Nothing left anywhere, and no task adds any.
+        }
+      }
+      const auto taskStart = Clock::now();
+      // The workers are the caller and pool threads; a task's own loops
+      // may borrow the pool threads left idle (see InlineParallelLoops).
+      const bool wasInside = insideParallelWorker();
+      insideParallelWorker() = nested;
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        stop = true;
+      }
+      insideParallelWorker() = wasInside;
+      own.busySeconds += secondsSince(taskStart);
+      own.cost += costs[i];
+      own.tasks += 1;
+      own.stolen += stolen ? 1 : 0;
+    }
+  };
+
+  // One index per deque. Pool threads busy elsewhere leave theirs to the
+  // caller, whose worker then finds it empty or steals from it.
+  parallelFor(threads, worker);
+  stats.wallSeconds = secondsSince(start);
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return stats;
+}
@@ -0,0 +1,65 @@
+#include "WorstOfProduct.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace {
+std::string basketName(const std::vector<std::string> &assets) {
+  std::string name;
+  for (const auto &asset : assets) {
+    if (!name.empty()) {
+      name += '/';
+    }
+    name += asset;
+  }
+  return name;
+}
+} // namespace
+
+WorstOfProduct::WorstOfProduct(std::unique_ptr<StructuredProduct> product,
+                               std::vector<std::string> assets,
+                               std::vector<double> initialSpots,
+                               double referenceLevel)
+    : StructuredProduct(basketName(assets), product->observationTimes()),
+      product_(std::move(product)), assets_(std::move(assets)) {
+  if (assets_.empty() || initialSpots.size() != assets_.size()) {
+    throw std::runtime_error("WorstOf: one initial spot per asset is required");
+  }
+  assetIds_.reserve(assets_.size());
+  for (const auto &asset : assets_) {
+    assetIds_.push_back(internSymbol(asset));
+  }
+  inverseFixings_.reserve(initialSpots.size());
+  for (double fixing : initialSpots) {
+    if (fixing <= 0.0) {
+      throw std::runtime_error("WorstOf: initial spots must be positive");
+    }
+    inverseFixings_.push_back(referenceLevel / fixing);
+  }
+}
+
+double WorstOfProduct::discountedPayoff(PathView path,
+                                        const double *discountFactors) const {
+  const std::size_t n = assets_.size();
+  const std::size_t dates = path.size() / n;
+  if (dates * n != path.size()) {
+    throw std::runtime_error("WorstOf: path does not match the basket size");
+  }
+
+  // Reused per thread: no allocation once the first path has been priced.
+  thread_local std::vector<double> worst;
+  worst.resize(dates);
+  const double *row = path.data();
+  for (std::size_t i = 0; i < dates; ++i, row += n) {
+    double level = row[0] * inverseFixings_[0];
+    for (std::size_t a = 1; a < n; ++a) {
+      const double candidate = row[a] * inverseFixings_[a];
+      if (candidate < level) {
+        level = candidate;
+      }
+    }
+    worst[i] = level;
+  }
+  return product_->discountedPayoff(PathView(worst.data(), dates),
+                                    discountFactors);
+}